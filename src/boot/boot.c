@@ -22,7 +22,8 @@ static io32_t *boot_get_device_base (boot_params_t *params) {
     return device_base_address;
 }
 
-static void boot_detect_cic_seed (boot_params_t *params) {
+
+void boot_detect_cic_seed (boot_params_t *params) {
     io32_t *base = boot_get_device_base(params);
 
     uint8_t ipl3[IPL3_LENGTH] __attribute__((aligned(8)));
@@ -34,7 +35,6 @@ static void boot_detect_cic_seed (boot_params_t *params) {
     params->cic_seed = cic_get_seed(cic_detect(ipl3));
 }
 
-
 void boot (boot_params_t *params) {
     if (params->tv_type == BOOT_TV_TYPE_PASSTHROUGH) {
         switch (get_tv_type()) {
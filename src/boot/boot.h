@@ -41,6 +41,7 @@ typedef struct {
 } boot_params_t;
 
 
+void boot_detect_cic_seed (boot_params_t *params);
 void boot (boot_params_t *params);
 
 
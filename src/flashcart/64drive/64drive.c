@@ -96,28 +96,40 @@ static flashcart_err_t d64_load_rom (char *rom_path, flashcart_progress_callback
         return FLASHCART_ERR_LOAD;
     }
 
-    size_t sdram_size = MiB(64);
+    load_progress_begin(progress, FLASHCART_LOAD_PHASE_SDRAM, rom_size);
 
-    size_t chunk_size = KiB(128);
-    for (int offset = 0; offset < sdram_size; offset += chunk_size) {
-        size_t block_size = MIN(sdram_size - offset, chunk_size);
-        if (f_read(&fil, (void *) (ROM_ADDRESS + offset), block_size, &br) != FR_OK) {
+    // NOTE: A .v64 ROM arrives with cart_card_byteswap set by flashcart_load_rom(). Every read below goes through
+    //       libcart, whose 64drive driver owns the swap for its own SD to cart transfers. CMD_ID_ENABLE_BYTESWAP_ON_LOAD
+    //       isn't issued from here, the swap mode would then be changed behind libcart in between its CI commands.
+    if (load_file_runs(rom_path, ROM_ADDRESS, rom_size, NULL)) {
+        if (load_progress_cancelled()) {
             f_close(&fil);
-            return FLASHCART_ERR_LOAD;
+            return FLASHCART_ERR_CANCELLED;
         }
-        if (progress) {
-            progress(f_tell(&fil) / (float) (f_size(&fil)));
+        size_t chunk_size = KiB(128);
+        for (int offset = 0; offset < rom_size; offset += chunk_size) {
+            size_t block_size = MIN(rom_size - offset, chunk_size);
+            if (f_read(&fil, (void *) (ROM_ADDRESS + offset), block_size, &br) != FR_OK) {
+                f_close(&fil);
+                return FLASHCART_ERR_LOAD;
+            }
+            if (load_progress_update(f_tell(&fil))) {
+                f_close(&fil);
+                return FLASHCART_ERR_CANCELLED;
+            }
+        }
+        if (f_tell(&fil) != rom_size) {
+            f_close(&fil);
+            return FLASHCART_ERR_LOAD;
         }
-    }
-    if (f_tell(&fil) != rom_size) {
-        f_close(&fil);
-        return FLASHCART_ERR_LOAD;
     }
 
     if (f_close(&fil) != FR_OK) {
         return FLASHCART_ERR_LOAD;
     }
 
+    load_progress_end();
+
     return FLASHCART_OK;
 }
 
@@ -275,6 +287,7 @@ static flashcart_t flashcart_d64 = {
     .load_64dd_disk = NULL,
     .set_save_type = d64_set_save_type,
     .set_save_writeback = d64_set_save_writeback,
+    .reset_rom_mapping = NULL,
 };
 
 
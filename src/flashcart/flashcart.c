@@ -1,20 +1,28 @@
 #include <stddef.h>
 
+#include <fatfs/ff.h>
 #include <libcart/cart.h>
 #include <libdragon.h>
 #include <usb.h>
 
+#include "../menu/rom_pack.h"
 #include "../utils/fs.h"
 #include "../utils/utils.h"
 
 #include "flashcart.h"
+#include "flashcart_pack.h"
+#include "flashcart_utils.h"
 
 #include "64drive/64drive.h"
 #include "sc64/sc64.h"
 
 
+#define ROM_ADDRESS                 (0x10000000)
 #define SAVE_WRITEBACK_MAX_SECTORS  (256)
 
+/** @brief .n64 ROMs are reordered in SDRAM, the SC64 flash backed areas can't be rewritten that way */
+#define N64_ORDER_MAX_ROM_SIZE      (MiB(64) - KiB(128))
+
 
 static const size_t SAVE_SIZE[__FLASHCART_SAVE_TYPE_END] = {
     0,
@@ -28,14 +36,18 @@ static const size_t SAVE_SIZE[__FLASHCART_SAVE_TYPE_END] = {
 };
 
 static uint32_t save_writeback_sectors[SAVE_WRITEBACK_MAX_SECTORS] __attribute__((aligned(8)));
+static flashcart_save_map_t *save_map;
+static bool save_map_overflow;
+static uint8_t rom_order_buffer[KiB(32)] __attribute__((aligned(16)));
+static uint8_t verify_buffers[2][KiB(32)] __attribute__((aligned(16)));
 
 
-static void save_writeback_sectors_callback (uint32_t sector_count, uint32_t file_sector, uint32_t cluster_sector, uint32_t cluster_size) {
-    for (uint32_t i = 0; i < cluster_size; i++) {
+static void save_writeback_sectors_fill (uint32_t sector_count, uint32_t file_sector, uint32_t run_sector, uint32_t run_size) {
+    for (uint32_t i = 0; i < run_size; i++) {
         uint32_t offset = file_sector + i;
-        uint32_t sector = cluster_sector + i;
+        uint32_t sector = run_sector + i;
 
-        if ((offset > SAVE_WRITEBACK_MAX_SECTORS) || (offset > sector_count)) {
+        if ((offset >= SAVE_WRITEBACK_MAX_SECTORS) || (offset >= sector_count)) {
             return;
         }
 
@@ -43,6 +55,61 @@ static void save_writeback_sectors_callback (uint32_t sector_count, uint32_t fil
     }
 }
 
+static bool save_writeback_sectors_callback (uint32_t sector_count, uint32_t file_sector, uint32_t run_sector, uint32_t run_size) {
+    save_writeback_sectors_fill(sector_count, file_sector, run_sector, run_size);
+
+    if ((save_map == NULL) || save_map_overflow) {
+        return false;
+    }
+
+    if (save_map->run_count > 0) {
+        uint32_t last = save_map->run_count - 1;
+        if ((save_map->runs[last].sector + save_map->runs[last].count) == run_sector) {
+            save_map->runs[last].count += run_size;
+            return false;
+        }
+    }
+
+    if (save_map->run_count == FLASHCART_SAVE_MAP_MAX_RUNS) {
+        save_map_overflow = true;
+        return false;
+    }
+
+    save_map->runs[save_map->run_count].sector = run_sector;
+    save_map->runs[save_map->run_count].count = run_size;
+    save_map->run_count += 1;
+
+    return false;
+}
+
+static void save_writeback_sectors_from_map (flashcart_save_map_t *map, uint32_t sector_count) {
+    uint32_t file_sector = 0;
+
+    for (uint32_t i = 0; i < map->run_count; i++) {
+        save_writeback_sectors_fill(sector_count, file_sector, map->runs[i].sector, map->runs[i].count);
+        file_sector += map->runs[i].count;
+    }
+}
+
+// NOTE: No cart reorders 32-bit words while loading, .n64 data is loaded as-is and reordered in place over PI
+static flashcart_err_t swap_rom_words (uint32_t offset, size_t length, size_t *done) {
+    while (length > 0) {
+        size_t block_size = MIN(length, sizeof(rom_order_buffer));
+        pi_dma_read_data((void *) (ROM_ADDRESS + offset), rom_order_buffer, block_size);
+        rom_order_swap_32(rom_order_buffer, block_size);
+        pi_dma_write_data(rom_order_buffer, (void *) (ROM_ADDRESS + offset), block_size);
+        offset += block_size;
+        length -= block_size;
+        if (done != NULL) {
+            *done += block_size;
+            if (load_progress_update(*done)) {
+                return FLASHCART_ERR_CANCELLED;
+            }
+        }
+    }
+
+    return FLASHCART_OK;
+}
 
 static flashcart_err_t dummy_init (void) {
     return FLASHCART_OK;
@@ -56,6 +123,7 @@ static flashcart_t *flashcart = &((flashcart_t) {
     .load_save = NULL,
     .set_save_type = NULL,
     .set_save_writeback = NULL,
+    .reset_rom_mapping = NULL,
 });
 
 #ifdef NDEBUG
@@ -76,6 +144,8 @@ char *flashcart_convert_error_message (flashcart_err_t err) {
         case FLASHCART_ERR_LOAD: return "Error during loading data into flashcart";
         case FLASHCART_ERR_INT: return "Internal flashcart error";
         case FLASHCART_ERR_FUNCTION_NOT_SUPPORTED: return "Flashcart doesn't support this function";
+        case FLASHCART_ERR_CANCELLED: return "Loading was cancelled";
+        case FLASHCART_ERR_VERIFY: return "Loaded ROM doesn't match the file";
         default: return "Unknown flashcart error";
     }
 }
@@ -130,20 +200,253 @@ bool flashcart_has_feature (flashcart_features_t feature) {
     return flashcart->has_feature(feature);
 }
 
-flashcart_err_t flashcart_load_rom (char *rom_path, bool byte_swap, flashcart_progress_callback_t *progress) {
+flashcart_err_t flashcart_load_rom (char *rom_path, rom_order_t order, flashcart_progress_callback_t *progress) {
     flashcart_err_t err;
 
-    if (rom_path == NULL) {
+    if ((rom_path == NULL) || (order >= ROM_ORDER_UNKNOWN)) {
+        return FLASHCART_ERR_ARGS;
+    }
+
+    // NOTE: Containers hold the ROM in native byte order
+    if (rom_pack_is_path(rom_path)) {
+        return (order == ROM_ORDER_Z64) ? flashcart_pack_load(rom_path, progress) : FLASHCART_ERR_ARGS;
+    }
+
+    size_t rom_size = file_get_size(rom_path);
+
+    if ((order == ROM_ORDER_N64) && (rom_size > N64_ORDER_MAX_ROM_SIZE)) {
         return FLASHCART_ERR_ARGS;
     }
 
-    cart_card_byteswap = byte_swap;
+    cart_card_byteswap = (order == ROM_ORDER_V64);
     err = flashcart->load_rom(rom_path, progress);
     cart_card_byteswap = false;
 
+    if ((err == FLASHCART_OK) && (order == ROM_ORDER_N64)) {
+        size_t done = 0;
+        load_progress_begin(progress, FLASHCART_LOAD_PHASE_BYTE_ORDER, rom_size);
+        err = swap_rom_words(0, ALIGN(rom_size, FS_SECTOR_SIZE), &done);
+        if (err == FLASHCART_OK) {
+            load_progress_end();
+        }
+    }
+
     return err;
 }
 
+// NOTE: Only the full load of a backend sets up the mapping of ROMs past SDRAM. Every other load writes
+//       SDRAM only and resets it first, a failed or cancelled large load would otherwise leave flash mapped.
+flashcart_err_t flashcart_reset_rom_mapping (void) {
+    if (flashcart->reset_rom_mapping) {
+        return flashcart->reset_rom_mapping();
+    }
+
+    return FLASHCART_OK;
+}
+
+flashcart_err_t flashcart_load_rom_head (char *rom_path, rom_order_t order, size_t size) {
+    flashcart_err_t err;
+    FIL fil;
+    UINT br;
+    bool error = false;
+
+    if ((rom_path == NULL) || (order >= ROM_ORDER_UNKNOWN) || rom_pack_is_path(rom_path) || ((size % FS_SECTOR_SIZE) != 0)) {
+        return FLASHCART_ERR_ARGS;
+    }
+
+    if ((err = flashcart_reset_rom_mapping()) != FLASHCART_OK) {
+        return err;
+    }
+
+    if (f_open(&fil, strip_sd_prefix(rom_path), FA_READ) != FR_OK) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    fix_file_size(&fil);
+
+    size = MIN(size, f_size(&fil));
+
+    cart_card_byteswap = (order == ROM_ORDER_V64);
+    if ((f_read(&fil, (void *) (ROM_ADDRESS), size, &br) != FR_OK) || (br != size)) {
+        error = true;
+    }
+    cart_card_byteswap = false;
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    if (!error && (order == ROM_ORDER_N64)) {
+        return swap_rom_words(0, size, NULL);
+    }
+
+    return error ? FLASHCART_ERR_LOAD : FLASHCART_OK;
+}
+
+flashcart_err_t flashcart_load_rom_chunks (char *rom_path, rom_order_t order, uint32_t chunk_size, const uint8_t *changed, flashcart_progress_callback_t *progress) {
+    flashcart_err_t err;
+    FIL fil;
+    UINT br;
+    bool error = false;
+
+    if ((rom_path == NULL) || (order >= ROM_ORDER_UNKNOWN) || rom_pack_is_path(rom_path) || (changed == NULL) || (chunk_size == 0) || ((chunk_size % FS_SECTOR_SIZE) != 0)) {
+        return FLASHCART_ERR_ARGS;
+    }
+
+    if ((err = flashcart_reset_rom_mapping()) != FLASHCART_OK) {
+        return err;
+    }
+
+    if (f_open(&fil, strip_sd_prefix(rom_path), FA_READ) != FR_OK) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    fix_file_size(&fil);
+
+    size_t rom_size = f_size(&fil);
+
+    if (rom_size > MiB(64)) {
+        f_close(&fil);
+        return FLASHCART_ERR_ARGS;
+    }
+
+    uint32_t chunk_count = ((rom_size + chunk_size - 1) / chunk_size);
+    size_t total = 0;
+    size_t loaded = 0;
+    size_t swap_offset = 0;
+    size_t swap_length = 0;
+
+    for (uint32_t i = 0; i < chunk_count; i++) {
+        if (changed[i / 8] & (1 << (i % 8))) {
+            total += MIN(rom_size - (i * chunk_size), chunk_size);
+        }
+    }
+
+    load_progress_begin(progress, FLASHCART_LOAD_PHASE_SDRAM, total);
+
+    cart_card_byteswap = (order == ROM_ORDER_V64);
+
+    // NOTE: Consecutive changed chunks are read as one range, seeking over the unchanged ones only follows the cluster chain
+    for (uint32_t i = 0; (i < chunk_count) && !error; ) {
+        if (!(changed[i / 8] & (1 << (i % 8)))) {
+            i += 1;
+            continue;
+        }
+
+        uint32_t first = i;
+        while ((i < chunk_count) && (changed[i / 8] & (1 << (i % 8)))) {
+            i += 1;
+        }
+
+        size_t offset = (first * chunk_size);
+        size_t length = MIN(i * chunk_size, rom_size) - offset;
+
+        if (f_lseek(&fil, offset) != FR_OK) {
+            error = true;
+            break;
+        }
+
+        if (order == ROM_ORDER_N64) {
+            swap_offset = offset;
+            swap_length = length;
+        }
+
+        while (length > 0) {
+            size_t block_size = MIN(length, chunk_size);
+            if ((f_read(&fil, (void *) (ROM_ADDRESS + offset), block_size, &br) != FR_OK) || (br != block_size)) {
+                error = true;
+                break;
+            }
+            offset += block_size;
+            length -= block_size;
+            loaded += block_size;
+            if (load_progress_update(loaded)) {
+                error = true;
+                break;
+            }
+        }
+
+        if (!error && (swap_length > 0) && (swap_rom_words(swap_offset, swap_length, NULL) != FLASHCART_OK)) {
+            error = true;
+        }
+    }
+
+    cart_card_byteswap = false;
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    if (load_progress_cancelled()) {
+        return FLASHCART_ERR_CANCELLED;
+    }
+
+    if (!error) {
+        load_progress_end();
+    }
+
+    return error ? FLASHCART_ERR_LOAD : FLASHCART_OK;
+}
+
+flashcart_err_t flashcart_read_rom (uint32_t offset, void *buffer, size_t length) {
+    if ((offset >= MiB(64)) || (length > (MiB(64) - offset))) {
+        return FLASHCART_ERR_ARGS;
+    }
+
+    pi_dma_read_data((void *) (ROM_ADDRESS + offset), buffer, length);
+
+    return FLASHCART_OK;
+}
+
+flashcart_err_t flashcart_verify_rom (const rom_chunks_t *chunks, flashcart_progress_callback_t *progress) {
+    if ((chunks == NULL) || (chunks->rom_size > MiB(64)) || ((1 << chunks->shift) < sizeof(verify_buffers[0]))) {
+        return FLASHCART_ERR_ARGS;
+    }
+
+    uint32_t chunk_size = (1 << chunks->shift);
+    uint32_t chunk = 0;
+    uint64_t hash = ROM_CHUNKS_HASH_INIT;
+
+    load_progress_begin(progress, FLASHCART_LOAD_PHASE_VERIFY, chunks->rom_size);
+
+    // NOTE: Buffers take turns, the next block is read over PI while the current one is hashed
+    pi_dma_read_data_start((void *) (ROM_ADDRESS), verify_buffers[0], ALIGN(MIN(chunks->rom_size, sizeof(verify_buffers[0])), 2));
+
+    for (uint32_t offset = 0, i = 0; offset < chunks->rom_size; i++) {
+        uint8_t *buffer = verify_buffers[i % 2];
+        uint32_t block_size = MIN(chunks->rom_size - offset, sizeof(verify_buffers[0]));
+        uint32_t next_offset = offset + block_size;
+
+        dma_wait();
+        if (next_offset < chunks->rom_size) {
+            uint32_t next_size = MIN(chunks->rom_size - next_offset, sizeof(verify_buffers[0]));
+            pi_dma_read_data_start((void *) (ROM_ADDRESS + next_offset), verify_buffers[(i + 1) % 2], ALIGN(next_size, 2));
+        }
+
+        hash = rom_chunks_hash(hash, buffer, block_size);
+
+        if (((next_offset % chunk_size) == 0) || (next_offset == chunks->rom_size)) {
+            if (hash != chunks->hashes[chunk]) {
+                dma_wait();
+                return FLASHCART_ERR_VERIFY;
+            }
+            chunk += 1;
+            hash = ROM_CHUNKS_HASH_INIT;
+        }
+
+        offset = next_offset;
+
+        if (load_progress_update(offset)) {
+            dma_wait();
+            return FLASHCART_ERR_CANCELLED;
+        }
+    }
+
+    load_progress_end();
+
+    return FLASHCART_OK;
+}
+
 flashcart_err_t flashcart_load_file (char *file_path, uint32_t rom_offset, uint32_t file_offset) {
     if ((file_path == NULL) || ((file_offset % FS_SECTOR_SIZE) != 0)) {
         return FLASHCART_ERR_ARGS;
@@ -152,7 +455,7 @@ flashcart_err_t flashcart_load_file (char *file_path, uint32_t rom_offset, uint3
     return flashcart->load_file(file_path, rom_offset, file_offset);
 }
 
-flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save_type) {
+flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save_type, flashcart_save_map_t *map) {
     flashcart_err_t err;
 
     if (save_type >= __FLASHCART_SAVE_TYPE_END) {
@@ -167,17 +470,32 @@ flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save
         return FLASHCART_OK;
     }
 
-    if (!file_exists(save_path)) {
-        if (file_allocate(save_path, SAVE_SIZE[save_type])) {
-            return FLASHCART_ERR_LOAD;
-        }
-        if (file_fill(save_path, 0xFF)) {
-            return FLASHCART_ERR_LOAD;
+    // NOTE: A known map comes from a launch profile validated against the file size, date and first cluster,
+    //       the file already exists with the right size and its clusters don't need to be walked again.
+    //       A map that doesn't cover the whole save is rebuilt, writeback would leave the rest of it unmapped.
+    bool mapped = ((map != NULL) && (map->run_count > 0) && (map->run_count <= FLASHCART_SAVE_MAP_MAX_RUNS));
+
+    if (mapped) {
+        uint32_t mapped_sectors = 0;
+        for (uint32_t i = 0; i < map->run_count; i++) {
+            mapped_sectors += map->runs[i].count;
         }
+        mapped = (mapped_sectors == (SAVE_SIZE[save_type] / FS_SECTOR_SIZE));
     }
 
-    if (file_get_size(save_path) != SAVE_SIZE[save_type]) {
-        return FLASHCART_ERR_LOAD;
+    if (!mapped) {
+        if (!file_exists(save_path)) {
+            if (file_allocate(save_path, SAVE_SIZE[save_type])) {
+                return FLASHCART_ERR_LOAD;
+            }
+            if (file_fill(save_path, 0xFF)) {
+                return FLASHCART_ERR_LOAD;
+            }
+        }
+
+        if (file_get_size(save_path) != SAVE_SIZE[save_type]) {
+            return FLASHCART_ERR_LOAD;
+        }
     }
 
     if ((err = flashcart->load_save(save_path)) != FLASHCART_OK) {
@@ -188,8 +506,22 @@ flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save
         for (int i = 0; i < SAVE_WRITEBACK_MAX_SECTORS; i++) {
             save_writeback_sectors[i] = 0;
         }
-        if (file_get_sectors(save_path, save_writeback_sectors_callback)) {
-            return FLASHCART_ERR_LOAD;
+        if (mapped) {
+            save_writeback_sectors_from_map(map, SAVE_SIZE[save_type] / FS_SECTOR_SIZE);
+        } else {
+            save_map = map;
+            save_map_overflow = false;
+            if (map != NULL) {
+                map->run_count = 0;
+            }
+            bool error = file_get_sectors(save_path, save_writeback_sectors_callback);
+            if ((map != NULL) && (error || save_map_overflow)) {
+                map->run_count = 0;
+            }
+            save_map = NULL;
+            if (error) {
+                return FLASHCART_ERR_LOAD;
+            }
         }
         if ((err = flashcart->set_save_writeback(save_writeback_sectors)) != FLASHCART_OK) {
             return err;
@@ -9,8 +9,12 @@
 
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "../menu/rom_chunks.h"
+#include "../utils/rom_order.h"
+
 
 /** @brief Flashcart error enumeration */
 typedef enum {
@@ -22,6 +26,8 @@ typedef enum {
     FLASHCART_ERR_LOAD,
     FLASHCART_ERR_INT,
     FLASHCART_ERR_FUNCTION_NOT_SUPPORTED,
+    FLASHCART_ERR_CANCELLED,
+    FLASHCART_ERR_VERIFY,
 } flashcart_err_t;
 
 /** @brief List of optional supported flashcart features */
@@ -44,6 +50,23 @@ typedef enum {
     __FLASHCART_SAVE_TYPE_END
 } flashcart_save_type_t;
 
+/** @brief Maximum number of contiguous sector runs remembered for a save file */
+#define FLASHCART_SAVE_MAP_MAX_RUNS     (4)
+
+/**
+ * @brief Flashcart Save Map Structure.
+ *
+ * Location of the save file on the SD card, lets a later load skip the cluster chain walk.
+ * `run_count` of 0 means unknown, it stays 0 when the file is more fragmented than the map can describe.
+ */
+typedef struct {
+    uint32_t run_count;
+    struct {
+        uint32_t sector;
+        uint32_t count;
+    } runs[FLASHCART_SAVE_MAP_MAX_RUNS];
+} flashcart_save_map_t;
+
 /** @brief Flashcart Disk Parameter Structure. */
 typedef struct {
     bool development_drive;
@@ -52,7 +75,58 @@ typedef struct {
     uint8_t defect_tracks[16][12];
 } flashcart_disk_parameters_t;
 
-typedef void flashcart_progress_callback_t (float progress);
+/** @brief Flashcart load phase enumeration. */
+typedef enum {
+    FLASHCART_LOAD_PHASE_SDRAM,
+    FLASHCART_LOAD_PHASE_SHADOW,
+    FLASHCART_LOAD_PHASE_EXTENDED,
+    FLASHCART_LOAD_PHASE_64DD_IPL,
+    FLASHCART_LOAD_PHASE_BYTE_ORDER,
+    FLASHCART_LOAD_PHASE_VERIFY,
+    __FLASHCART_LOAD_PHASE_END
+} flashcart_load_phase_t;
+
+/**
+ * @brief Flashcart flash programming statistics structure.
+ *
+ * Erase blocks are either erased and programmed or found already holding the data.
+ * Times are spent in each step, reads of incoming blocks overlap the programming of the previous one.
+ * Erases don't overlap anything.
+ */
+typedef struct {
+    uint32_t blocks_programmed;
+    uint32_t blocks_skipped;
+    uint32_t read_us;
+    uint32_t verify_us;
+    uint32_t erase_us;
+    uint32_t program_us;
+    uint32_t busy_us;
+} flashcart_flash_stats_t;
+
+/**
+ * @brief Flashcart load progress structure.
+ *
+ * Byte counts cover the whole load, phases only tell where the data currently goes.
+ * Rates are in MB/s, the instantaneous one covers the bytes since the previous callback.
+ * `eta_ms` stays 0 until the average rate is known.
+ */
+typedef struct {
+    flashcart_load_phase_t phase;
+    size_t done;
+    size_t total;
+    float instant_rate;
+    float average_rate;
+    uint32_t eta_ms;
+    uint32_t elapsed_ms;
+    flashcart_flash_stats_t flash;
+} flashcart_progress_t;
+
+/**
+ * @brief Called at most once per display refresh, and always once when the load completes.
+ *
+ * Returning true cancels the load, it stops after the transfer in flight and fails with FLASHCART_ERR_CANCELLED.
+ */
+typedef bool flashcart_progress_callback_t (const flashcart_progress_t *progress);
 
 /** @brief Flashcart Structure */
 typedef struct {
@@ -76,6 +150,8 @@ typedef struct {
     flashcart_err_t (*set_save_type) (flashcart_save_type_t save_type);
     /** @brief The flashcart set save writeback function */
     flashcart_err_t (*set_save_writeback) (uint32_t *sectors);
+    /** @brief The flashcart ROM mapping reset function, maps the whole ROM area back to SDRAM */
+    flashcart_err_t (*reset_rom_mapping) (void);
 } flashcart_t;
 
 
@@ -83,9 +159,14 @@ char *flashcart_convert_error_message (flashcart_err_t err);
 flashcart_err_t flashcart_init (void);
 flashcart_err_t flashcart_deinit (void);
 bool flashcart_has_feature (flashcart_features_t feature);
-flashcart_err_t flashcart_load_rom (char *rom_path, bool byte_swap, flashcart_progress_callback_t *progress);
+flashcart_err_t flashcart_load_rom (char *rom_path, rom_order_t order, flashcart_progress_callback_t *progress);
+flashcart_err_t flashcart_reset_rom_mapping (void);
+flashcart_err_t flashcart_load_rom_head (char *rom_path, rom_order_t order, size_t size);
+flashcart_err_t flashcart_load_rom_chunks (char *rom_path, rom_order_t order, uint32_t chunk_size, const uint8_t *changed, flashcart_progress_callback_t *progress);
+flashcart_err_t flashcart_read_rom (uint32_t offset, void *buffer, size_t length);
+flashcart_err_t flashcart_verify_rom (const rom_chunks_t *chunks, flashcart_progress_callback_t *progress);
 flashcart_err_t flashcart_load_file (char *file_path, uint32_t rom_offset, uint32_t file_offset);
-flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save_type);
+flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save_type, flashcart_save_map_t *map);
 flashcart_err_t flashcart_load_64dd_ipl (char *ipl_path, flashcart_progress_callback_t *progress);
 flashcart_err_t flashcart_load_64dd_disk (char *disk_path, flashcart_disk_parameters_t *disk_parameters);
 
@@ -0,0 +1,113 @@
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <fatfs/ff.h>
+#include <libdragon.h>
+
+#include "../menu/lz.h"
+#include "../menu/rom_pack.h"
+#include "../utils/fs.h"
+#include "../utils/utils.h"
+
+#include "flashcart.h"
+#include "flashcart_pack.h"
+#include "flashcart_utils.h"
+
+
+#define ROM_ADDRESS     (0x10000000)
+
+
+static uint8_t rom_pack_index[ROM_PACK_MAX_INDEX_SIZE] __attribute__((aligned(16)));
+static rom_pack_t rom_pack;
+
+
+// NOTE: Each block is decoded while the block decoded before it is written to SDRAM over PI.
+//       Reading from the SD card needs the same bus, so it starts only after that write is done.
+//       Stored blocks start at any byte of the file, FatFs would copy their partial first and last
+//       sectors into cart space with the CPU. They're read into RAM and written out over PI like the rest.
+flashcart_err_t flashcart_pack_load (char *rom_path, flashcart_progress_callback_t *progress) {
+    FIL fil;
+    UINT br;
+    flashcart_err_t err;
+
+    // NOTE: Containers load to SDRAM only, a large ROM loaded before may have left flash mapped above it
+    if ((err = flashcart_reset_rom_mapping()) != FLASHCART_OK) {
+        return err;
+    }
+
+    if (f_open(&fil, strip_sd_prefix(rom_path), FA_READ) != FR_OK) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    size_t index_size = MIN(f_size(&fil), ROM_PACK_MAX_INDEX_SIZE);
+
+    if ((f_read(&fil, rom_pack_index, index_size, &br) != FR_OK) || (br != index_size) || rom_pack_parse(rom_pack_index, index_size, &rom_pack)) {
+        f_close(&fil);
+        return FLASHCART_ERR_LOAD;
+    }
+    if (f_lseek(&fil, rom_pack.data_offset) != FR_OK) {
+        f_close(&fil);
+        return FLASHCART_ERR_LOAD;
+    }
+
+    uint8_t *buffers = malloc((ROM_PACK_BLOCK_SIZE * 2) + LZ_BOUND(ROM_PACK_BLOCK_SIZE));
+    if (buffers == NULL) {
+        f_close(&fil);
+        return FLASHCART_ERR_INT;
+    }
+    uint8_t *stored = buffers + (ROM_PACK_BLOCK_SIZE * 2);
+    uint8_t *pending = NULL;
+    uint32_t pending_offset = 0;
+    uint32_t pending_size = 0;
+
+    load_progress_begin(progress, FLASHCART_LOAD_PHASE_SDRAM, rom_pack.rom_size);
+
+    for (uint32_t i = 0; i < rom_pack.block_count; i++) {
+        uint32_t offset = (i << ROM_PACK_BLOCK_SHIFT);
+        uint32_t block_size = rom_pack_block_size(&rom_pack, i);
+        uint32_t stored_size = rom_pack.stored_sizes[i];
+        uint8_t *decoded = buffers + ((i % 2) * ROM_PACK_BLOCK_SIZE);
+        bool compressed = !rom_pack_block_stored(&rom_pack, i);
+
+        if ((f_read(&fil, compressed ? stored : decoded, stored_size, &br) != FR_OK) || (br != stored_size)) {
+            err = FLASHCART_ERR_LOAD;
+            break;
+        }
+
+        if (pending != NULL) {
+            pi_dma_write_data_start(pending, (void *) (ROM_ADDRESS + pending_offset), ALIGN(pending_size, 2));
+        }
+        if (compressed && lz_decompress(stored, stored_size, decoded, block_size)) {
+            err = FLASHCART_ERR_LOAD;
+        }
+        dma_wait();
+
+        pending = decoded;
+        pending_offset = offset;
+        pending_size = block_size;
+
+        if (err != FLASHCART_OK) {
+            break;
+        }
+        if (load_progress_update(offset + block_size)) {
+            err = FLASHCART_ERR_CANCELLED;
+            break;
+        }
+    }
+
+    if ((err == FLASHCART_OK) && (pending != NULL)) {
+        pi_dma_write_data(pending, (void *) (ROM_ADDRESS + pending_offset), ALIGN(pending_size, 2));
+    }
+
+    free(buffers);
+
+    if (f_close(&fil) != FR_OK) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    if (err == FLASHCART_OK) {
+        load_progress_end();
+    }
+
+    return err;
+}
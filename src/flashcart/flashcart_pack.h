@@ -0,0 +1,17 @@
+/**
+ * @file flashcart_pack.h
+ * @brief Block compressed ROM loading
+ * @ingroup flashcart
+ */
+
+#ifndef FLASHCART_PACK_H__
+#define FLASHCART_PACK_H__
+
+
+#include "flashcart.h"
+
+
+flashcart_err_t flashcart_pack_load (char *rom_path, flashcart_progress_callback_t *progress);
+
+
+#endif
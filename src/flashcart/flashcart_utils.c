@@ -1,3 +1,6 @@
+#include <string.h>
+
+#include <libcart/cart.h>
 #include <libdragon.h>
 
 #include "flashcart_utils.h"
@@ -5,6 +8,133 @@
 #include "../utils/utils.h"
 
 
+#define LOAD_MAX_TRANSFER_SECTORS   (MiB(1) / FS_SECTOR_SIZE)
+#define LOAD_PROGRESS_INTERVAL      TICKS_FROM_US(16667)
+
+
+static struct {
+    const flashcart_sector_transfer_t *transfer;
+    uint32_t address;
+    uint32_t sector_count;
+    uint32_t loaded;
+    file_run_t pending;
+    bool error;
+} load_runs;
+
+static struct {
+    flashcart_progress_callback_t *callback;
+    flashcart_progress_t state;
+    uint64_t start_ticks;
+    uint64_t report_ticks;
+    uint64_t rate_ticks;
+    size_t rate_done;
+    bool cancelled;
+} load_progress;
+
+
+static bool card_transfer_start (uint32_t address, uint32_t sector, uint32_t count) {
+    return (cart_card_rd_cart(address, sector, count) != 0);
+}
+
+static bool card_transfer_poll (bool *busy) {
+    *busy = false;
+    return false;
+}
+
+static const flashcart_sector_transfer_t card_transfer = {
+    .start = card_transfer_start,
+    .poll = card_transfer_poll,
+};
+
+
+static void load_progress_report (uint64_t now) {
+    flashcart_progress_t *state = &load_progress.state;
+    uint64_t elapsed_us = TICKS_TO_US(now - load_progress.start_ticks);
+
+    // NOTE: The done count stands still while a transfer is busy, the instantaneous rate
+    //       is only updated once it moves so it isn't reported as a stall.
+    if (state->done > load_progress.rate_done) {
+        uint64_t window_us = TICKS_TO_US(now - load_progress.rate_ticks);
+        if (window_us > 0) {
+            state->instant_rate = (state->done - load_progress.rate_done) / (float) (window_us);
+        }
+        load_progress.rate_ticks = now;
+        load_progress.rate_done = state->done;
+    }
+
+    state->elapsed_ms = (elapsed_us / 1000);
+    if ((elapsed_us > 0) && (state->done > 0)) {
+        state->average_rate = state->done / (float) (elapsed_us);
+        state->eta_ms = ((state->total - MIN(state->done, state->total)) / state->average_rate) / 1000.0f;
+    }
+
+    load_progress.report_ticks = now;
+    if (load_progress.callback(state)) {
+        load_progress.cancelled = true;
+    }
+}
+
+
+static bool load_run (uint32_t sector, uint32_t count) {
+    const flashcart_sector_transfer_t *transfer = load_runs.transfer;
+
+    // NOTE: Runs are split only to keep the progress display moving, each transfer
+    //       still goes straight from the SD card to the cartridge address space.
+    while (count > 0) {
+        uint32_t length = MIN(count, LOAD_MAX_TRANSFER_SECTORS);
+        bool busy;
+        if (transfer->start(load_runs.address + (load_runs.loaded * FS_SECTOR_SIZE), sector, length)) {
+            return true;
+        }
+        // NOTE: The progress callback keeps the screen moving while the cart is busy,
+        //       it must not access the cart itself. A cancel is only acted on once the
+        //       transfer completes, the cart doesn't accept commands while it's busy.
+        do {
+            if (transfer->poll(&busy)) {
+                return true;
+            }
+            if (busy) {
+                load_progress_update(load_runs.loaded * FS_SECTOR_SIZE);
+            }
+        } while (busy);
+        sector += length;
+        count -= length;
+        load_runs.loaded += length;
+        if (load_progress_update(load_runs.loaded * FS_SECTOR_SIZE)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool load_runs_callback (uint32_t sector_count, uint32_t file_sector, uint32_t run_sector, uint32_t run_size) {
+    file_run_t *pending = &load_runs.pending;
+
+    if (file_sector >= load_runs.sector_count) {
+        return true;
+    }
+
+    uint32_t count = MIN(run_size, load_runs.sector_count - file_sector);
+
+    // NOTE: FAT12 chains arrive one cluster at a time, adjacent ones are still loaded with a single transfer
+    if ((pending->count > 0) && ((pending->sector + pending->count) == run_sector)) {
+        pending->count += count;
+        return false;
+    }
+
+    if ((pending->count > 0) && load_run(pending->sector, pending->count)) {
+        load_runs.error = true;
+        return true;
+    }
+
+    pending->sector = run_sector;
+    pending->count = count;
+
+    return false;
+}
+
+
 void fix_file_size (FIL *fil) {
     // HACK: Align file size to the SD sector size to prevent FatFs from doing partial sector load.
     //       We are relying on direct transfer from SD to SDRAM without CPU intervention.
@@ -12,18 +142,101 @@ void fix_file_size (FIL *fil) {
     fil->obj.objsize = ALIGN(f_size(fil), FS_SECTOR_SIZE);
 }
 
+void load_progress_begin (flashcart_progress_callback_t *callback, flashcart_load_phase_t phase, size_t total) {
+    uint64_t now = get_ticks();
+
+    memset(&load_progress, 0, sizeof(load_progress));
+
+    load_progress.callback = callback;
+    load_progress.state.phase = phase;
+    load_progress.state.total = total;
+    load_progress.start_ticks = now;
+    load_progress.report_ticks = now;
+    load_progress.rate_ticks = now;
+}
+
+void load_progress_phase (flashcart_load_phase_t phase) {
+    load_progress.state.phase = phase;
+}
+
+bool load_progress_update (size_t done) {
+    load_progress.state.done = MIN(done, load_progress.state.total);
+
+    if ((load_progress.callback == NULL) || load_progress.cancelled) {
+        return load_progress.cancelled;
+    }
+
+    // NOTE: Callers report after every transfer and on every busy poll, anything
+    //       faster than the display refresh would only take time from the load.
+    uint64_t now = get_ticks();
+    if ((now - load_progress.report_ticks) >= LOAD_PROGRESS_INTERVAL) {
+        load_progress_report(now);
+    }
+
+    return load_progress.cancelled;
+}
+
+flashcart_flash_stats_t *load_progress_flash_stats (void) {
+    return &load_progress.state.flash;
+}
+
+bool load_progress_cancelled (void) {
+    return load_progress.cancelled;
+}
+
+void load_progress_end (void) {
+    if ((load_progress.callback == NULL) || load_progress.cancelled) {
+        return;
+    }
+
+    load_progress.state.done = load_progress.state.total;
+    load_progress.state.eta_ms = 0;
+    load_progress_report(get_ticks());
+    load_progress.callback = NULL;
+}
+
+// NOTE: Each run is loaded as soon as the walk reaches the end of it, the chain is walked only once
+//       and no run table caps how fragmented a file can be before the load falls back to FatFs.
+bool load_file_runs (char *path, uint32_t address, size_t size, const flashcart_sector_transfer_t *transfer) {
+    load_runs.transfer = (transfer == NULL) ? &card_transfer : transfer;
+    load_runs.address = address;
+    load_runs.sector_count = (ALIGN(size, FS_SECTOR_SIZE) / FS_SECTOR_SIZE);
+    load_runs.loaded = 0;
+    load_runs.pending.sector = 0;
+    load_runs.pending.count = 0;
+    load_runs.error = false;
+
+    if (file_get_sectors(path, load_runs_callback) || load_runs.error) {
+        return true;
+    }
+
+    if ((load_runs.pending.count > 0) && load_run(load_runs.pending.sector, load_runs.pending.count)) {
+        return true;
+    }
+
+    return (load_runs.loaded != load_runs.sector_count);
+}
+
 void pi_dma_read_data (void *src, void *dst, size_t length) {
+    pi_dma_read_data_start(src, dst, length);
+    dma_wait();
+}
+
+void pi_dma_read_data_start (void *src, void *dst, size_t length) {
     data_cache_hit_writeback_invalidate(dst, length);
     dma_read_async(dst, (uint32_t) (src), length);
-    dma_wait();
 }
 
 void pi_dma_write_data (void *src, void *dst, size_t length) {
+    pi_dma_write_data_start(src, dst, length);
+    dma_wait();
+}
+
+void pi_dma_write_data_start (void *src, void *dst, size_t length) {
     assert((((uint32_t) (src)) & 0x07) == 0);
     assert((((uint32_t) (dst)) & 0x01) == 0);
     assert((length & 1) == 0);
 
     data_cache_hit_writeback(src, length);
     dma_write_raw_async(src, (uint32_t) (dst), length);
-    dma_wait();
 }
@@ -8,12 +8,38 @@
 #define FLASHCART_UTILS_H__
 
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <fatfs/ff.h>
 
+#include "flashcart.h"
+
+
+/**
+ * @brief Flashcart sector transfer structure.
+ *
+ * Reads SD sectors straight to a cartridge address. `start` may return before the transfer is done,
+ * `poll` then reports it as busy until it completes.
+ */
+typedef struct {
+    bool (*start) (uint32_t address, uint32_t sector, uint32_t count);
+    bool (*poll) (bool *busy);
+} flashcart_sector_transfer_t;
+
 
 void fix_file_size (FIL *fil);
+void load_progress_begin (flashcart_progress_callback_t *callback, flashcart_load_phase_t phase, size_t total);
+void load_progress_phase (flashcart_load_phase_t phase);
+bool load_progress_update (size_t done);
+flashcart_flash_stats_t *load_progress_flash_stats (void);
+bool load_progress_cancelled (void);
+void load_progress_end (void);
+bool load_file_runs (char *path, uint32_t address, size_t size, const flashcart_sector_transfer_t *transfer);
 void pi_dma_read_data (void *src, void *dst, size_t length);
+void pi_dma_read_data_start (void *src, void *dst, size_t length);
 void pi_dma_write_data (void *src, void *dst, size_t length);
+void pi_dma_write_data_start (void *src, void *dst, size_t length);
 
 
 #endif
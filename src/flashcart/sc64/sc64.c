@@ -1,11 +1,15 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <fatfs/ff.h>
+#include <libcart/cart.h>
 #include <libdragon.h>
 
 #include "../../utils/fs.h"
+#include "../../utils/rom_order.h"
 #include "../../utils/utils.h"
 
 #include "../flashcart_utils.h"
@@ -76,9 +80,30 @@ static const uint8_t rom_zones[DISK_TYPES] = { 5, 7, 9, 11, 13, 15, 16 };
 
 
 static uint32_t disk_sectors_start_offset;
+static bool sd_load_supported;
+static uint8_t flash_readback[KiB(4)] __attribute__((aligned(16)));
 
 
-static flashcart_err_t load_to_flash (FIL *fil, void *address, size_t size, UINT *br, flashcart_progress_callback_t *progress) {
+static bool flash_block_matches (void *address, uint8_t *data, size_t size) {
+    for (size_t offset = 0; offset < size; offset += sizeof(flash_readback)) {
+        size_t length = MIN(size - offset, sizeof(flash_readback));
+        pi_dma_read_data(address + offset, flash_readback, ALIGN(length, 2));
+        if (memcmp(flash_readback, data + offset, length) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t elapsed_us (uint64_t *ticks) {
+    uint64_t now = get_ticks();
+    uint32_t us = TICKS_TO_US(now - *ticks);
+    *ticks = now;
+    return us;
+}
+
+static flashcart_err_t load_to_flash (FIL *fil, void *address, size_t size, UINT *br) {
+    flashcart_flash_stats_t *stats = load_progress_flash_stats();
     size_t erase_block_size;
     UINT bp;
 
@@ -88,26 +113,124 @@ static flashcart_err_t load_to_flash (FIL *fil, void *address, size_t size, UINT
         return FLASHCART_ERR_INT;
     }
 
-    while (size > 0) {
+    // NOTE: Without a buffer for the incoming block every block is erased and programmed unverified
+    uint8_t *block = malloc(erase_block_size);
+    flashcart_err_t err = FLASHCART_OK;
+    bool programming = false;
+
+    while ((size > 0) && (err == FLASHCART_OK)) {
         size_t program_size = MIN(size, erase_block_size);
-        if (sc64_ll_flash_erase_block(address) != SC64_OK) {
-            return FLASHCART_ERR_INT;
+        bool program = true;
+        uint64_t ticks = get_ticks();
+
+        // NOTE: Programming returns while the flash is still being written. Reading the next block
+        //       into RAM only touches the SD card, so the wait for the flash is deferred until after it.
+        //       libcart swaps the bytes of a .v64 ROM only on reads into cart space, the copy in RAM is converted here.
+        if (block != NULL) {
+            if ((f_read(fil, block, program_size, &bp) != FR_OK) || (bp != program_size)) {
+                err = FLASHCART_ERR_LOAD;
+                break;
+            }
+            if (cart_card_byteswap) {
+                rom_order_convert(block, program_size, ROM_ORDER_V64);
+            }
+            stats->read_us += elapsed_us(&ticks);
         }
-        if (f_read(fil, address, program_size, &bp) != FR_OK) {
-            return FLASHCART_ERR_LOAD;
+
+        if (programming) {
+            programming = false;
+            if (sc64_ll_flash_wait_busy() != SC64_OK) {
+                err = FLASHCART_ERR_INT;
+                break;
+            }
+            stats->busy_us += elapsed_us(&ticks);
         }
-        if (sc64_ll_flash_wait_busy() != SC64_OK) {
-            return FLASHCART_ERR_INT;
+
+        // NOTE: Relaunching the same large ROM finds its blocks already programmed, comparing
+        //       saves an erase cycle per unchanged block. A changed one is programmed from the same copy.
+        if (block != NULL) {
+            program = !flash_block_matches(address, block, program_size);
+            stats->verify_us += elapsed_us(&ticks);
         }
-        if (progress) {
-            progress(f_tell(fil) / (float) (f_size(fil)));
+
+        // NOTE: The erase stays synchronous. Whether a block needs one is only known after its compare, and
+        //       the erase and the SD reads are both commands of the SC64, which runs one command at a time.
+        if (program) {
+            if (sc64_ll_flash_erase_block(address) != SC64_OK) {
+                err = FLASHCART_ERR_INT;
+                break;
+            }
+            stats->erase_us += elapsed_us(&ticks);
+            programming = true;
+            if (block != NULL) {
+                pi_dma_write_data(block, address, ALIGN(program_size, 2));
+            } else if ((f_read(fil, address, program_size, &bp) != FR_OK) || (bp != program_size)) {
+                err = FLASHCART_ERR_LOAD;
+                break;
+            }
+            stats->program_us += elapsed_us(&ticks);
+            stats->blocks_programmed += 1;
+        } else {
+            stats->blocks_skipped += 1;
+        }
+        if (load_progress_update(f_tell(fil))) {
+            err = FLASHCART_ERR_CANCELLED;
         }
         address += program_size;
         size -= program_size;
         *br += bp;
     }
 
-    return FLASHCART_OK;
+    // NOTE: Every exit waits for the last program, the flash must be idle before its mapping is enabled
+    if (programming) {
+        uint64_t ticks = get_ticks();
+        if ((sc64_ll_flash_wait_busy() != SC64_OK) && (err == FLASHCART_OK)) {
+            err = FLASHCART_ERR_INT;
+        }
+        stats->busy_us += elapsed_us(&ticks);
+    }
+
+    free(block);
+
+    return err;
+}
+
+static bool sd_transfer_start (uint32_t address, uint32_t sector, uint32_t count) {
+    if (sc64_ll_sd_set_sector(sector) != SC64_OK) {
+        return true;
+    }
+    sc64_ll_sd_read_start((void *) (address), count);
+    return false;
+}
+
+static bool sd_transfer_poll (bool *busy) {
+    return (sc64_ll_poll(busy) != SC64_OK);
+}
+
+static const flashcart_sector_transfer_t sd_transfer = {
+    .start = sd_transfer_start,
+    .poll = sd_transfer_poll,
+};
+
+static bool load_to_sdram (char *path, uint32_t address, size_t size) {
+    uint32_t status;
+
+    if (!sd_load_supported) {
+        return load_file_runs(path, address, size, NULL);
+    }
+
+    sc64_sd_card_op_t byte_swap = cart_card_byteswap ? SD_CARD_OP_BYTE_SWAP_ON : SD_CARD_OP_BYTE_SWAP_OFF;
+    if (sc64_ll_sd_card_op(byte_swap, &status) != SC64_OK) {
+        return true;
+    }
+
+    bool error = load_file_runs(path, address, size, &sd_transfer);
+
+    if (cart_card_byteswap) {
+        sc64_ll_sd_card_op(SD_CARD_OP_BYTE_SWAP_OFF, &status);
+    }
+
+    return error;
 }
 
 static uint32_t disk_sectors_start (uint32_t offset) {
@@ -115,17 +238,19 @@ static uint32_t disk_sectors_start (uint32_t offset) {
     return (offset + (DISK_MAX_SECTORS * sizeof(uint32_t)));
 }
 
-static void disk_sectors_callback (uint32_t sector_count, uint32_t file_sector, uint32_t cluster_sector, uint32_t cluster_size) {
-    for (uint32_t i = 0; i < cluster_size; i++) {
+static bool disk_sectors_callback (uint32_t sector_count, uint32_t file_sector, uint32_t run_sector, uint32_t run_size) {
+    for (uint32_t i = 0; i < run_size; i++) {
         uint32_t offset = file_sector + i;
-        uint32_t sector = cluster_sector + i;
+        uint32_t sector = run_sector + i;
 
-        if ((offset > DISK_MAX_SECTORS) || (offset > sector_count)) {
-            return;
+        if ((offset >= DISK_MAX_SECTORS) || (offset >= sector_count)) {
+            return false;
         }
 
         io_write(ROM_ADDRESS + disk_sectors_start_offset + (offset * sizeof(uint32_t)), sector);
     }
+
+    return false;
 }
 
 static bool disk_zone_track_is_bad (uint8_t zone, uint8_t track, flashcart_disk_parameters_t *disk_parameters) {
@@ -246,6 +371,9 @@ static flashcart_err_t sc64_init (void) {
         }
     }
 
+    // NOTE: A cart that can't take the SD commands keeps the blocking libcart transfers
+    sd_load_supported = sc64_ll_sd_available();
+
     return FLASHCART_OK;
 }
 
@@ -290,20 +418,34 @@ static flashcart_err_t sc64_load_rom (char *rom_path, flashcart_progress_callbac
     size_t shadow_size = shadow_enabled ? MIN(rom_size - sdram_size, KiB(128)) : 0;
     size_t extended_size = extended_enabled ? rom_size - MiB(64) : 0;
 
-    size_t chunk_size = KiB(128);
-    for (int offset = 0; offset < sdram_size; offset += chunk_size) {
-        size_t block_size = MIN(sdram_size - offset, chunk_size);
-        if (f_read(&fil, (void *) (ROM_ADDRESS + offset), block_size, &br) != FR_OK) {
+    load_progress_begin(progress, FLASHCART_LOAD_PHASE_SDRAM, rom_size);
+
+    if (!load_to_sdram(rom_path, ROM_ADDRESS, sdram_size)) {
+        // NOTE: Seeking walks the cluster chain again, it's needed only for the data loaded to flash
+        if (shadow_enabled && (f_lseek(&fil, sdram_size) != FR_OK)) {
             f_close(&fil);
             return FLASHCART_ERR_LOAD;
         }
-        if (progress) {
-            progress(f_tell(&fil) / (float) (f_size(&fil)));
-        }
-    }
-    if (f_tell(&fil) != sdram_size) {
+    } else if (load_progress_cancelled()) {
         f_close(&fil);
-        return FLASHCART_ERR_LOAD;
+        return FLASHCART_ERR_CANCELLED;
+    } else {
+        size_t chunk_size = KiB(128);
+        for (int offset = 0; offset < sdram_size; offset += chunk_size) {
+            size_t block_size = MIN(sdram_size - offset, chunk_size);
+            if (f_read(&fil, (void *) (ROM_ADDRESS + offset), block_size, &br) != FR_OK) {
+                f_close(&fil);
+                return FLASHCART_ERR_LOAD;
+            }
+            if (load_progress_update(f_tell(&fil))) {
+                f_close(&fil);
+                return FLASHCART_ERR_CANCELLED;
+            }
+        }
+        if (f_tell(&fil) != sdram_size) {
+            f_close(&fil);
+            return FLASHCART_ERR_LOAD;
+        }
     }
 
     if (sc64_ll_set_config(CFG_ID_ROM_SHADOW_ENABLE, shadow_enabled) != SC64_OK) {
@@ -312,7 +454,8 @@ static flashcart_err_t sc64_load_rom (char *rom_path, flashcart_progress_callbac
     }
 
     if (shadow_enabled) {
-        flashcart_err_t err = load_to_flash(&fil, (void *) (SHADOW_ADDRESS), shadow_size, &br, progress);
+        load_progress_phase(FLASHCART_LOAD_PHASE_SHADOW);
+        flashcart_err_t err = load_to_flash(&fil, (void *) (SHADOW_ADDRESS), shadow_size, &br);
         if (err != FLASHCART_OK) {
             f_close(&fil);
             return err;
@@ -329,7 +472,8 @@ static flashcart_err_t sc64_load_rom (char *rom_path, flashcart_progress_callbac
     }
 
     if (extended_enabled) {
-        flashcart_err_t err = load_to_flash(&fil, (void *) (EXTENDED_ADDRESS), extended_size, &br, progress);
+        load_progress_phase(FLASHCART_LOAD_PHASE_EXTENDED);
+        flashcart_err_t err = load_to_flash(&fil, (void *) (EXTENDED_ADDRESS), extended_size, &br);
         if (err != FLASHCART_OK) {
             f_close(&fil);
             return err;
@@ -344,6 +488,8 @@ static flashcart_err_t sc64_load_rom (char *rom_path, flashcart_progress_callbac
         return FLASHCART_ERR_LOAD;
     }
 
+    load_progress_end();
+
     return FLASHCART_OK;
 }
 
@@ -452,6 +598,8 @@ static flashcart_err_t sc64_load_64dd_ipl (char *ipl_path, flashcart_progress_ca
         return FLASHCART_ERR_LOAD;
     }
 
+    load_progress_begin(progress, FLASHCART_LOAD_PHASE_64DD_IPL, ipl_size);
+
     size_t chunk_size = KiB(128);
     for (int offset = 0; offset < ipl_size; offset += chunk_size) {
         size_t block_size = MIN(ipl_size - offset, chunk_size);
@@ -459,8 +607,9 @@ static flashcart_err_t sc64_load_64dd_ipl (char *ipl_path, flashcart_progress_ca
             f_close(&fil);
             return FLASHCART_ERR_LOAD;
         }
-        if (progress) {
-            progress(f_tell(&fil) / (float) (f_size(&fil)));
+        if (load_progress_update(f_tell(&fil))) {
+            f_close(&fil);
+            return FLASHCART_ERR_CANCELLED;
         }
     }
     if (f_tell(&fil) != ipl_size) {
@@ -472,6 +621,8 @@ static flashcart_err_t sc64_load_64dd_ipl (char *ipl_path, flashcart_progress_ca
         return FLASHCART_ERR_LOAD;
     }
 
+    load_progress_end();
+
     return FLASHCART_OK;
 }
 
@@ -569,6 +720,18 @@ static flashcart_err_t sc64_set_save_writeback (uint32_t *sectors) {
     return FLASHCART_OK;
 }
 
+static flashcart_err_t sc64_reset_rom_mapping (void) {
+    if (sc64_ll_set_config(CFG_ID_ROM_SHADOW_ENABLE, false) != SC64_OK) {
+        return FLASHCART_ERR_INT;
+    }
+
+    if (sc64_ll_set_config(CFG_ID_ROM_EXTENDED_ENABLE, false) != SC64_OK) {
+        return FLASHCART_ERR_INT;
+    }
+
+    return FLASHCART_OK;
+}
+
 
 static flashcart_t flashcart_sc64 = {
     .init = sc64_init,
@@ -581,6 +744,7 @@ static flashcart_t flashcart_sc64 = {
     .load_64dd_disk = sc64_load_64dd_disk,
     .set_save_type = sc64_set_save_type,
     .set_save_writeback = sc64_set_save_writeback,
+    .reset_rom_mapping = sc64_reset_rom_mapping,
 };
 
 
@@ -30,6 +30,9 @@ typedef enum {
     CMD_ID_WRITEBACK_SD_INFO    = 'W',
     CMD_ID_FLASH_WAIT_BUSY      = 'p',
     CMD_ID_FLASH_ERASE_BLOCK    = 'P',
+    CMD_ID_SD_CARD_OP           = 'i',
+    CMD_ID_SD_SECTOR_SET        = 'I',
+    CMD_ID_SD_READ              = 's',
 } sc64_cmd_id_t;
 
 /** @brief SummerCart64 Commands Structure. */
@@ -40,11 +43,15 @@ typedef struct {
 } sc64_cmd_t;
 
 
-static sc64_error_t sc64_ll_execute_cmd (sc64_cmd_t *cmd) {
+static void sc64_ll_start_cmd (sc64_cmd_t *cmd) {
     io_write((uint32_t) (&SC64_REGS->DATA[0]), cmd->arg[0]);
     io_write((uint32_t) (&SC64_REGS->DATA[1]), cmd->arg[1]);
 
     io_write((uint32_t) (&SC64_REGS->SR_CMD), (cmd->id & 0xFF));
+}
+
+static sc64_error_t sc64_ll_execute_cmd (sc64_cmd_t *cmd) {
+    sc64_ll_start_cmd(cmd);
 
     uint32_t sr;
     do {
@@ -163,3 +170,55 @@ sc64_error_t sc64_ll_flash_erase_block (void *address) {
     };
     return sc64_ll_execute_cmd(&cmd);
 }
+
+sc64_error_t sc64_ll_sd_card_op (sc64_sd_card_op_t op, uint32_t *status) {
+    sc64_cmd_t cmd = {
+        .id = CMD_ID_SD_CARD_OP,
+        .arg = { 0, op }
+    };
+    sc64_error_t error = sc64_ll_execute_cmd(&cmd);
+    *status = cmd.rsp[1];
+    return error;
+}
+
+sc64_error_t sc64_ll_sd_set_sector (uint32_t sector) {
+    sc64_cmd_t cmd = {
+        .id = CMD_ID_SD_SECTOR_SET,
+        .arg = { sector }
+    };
+    return sc64_ll_execute_cmd(&cmd);
+}
+
+bool sc64_ll_sd_available (void) {
+    uint32_t status;
+
+    // NOTE: Firmware without SD access still answers the status request, the card must be reported
+    //       initialized and the sector command itself must be accepted before reads are issued directly
+    if ((sc64_ll_sd_card_op(SD_CARD_OP_GET_STATUS, &status) != SC64_OK) || !(status & SD_CARD_STATUS_INITIALIZED)) {
+        return false;
+    }
+
+    return (sc64_ll_sd_set_sector(0) == SC64_OK);
+}
+
+void sc64_ll_sd_read_start (void *address, uint32_t count) {
+    // NOTE: The cart streams the sectors to SDRAM on its own, the command stays busy until the last one is written.
+    //       Completion is reported by sc64_ll_poll(), no other command can be issued until then.
+    sc64_cmd_t cmd = {
+        .id = CMD_ID_SD_READ,
+        .arg = { (uint32_t) (address), count }
+    };
+    sc64_ll_start_cmd(&cmd);
+}
+
+sc64_error_t sc64_ll_poll (bool *busy) {
+    uint32_t sr = io_read((uint32_t) (&SC64_REGS->SR_CMD));
+
+    *busy = (sr & SC64_SR_CPU_BUSY);
+
+    if (!(*busy) && (sr & SC64_SR_CMD_ERROR)) {
+        return (sc64_error_t) (io_read((uint32_t) (&SC64_REGS->DATA[0])));
+    }
+
+    return SC64_OK;
+}
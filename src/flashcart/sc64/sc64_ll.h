@@ -8,6 +8,7 @@
 #define FLASHCART_SC64_LL_H__
 
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -113,6 +114,18 @@ typedef enum {
     BUTTON_MODE_DD_DISK_SWAP,
 } sc64_button_mode_t;
 
+typedef enum {
+    SD_CARD_OP_DEINIT = 0,
+    SD_CARD_OP_INIT = 1,
+    SD_CARD_OP_GET_STATUS = 2,
+    SD_CARD_OP_GET_INFO = 3,
+    SD_CARD_OP_BYTE_SWAP_ON = 4,
+    SD_CARD_OP_BYTE_SWAP_OFF = 5,
+} sc64_sd_card_op_t;
+
+/** @brief SD_CARD_OP_GET_STATUS bit set once the cart has initialized the card */
+#define SD_CARD_STATUS_INITIALIZED  (1 << 0)
+
 typedef struct {
     int count;
     struct {
@@ -132,6 +145,11 @@ sc64_error_t sc64_ll_writeback_enable (void *address);
 sc64_error_t sc64_ll_flash_wait_busy (void);
 sc64_error_t sc64_ll_flash_get_erase_block_size (size_t *erase_block_size);
 sc64_error_t sc64_ll_flash_erase_block (void *address);
+sc64_error_t sc64_ll_sd_card_op (sc64_sd_card_op_t op, uint32_t *status);
+sc64_error_t sc64_ll_sd_set_sector (uint32_t sector);
+bool sc64_ll_sd_available (void);
+void sc64_ll_sd_read_start (void *address, uint32_t count);
+sc64_error_t sc64_ll_poll (bool *busy);
 
 /** @} */ /* sc64 */
 
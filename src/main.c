@@ -4,6 +4,15 @@
 
 #include "boot/boot.h"
 #include "flashcart/flashcart.h"
+#include "menu/art_cache.h"
+#include "menu/art_pack.h"
+#include "menu/box_art.h"
+#include "menu/catalog.h"
+#include "menu/launch_profile.h"
+#include "menu/resident_rom.h"
+#include "menu/rom_pack.h"
+#include "menu/save_ring.h"
+#include "menu/title_table.h"
 #include "utils/fs.h"
 
 #define PI 3.141592653f
@@ -14,6 +23,8 @@
 int menu_active;
 boot_params_t boot_params;
 char rom_path[1024];
+rom_order_t rom_order;
+bool rom_packed;
 
 float lerp(float t, float a, float b) {
     return a + (b - a) * t;
@@ -68,13 +79,44 @@ void spinner_draw(float x, float y, float size, float alpha) {
     spinner_counter += 0.25f;
 }
         
-static void cart_load_progress(float progress) {
-    surface_t *d = (progress >= 1.0f) ? display_get() : display_try_get();
+#define LOAD_DISPLAY_BUFFERS 3
+#define LOAD_FRAME_TICKS TICKS_FROM_US(33333)
+// Creating this file on the SD card turns on the check of every loaded ROM against its chunk list
+#define VERIFY_LOADS_PATH "sd:/menu/verify"
+
+uint64_t load_last_frame = 0;
+int load_frames = 0;
+flashcart_progress_t load_stats;
+
+static bool cart_load_cancel_pressed(void) {
+    joypad_poll();
+    return joypad_get_buttons_pressed(JOYPAD_PORT_1).b;
+}
+
+// The loader calls this at most once per display refresh, a frame is only submitted when one is due and a
+// buffer is free. The frame is handed to the RDP and the loader goes straight back to the next SD read.
+static bool cart_load_progress(const flashcart_progress_t *progress) {
+    uint64_t now = get_ticks();
+    load_stats = *progress;
+    bool complete = progress->done >= progress->total;
+    if(!complete && cart_load_cancel_pressed()) {
+        return true;
+    }
+    if(!complete && load_frames > 0 && (now - load_last_frame) < LOAD_FRAME_TICKS) {
+        return false;
+    }
+
+    surface_t *d = complete ? display_get() : display_try_get();
     if (d) {
         rdpq_attach(d, NULL);
 
+        // Every buffer is cleared once, later frames only repaint the spinner area
         rdpq_set_mode_fill(RGBA32(0,0,0,0));
-        rdpq_fill_rectangle(0, 0, 640, 480);
+        if(load_frames < LOAD_DISPLAY_BUFFERS) {
+            rdpq_fill_rectangle(0, 0, 640, 480);
+        } else {
+            rdpq_fill_rectangle(640 - 330, 480 - 83, 640 - 20, 480 - 13);
+        }
 
         rdpq_set_mode_standard();
         spinner_fade_counter++;
@@ -83,9 +125,22 @@ static void cart_load_progress(float progress) {
             if(spinner_fade > 1.0f) spinner_fade = 1.0f;
             spinner_draw(640 - 55, 480 - 48, 20, spinner_fade);
         }
+        // Short loads finish before the rate settles, the estimate is only shown for the long ones
+        if(progress->eta_ms > 0 && progress->elapsed_ms >= 1000) {
+            rdpq_text_printf(&(rdpq_textparms_t){
+                .align = ALIGN_RIGHT,
+                .width = 240,
+            }, 1, 640 - 330, 480 - 44, "%.1f MB/s, %lu s left",
+                progress->instant_rate, (unsigned long)((progress->eta_ms + 999) / 1000));
+        }
         rdpq_detach_show();
+        rspq_flush();
+
+        load_last_frame = now;
+        load_frames++;
     }
-    
+
+    return false;
 }
 
 float fade_v1[] = { 0, 0 };
@@ -123,14 +178,14 @@ static wav64_t se_gametitle_click;
 #define BOX_REGION_Y_MIN 16.0f
 #define BOX_REGION_Y_MAX 464.0f
 
-#define TITLE_BOX_WIDTH_E 256.0f
-#define TITLE_BOX_HEIGHT_E 179.0f
-
 #define TITLE_BOX_WIDTH_BORDER_E 257.0f
 #define TITLE_BOX_HEIGHT_BORDER_W 180.0f
 
 #define TITLE_SELECT_SCALE 1.2f
 
+#define LOADER_BUDGET_OPENING_US 12000
+#define LOADER_BUDGET_MENU_US 4000
+
 #define CHANNEL_SFX1    0
 #define CHANNEL_SFX2    2
 #define CHANNEL_SFX3    4
@@ -152,6 +207,7 @@ int fade_counter = FADE_DURATION;
 float fade_lvl = 1.0f;
 
 int main_state = 0;
+int loader_state = 0;
 int opening_counter = OPENING_WAIT;
 float opening_card_offset_x = 0.0f;
 
@@ -200,51 +256,16 @@ void outline_draw(float x, float y, float width, float height, float brightness)
     rdpq_fill_rectangle(x+width-OUTLINE_WIDTH, y, x+width, y+height);
 }
 
-typedef struct SquareSprite_s {
-    float x, y;
-    float width;
-    float height;
-} SquareSprite;
-
-typedef struct TitleBox_s {
-    char id[8];
-    sprite_t * image;
-    SquareSprite sprite;
-    float scale;
-    float scaleGrow;
-    float offset_x, offset_y;
-    int isSelected;
-    float selectedOutline;
-    float outlineCounter;
-    float screenX;
-    float screenY;
-} TitleBox;
-
 float title_brightness = 1.0f;
 
-#define MAX_TITLE_COUNT 40
+catalog_t catalog;
+// Cards without catalog.bin keep working from the old title list, launches then have nowhere to store play statistics
+bool catalog_legacy = false;
+int catalog_notice_timer = 0;
 
-int title_count = 0;
+#define CATALOG_NOTICE_FRAMES 600
 
-TitleBox title_list[MAX_TITLE_COUNT];
-
-#define TITLE_COLUMNS 4
-#define TITLE_ROWS 50
-#define TITLE_TOTAL_SLOTS (TITLE_ROWS * TITLE_COLUMNS)
-
-TitleBox * title_row[TITLE_ROWS][TITLE_COLUMNS] = {
-    {NULL, NULL, NULL, NULL},
-    {NULL, NULL, NULL, NULL},
-    {NULL, NULL, NULL, NULL},
-    {NULL, NULL, NULL, NULL},
-    {NULL, NULL, NULL, NULL},
-    {NULL, NULL, NULL, NULL},
-    {NULL, NULL, NULL, NULL},
-    {NULL, NULL, NULL, NULL},
-    {NULL, NULL, NULL, NULL},
-    {NULL, NULL, NULL, NULL}
-};
-int title_row_count[TITLE_ROWS] = {4,4,2,0,0,0,0,0,0,0};
+title_table_t title_table;
 
 TitleBox * selectedTitle = NULL;
 
@@ -253,7 +274,14 @@ int cursor_x_timer = 0;
 int cursor_y = 0;
 int cursor_y_timer = 0;
 
-void TitleBox_create(TitleBox * title, sprite_t * image, float x, float y) {
+// -1 keeps the grid stored in the catalog, otherwise one of the precomputed catalog orders
+int title_order = -1;
+int title_order_label_timer = 0;
+const char * title_order_labels[CATALOG_ORDER_COUNT] = { "A-Z", "Recently played", "Most played" };
+
+#define TITLE_ORDER_LABEL_FRAMES 90
+
+void TitleBox_create(TitleBox * title, box_art_t * image, float x, float y) {
     title->image = image;
     title->sprite.x = x;
     title->sprite.y = y;
@@ -267,9 +295,14 @@ void TitleBox_create(TitleBox * title, sprite_t * image, float x, float y) {
     title->outlineCounter = 0.0f;
 }
 
-void TitleBox_create2(TitleBox * title, sprite_t * image, char * id) {
-    memcpy(title->id, id, 8);
+void TitleBox_create2(TitleBox * title, box_art_t * image, catalog_record_t * record) {
+    // Record IDs fill all 8 bytes without a terminator, the copy is terminated for the path and log formats
+    memcpy(title->id, record->id, CATALOG_ID_LENGTH);
+    title->id[CATALOG_ID_LENGTH] = '\0';
+    title->record = record;
     title->image = image;
+    title->art_slot = ART_CACHE_NO_SLOT;
+    title->art_window = 0;
     title->sprite.x = 0.0f;
     title->sprite.y = 0.0f;
     title->sprite.width = TITLE_BOX_WIDTH_E;
@@ -299,13 +332,18 @@ void TitleBox_update(TitleBox * title) {
     }
 }
 
+float TitleBox_select_scale(TitleBox * title) {
+    float originalHeight = title->sprite.height * title->scale;
+    float scaleHeight = (originalHeight + 16) / originalHeight;
+    return title->scale * scaleHeight;
+}
+
 void TitleBox_draw(TitleBox * title) {
     float titleScale = title->scale;
     float originalWidth = title->sprite.width * title->scale;
     float originalHeight = title->sprite.height * title->scale;
     if(title->isSelected) {
-        float scaleHeight = (originalHeight + 16) / originalHeight;
-        float scaleFactor = titleScale * scaleHeight;
+        float scaleFactor = TitleBox_select_scale(title);
         titleScale = titleScale + title->scaleGrow * (scaleFactor - titleScale);
     }
 
@@ -339,10 +377,18 @@ void TitleBox_draw(TitleBox * title) {
         shadow_draw(shadowOffsetX, offsetY - (viewport_y - BOX_REGION_Y_MIN), shadowSizeX, shadowSizeY, 0.23f);
     }
     int b = title_brightness * 255.0f;
-    rdpq_set_prim_color(RGBA32(b, b, b, 255));
-    rdpq_sprite_blit(title->image, offsetX, offsetY - (viewport_y - BOX_REGION_Y_MIN), &(rdpq_blitparms_t){
-        .scale_x = titleScale, .scale_y = titleScale,
-    });
+    box_art_t * image = art_cache_lookup(title);
+    if(image == NULL) {
+        // Placeholder until the art is streamed in
+        int p = title_brightness * 72.0f;
+        rdpq_mode_combiner(RDPQ_COMBINER_FLAT);
+        rdpq_set_prim_color(RGBA32(p, p, p, 255));
+        rdpq_fill_rectangle(offsetX, offsetY - (viewport_y - BOX_REGION_Y_MIN), offsetX + scaledWidth, offsetY - (viewport_y - BOX_REGION_Y_MIN) + scaledHeight);
+        rdpq_mode_combiner(RDPQ_COMBINER_TEX_FLAT);
+    } else {
+        rdpq_set_prim_color(RGBA32(b, b, b, 255));
+        box_art_draw(image, offsetX, offsetY - (viewport_y - BOX_REGION_Y_MIN), titleScale);
+    }
 
     if(title->isSelected) {
         outline_draw(
@@ -434,7 +480,20 @@ void setRomPath(char * code) {
     strcat(rom_path, code);
     strcat(rom_path, "/");
     strcat(rom_path, code);
-    strcat(rom_path, "_e.z64");
+    // Titles stored as a compressed container have no raw ROM, byte-swapped dumps are converted while loading
+    const char * extensions[] = { "_e.z64", "_e" ROM_PACK_EXTENSION, "_e.v64", "_e.n64" };
+    size_t base_length = strlen(rom_path);
+    int count = sizeof(extensions) / sizeof(extensions[0]);
+    int i = 0;
+    do {
+        strcpy(rom_path + base_length, extensions[i]);
+    } while(!file_exists(rom_path) && ++i < count);
+    if(i == count) strcpy(rom_path + base_length, extensions[0]);
+    rom_packed = rom_pack_is_path(rom_path);
+    rom_order = rom_packed ? ROM_ORDER_Z64 : rom_order_from_extension(rom_path);
+}
+void getChunksPath(char * code, char * path, size_t size) {
+    snprintf(path, size, "sd:/menu/title/%s/%s_e.chk", code, code);
 }
 flashcart_save_type_t getSaveType(char * code) {
     char path[128];
@@ -459,103 +518,322 @@ flashcart_save_type_t getSaveType(char * code) {
 bool setupRomLoad(TitleBox * title) {
     setRomPath(title->id);
 
-    if(flashcart_load_rom(rom_path, false, cart_load_progress) != FLASHCART_OK) return false;
+    char save_path[128];
+    snprintf(save_path, sizeof(save_path), "sd:/menu/save/%s.sav", title->id);
+
+    // A valid profile from an earlier launch replaces the save type lookup, CIC detection and save sector walk
+    launch_profile_t profile;
+    uint32_t title_index = title->record - catalog.records;
+    bool cached = !launch_profile_load(title_index, title->id, rom_path, save_path, &profile);
+    if(cached && title->record->save_type != CATALOG_SAVE_TYPE_UNKNOWN && title->record->save_type != profile.save_type) {
+        cached = false;
+    }
 
-    flashcart_save_type_t save_type = getSaveType(title->id);
-    if(save_type == FLASHCART_SAVE_TYPE_NONE) {
-        if(flashcart_load_save(NULL, save_type) != FLASHCART_OK) return false;
+    // The ROM of the last launch usually survives the reset back to the menu, only the head holding the menu image is reloaded
+    resident_rom_t resident;
+    load_frames = 0;
+    memset(&load_stats, 0, sizeof(load_stats));
+    uint64_t load_start = get_ticks();
+    // Resident records and chunk lists describe raw ROM files, a container is always decoded in full
+    bool resident_loaded = !rom_packed && !resident_rom_check(title->id, rom_path, rom_order, &resident);
+    if(resident_loaded && flashcart_load_rom_head(rom_path, rom_order, RESIDENT_ROM_HEAD_SIZE) != FLASHCART_OK) {
+        resident_loaded = false;
+    }
+    // A revision or hack of the resident ROM only needs the chunks whose hashes differ
+    char chunks_path[128];
+    uint8_t changed[RESIDENT_ROM_CHANGED_SIZE];
+    uint32_t chunk_size = 0;
+    uint32_t changed_count = 0;
+    bool delta_loaded = false;
+    getChunksPath(title->id, chunks_path, sizeof(chunks_path));
+    if(!resident_loaded) {
+        delta_loaded = !rom_packed && !resident_rom_delta(rom_path, chunks_path, rom_order, &chunk_size, changed, &changed_count);
+        resident_rom_invalidate();
+        // A cancelled load leaves nothing to resume, the resident record is already gone and the next load starts over
+        if(delta_loaded) {
+            flashcart_err_t err = flashcart_load_rom_chunks(rom_path, rom_order, chunk_size, changed, cart_load_progress);
+            if(err == FLASHCART_ERR_CANCELLED) return false;
+            delta_loaded = (err == FLASHCART_OK) && !resident_rom_check_head();
+        }
+        if(!delta_loaded) {
+            if(flashcart_load_rom(rom_path, rom_order, cart_load_progress) != FLASHCART_OK) return false;
+        }
+    }
+    unsigned long load_ms = TICKS_TO_MS(get_ticks() - load_start);
+    if(load_ms == 0) load_ms = 1;
+    debugf("ROM load: %lu KiB in %lu ms, %lu KB/s, %d frames%s\n",
+        (unsigned long)(title->record->rom_size / 1024), load_ms, (unsigned long)(title->record->rom_size / load_ms), load_frames,
+        resident_loaded ? ", resident" : "");
+    if(delta_loaded) {
+        debugf("ROM delta: %lu of %lu chunks of %lu KiB loaded\n", (unsigned long)changed_count,
+            (unsigned long)((title->record->rom_size + chunk_size - 1) / chunk_size), (unsigned long)(chunk_size / 1024));
+    }
+    flashcart_flash_stats_t *flash = &load_stats.flash;
+    if(flash->blocks_programmed + flash->blocks_skipped > 0) {
+        debugf("ROM flash: %lu blocks programmed, %lu already matching\n",
+            (unsigned long)flash->blocks_programmed, (unsigned long)flash->blocks_skipped);
+        debugf("ROM flash: read %lu ms, verify %lu ms, erase %lu ms, program %lu ms, busy %lu ms\n",
+            (unsigned long)(flash->read_us / 1000), (unsigned long)(flash->verify_us / 1000), (unsigned long)(flash->erase_us / 1000),
+            (unsigned long)(flash->program_us / 1000), (unsigned long)(flash->busy_us / 1000));
+    }
+    // A resident relaunch already matched its sampled blocks, only data just read from SD is checked in full
+    if(!resident_loaded && !rom_packed && file_exists(VERIFY_LOADS_PATH)) {
+        uint64_t verify_start = get_ticks();
+        flashcart_err_t err = resident_rom_verify(rom_path, chunks_path, cart_load_progress);
+        if(err == FLASHCART_ERR_CANCELLED) return false;
+        if(err != FLASHCART_OK) {
+            debugf("ROM verify: %s\n", flashcart_convert_error_message(err));
+            return false;
+        }
+        unsigned long verify_ms = TICKS_TO_MS(get_ticks() - verify_start);
+        if(verify_ms == 0) verify_ms = 1;
+        debugf("ROM verify: %lu ms, %lu KB/s\n", verify_ms, (unsigned long)(title->record->rom_size / verify_ms));
+    }
+    if(!resident_loaded && !rom_packed && !resident_rom_store_chunks(rom_path, chunks_path) && !resident_rom_capture(title->id, rom_path, rom_order, &resident)) {
+        resident_rom_store(&resident);
+    }
+
+    // The save is loaded in one short read, a cancel is taken before it while the complete ROM stays resident
+    if(cart_load_cancel_pressed()) return false;
+
+    if(!cached) {
+        memset(&profile, 0, sizeof(profile));
+        profile.save_type = title->record->save_type;
+        if(title->record->save_type == CATALOG_SAVE_TYPE_UNKNOWN) {
+            profile.save_type = getSaveType(title->id);
+        }
+    }
+    if(profile.save_type == FLASHCART_SAVE_TYPE_NONE) {
+        if(flashcart_load_save(NULL, profile.save_type, NULL) != FLASHCART_OK) return false;
     } else {
-        char save_path[128];
-        directory_create("sd:/menu/save");
-        snprintf(save_path, sizeof(save_path), "sd:/menu/save/%s.sav", title->id);
-        if(flashcart_load_save(save_path, save_type) != FLASHCART_OK) return false;
+        if(!cached) directory_create("sd:/menu/save");
+        // Writeback overwrites the save in place, the result of the last session is kept first. Failing to keep it doesn't block the launch
+        uint64_t ring_start = get_ticks();
+        if(save_ring_rotate(save_path)) {
+            debugf("Save ring: couldn't keep the previous save of %s\n", title->id);
+        } else {
+            debugf("Save ring: %lu ms\n", (unsigned long)TICKS_TO_MS(get_ticks() - ring_start));
+        }
+        if(flashcart_load_save(save_path, profile.save_type, &profile.save_map) != FLASHCART_OK) return false;
     }
 
     //boot_params.reset_type = BOOT_RESET_TYPE_NMI;
     boot_params.device_type = BOOT_DEVICE_TYPE_ROM;
     boot_params.tv_type = BOOT_TV_TYPE_PASSTHROUGH;
-    boot_params.detect_cic_seed = true;
+    boot_params.detect_cic_seed = false;
+
+    if(cached) {
+        boot_params.cic_seed = profile.cic_seed;
+    } else {
+        boot_detect_cic_seed(&boot_params);
+        profile.cic_seed = boot_params.cic_seed;
+        if(!launch_profile_capture(title->id, rom_path, save_path, &profile)) {
+            launch_profile_store(title_index, &profile);
+        }
+    }
+
+    // Play statistics only touch the record and two orders in place, failing to store them doesn't block the launch
+    catalog_record_play(&catalog, title_index);
+    if(!catalog_legacy) catalog_store_plays(CATALOG_PATH, &catalog, title_index);
 
     menu_active = false;
     return true;
 }
 
-void load_titles() {
-    int row_max = TITLE_COLUMNS;
-
-    //row_max = 4; // Quick hack to reduce the number of titles per row
+// Packed art reads its level table and smallest level first, a sprite file is read whole
+size_t title_art_size(TitleBox * title) {
+    if(art_pack_is_open() && title->record->sprite_size > 0) {
+        return title->record->sprite_size;
+    }
+    char filename[64];
+    snprintf(filename, sizeof(filename), "sd:/menu/title/%s/%s_e.sprite", title->id, title->id);
+    return file_get_size(filename);
+}
 
-    char pathstr[256];
-    strcpy(pathstr, "sd:/menu/title/");
-    
-    FILE * f = fopen("sd://menu/title.csv", "r");
-    if(f != NULL){
-        setvbuf(f, NULL, _IONBF, 0);
-        fseek(f, 0, SEEK_END);
-        int csvsize = ftell(f);
-        fseek(f, 0, SEEK_SET);
-        fread(pathstr, 1, csvsize, f);
-        fclose(f);
-        char * pathstritr = pathstr;
-        char flbuf[8];
-        int flbfpos = 0;
-        title_count = 0;
-        do {
-            if(*pathstritr == ',' || *pathstritr == ' ' || *pathstritr == 0x0) {
-                if(flbfpos != 0) {
-                    char filename[64];
-                    flbuf[flbfpos] = 0;
-                    strcpy(filename, "sd:/menu/title/");
-                    strcat(filename, flbuf);
-                    strcat(filename, "/");
-                    strcat(filename, flbuf);
-                    strcat(filename, "_e.sprite");
-                    TitleBox_create2(&title_list[title_count], sprite_load(filename), flbuf);
-                    title_row[title_count/row_max][title_count%row_max] = &title_list[title_count];
-                    title_count++;
-                }
-                flbfpos = 0;
-            } else {
-                flbuf[flbfpos] = *pathstritr;
-                flbfpos++;
-            }
-            pathstritr++;
-        } while(*pathstritr != 0x00);
+box_art_t * title_art_load(TitleBox * title) {
+    if(art_pack_is_open() && title->record->sprite_size > 0) {
+        return box_art_load_pack(title->record->sprite_offset, title->record->sprite_size);
     }
+    char filename[64];
+    snprintf(filename, sizeof(filename), "sd:/menu/title/%s/%s_e.sprite", title->id, title->id);
+    return box_art_load_sprite(filename);
+}
+
+void title_art_unload(TitleBox * title, box_art_t * image) {
+    box_art_free(image);
+}
+
+// Level closest to the size the title is drawn at
+int title_art_wanted_level(TitleBox * title, box_art_t * image) {
+    float scale = title->isSelected ? TitleBox_select_scale(title) : title->scale;
+    return box_art_closest_level(image, scale);
+}
+
+size_t title_art_refine_size(TitleBox * title, box_art_t * image, uint32_t window) {
+    return box_art_level_load_size(image, title_art_wanted_level(title, image), window);
+}
+
+// Keep the smallest level as a fallback plus the one closest to the size the title is drawn at
+bool title_art_refine(TitleBox * title, box_art_t * image, uint32_t window) {
+    int wanted = title_art_wanted_level(title, image);
+    int smallest = image->level_count - 1;
+    bool changed = false;
 
-    for(int y = 0; y < TITLE_ROWS; y++) { 
-        int row_count = 0;
-        for(int x = 0; x < row_max; x++) {
-            if(title_row[y][x] != NULL) row_count++;
+    for(int i = 0; i < smallest; i++) {
+        if(i != wanted && box_art_level_loaded(image, i)) {
+            box_art_release_level(image, i);
+            changed = true;
         }
-        title_row_count[y] = row_count;
     }
-    
-    float currentRowY = box_region_min_y;
-    for(int y = 0; y < TITLE_ROWS; y++) {
-        int currentRowCount = title_row_count[y];
-        if(currentRowCount == 0) continue;
-        float rowScale = 1.0f;
-        if(currentRowCount > 2) {
-            rowScale = (BOX_REGION_X_MAX - BOX_REGION_X_MIN)  / (currentRowCount * TITLE_BOX_WIDTH_E);
-        }
-        float scaledTitleX = TITLE_BOX_WIDTH_E * rowScale;
-        
-        for(int x = 0; x < row_max; x++) {
-            TitleBox * current = title_row[y][x];
-            if(current == NULL) continue;
-            current->scale = rowScale;
+    if(!box_art_level_loaded(image, wanted) && !box_art_load_level(image, wanted, window)) {
+        changed = true;
+    }
 
-            current->sprite.x = box_region_min_x + scaledTitleX * x;
-            current->sprite.y = currentRowY;
+    return changed;
+}
 
+// Places every title following an order without sorting, keeps the cursor on the given title
+bool title_order_apply(int order, TitleBox * keep) {
+    int ordered_rows = (catalog.count + TITLE_COLUMNS - 1) / TITLE_COLUMNS;
+    if(title_table_reset(&title_table, order < 0 ? catalog.header->row_count : ordered_rows)) {
+        return false;
+    }
+
+    for(int i = 0; i < catalog.count; i++) {
+        int index = i;
+        int row, column;
+        if(order < 0) {
+            row = catalog.records[i].grid_row;
+            column = catalog.records[i].grid_column;
+        } else {
+            index = catalog_order_get(&catalog, order, i);
+            row = i / TITLE_COLUMNS;
+            column = i % TITLE_COLUMNS;
+        }
+        title_table_place(&title_table, index, row, column);
+        if(keep == &title_table.titles[index]) {
+            cursor_y = row;
+            cursor_x = column;
         }
-        currentRowY += TITLE_BOX_HEIGHT_E * rowScale;
     }
+    title_order = order;
+
+    float currentRowY = title_table_layout(&title_table, box_region_min_x, BOX_REGION_X_MAX, box_region_min_y);
 
+    box_region_max_y = BOX_REGION_Y_MAX;
     if(currentRowY > SCREEN_HEIGHT) {
         box_region_max_y = currentRowY;
     }
+
+    return true;
+}
+
+void load_titles() {
+    if(catalog_load(CATALOG_PATH, &catalog)) {
+        if(catalog_load_csv(CATALOG_CSV_PATH, &catalog)) {
+            return;
+        }
+        debugf("Catalog: menu/catalog.bin is missing or invalid, titles come from menu/title.csv, run n64menu-tool catalog to convert the card\n");
+        catalog_legacy = true;
+        catalog_notice_timer = CATALOG_NOTICE_FRAMES;
+    }
+
+    // Room for the stored grid and for the packed rows of the precomputed orders, whichever is taller
+    int ordered_rows = (catalog.count + TITLE_COLUMNS - 1) / TITLE_COLUMNS;
+    int row_capacity = (int)catalog.header->row_count > ordered_rows ? (int)catalog.header->row_count : ordered_rows;
+    if(title_table_create(&title_table, catalog.count, row_capacity)) {
+        catalog_free(&catalog);
+        return;
+    }
+
+    for(int i = 0; i < catalog.count; i++) {
+        TitleBox_create2(&title_table.titles[i], NULL, &catalog.records[i]);
+    }
+
+    art_pack_open(ART_PACK_PATH);
+    art_cache_init(ART_CACHE_BUDGET, title_art_size, title_art_load, title_art_unload, title_art_refine, title_art_refine_size);
+
+    // A grid that can't be placed falls back to file order, which always fits
+    if(!title_order_apply(-1, NULL) && !title_order_apply(CATALOG_ORDER_NAME, NULL)) {
+        debugf("Titles: couldn't place %lu titles\n", (unsigned long)catalog.count);
+    }
+}
+
+// Z cycles the orders, L and R jump to the previous and next first letter of the A-Z order
+void title_order_update() {
+    if(main_state != 3 || cursor_x < 0 || selectedTitle == NULL) {
+        return;
+    }
+
+    if(p1_buttons_press.z) {
+        int order = title_order + 1;
+        if(order >= CATALOG_ORDER_COUNT) order = -1;
+        if(title_order_apply(order, selectedTitle)) {
+            title_order_label_timer = (order < 0) ? 0 : TITLE_ORDER_LABEL_FRAMES;
+            wav64_play(&se_gametitle_cursor, CHANNEL_SFX1);
+        } else {
+            wav64_play(&se_cursor_ng, CHANNEL_SFX1);
+        }
+    } else if(p1_buttons_press.l || p1_buttons_press.r) {
+        if(title_order != CATALOG_ORDER_NAME && !title_order_apply(CATALOG_ORDER_NAME, selectedTitle)) {
+            wav64_play(&se_cursor_ng, CHANNEL_SFX1);
+            return;
+        }
+        // Ordered rows are always full, the cursor is the position in the order
+        uint32_t position = (cursor_y * TITLE_COLUMNS) + cursor_x;
+        uint32_t target = catalog_letter_jump(&catalog, position, p1_buttons_press.r ? 1 : -1);
+        if(target == position) {
+            wav64_play(&se_cursor_ng, CHANNEL_SFX1);
+        } else {
+            cursor_y = target / TITLE_COLUMNS;
+            cursor_x = target % TITLE_COLUMNS;
+            wav64_play(&se_gametitle_cursor, CHANNEL_SFX1);
+        }
+        title_order_label_timer = TITLE_ORDER_LABEL_FRAMES;
+    }
+
+    if(title_order_label_timer > 0) {
+        title_order_label_timer--;
+    }
+}
+
+// The launch then keeps the save ring without reading the save, the title.csv fallback has no recent order to find it
+void save_ring_settle_last_played() {
+    uint16_t * recent = catalog.orders[CATALOG_ORDER_RECENT];
+    if(catalog_legacy || recent == NULL || catalog.count == 0 || catalog.records[recent[0]].play_count == 0) {
+        return;
+    }
+    char save_path[128];
+    snprintf(save_path, sizeof(save_path), "sd:/menu/save/%.*s.sav", CATALOG_ID_LENGTH, catalog.records[recent[0]].id);
+    uint64_t settle_start = get_ticks();
+    if(save_ring_settle(save_path)) {
+        debugf("Save ring: couldn't settle %s\n", save_path);
+    } else {
+        debugf("Save ring: settled in %lu ms\n", (unsigned long)TICKS_TO_MS(get_ticks() - settle_start));
+    }
+}
+
+// Spreads title loading over the opening frames, one time slice per frame
+void loader_update(uint32_t budget_us) {
+    switch(loader_state) {
+        case 0: // Catalog and layout
+            load_titles();
+            loader_state = 1;
+            break;
+        case 1: { // Art of the first screen
+            int first_row, last_row;
+            if(title_table_rows_in_range(&title_table, viewport_y, viewport_y_bottom, &first_row, &last_row) ||
+            !art_cache_update(&title_table, first_row, last_row, budget_us)) {
+                loader_state = 2;
+            }
+            break;
+        }
+        case 2: // Save ring of the title played last, its writeback is flushed by now
+            save_ring_settle_last_played();
+            loader_state = 3;
+            break;
+        default: case 3: break; // Ready, menu_update streams the rest
+    }
 }
 
 float gametitle_fade = 0.0f;
@@ -566,13 +844,15 @@ void menu_update() {
 
     menu_sidebar_update(&menu_sidebar);
 
+    title_order_update();
+
     int prev_cursor_x = cursor_x;
     int prev_cursor_y = cursor_y;
 
     int limit_reached = 0;
     int cursor_move = 0;
 
-    int currentRowCount = title_row_count[cursor_y];
+    int currentRowCount = title_table_row_size(&title_table, cursor_y);
 
     if(main_state == 3) {
         int input_x = 0;
@@ -648,17 +928,17 @@ void menu_update() {
         if(cursor_y < 0) {
             if(prev_cursor_y != cursor_y) limit_reached = 1;
             cursor_y = 0;
-        } else if (cursor_y >= TITLE_ROWS) {
+        } else if (cursor_y >= title_table.row_count) {
             if(prev_cursor_y != cursor_y) limit_reached = 1;
-            cursor_y = TITLE_ROWS-1;
+            cursor_y = title_table.row_count > 0 ? title_table.row_count - 1 : 0;
         }
 
         // Next row?
-        int rowCount = title_row_count[cursor_y];
-        if(rowCount == 0) {
+        int rowCount = title_table_row_size(&title_table, cursor_y);
+        if(rowCount == 0 && cursor_y > 0) {
             cursor_y--;
             limit_reached = 1;
-            rowCount = title_row_count[cursor_y];
+            rowCount = title_table_row_size(&title_table, cursor_y);
         } else {
             if(prev_cursor_y != cursor_y) cursor_move = 1;
         }
@@ -703,10 +983,11 @@ void menu_update() {
     }
 
     if(cursor_x >= 0) {
-        TitleBox * cur = title_row[cursor_y][cursor_x];
+        TitleBox * cur = title_table_get(&title_table, cursor_y, cursor_x);
         if(cur != NULL) {
-            if(selectedTitle != NULL) {
+            if(selectedTitle != NULL && selectedTitle != cur) {
                 selectedTitle->isSelected = 0;
+                TitleBox_update(selectedTitle);
             }
             cur->isSelected = 1;
             selectedTitle = cur;
@@ -714,6 +995,7 @@ void menu_update() {
     } else {
         if(selectedTitle != NULL) {
             selectedTitle->isSelected = 0;
+            TitleBox_update(selectedTitle);
         }
         selectedTitle = NULL;
     }
@@ -728,12 +1010,9 @@ void menu_update() {
 
     
 
-    for(int y = 0; y < TITLE_ROWS; y++) {
-        for(int x = 0; x < TITLE_COLUMNS; x++) {
-            TitleBox * current = title_row[y][x];
-            if(current == NULL) continue;
-            TitleBox_update(current);
-        }
+    // Only the selected title animates, the others were reset when they lost the selection
+    if(selectedTitle != NULL) {
+        TitleBox_update(selectedTitle);
     }
 
     if(selectedTitle) {
@@ -755,6 +1034,11 @@ void menu_update() {
 
     viewport_y_bottom = viewport_y + (BOX_REGION_Y_MAX - BOX_REGION_Y_MIN);
 
+    int first_row, last_row;
+    if(!title_table_rows_in_range(&title_table, viewport_y - ART_CACHE_MARGIN, viewport_y_bottom + ART_CACHE_MARGIN, &first_row, &last_row)) {
+        art_cache_update(&title_table, first_row, last_row, LOADER_BUDGET_MENU_US);
+    }
+
     // fade out
     if(main_state > 3) {
         switch(main_state) {
@@ -805,9 +1089,15 @@ void menu_draw() {
         
         rdpq_mode_filter(FILTER_BILINEAR);
 
-        for(int y = 0; y < TITLE_ROWS; y++) {
+        // Rows outside the viewport are skipped without touching their titles
+        int first_row, last_row;
+        if(title_table_rows_in_range(&title_table, viewport_y, viewport_y_bottom, &first_row, &last_row)) {
+            first_row = 0;
+            last_row = -1;
+        }
+        for(int y = first_row; y <= last_row; y++) {
             for(int x = 0; x < TITLE_COLUMNS; x++) {
-                TitleBox * current = title_row[y][x];
+                TitleBox * current = title_table_get(&title_table, y, x);
                 if(current == NULL || current == selectedTitle) continue;
                 TitleBox_draw(current);
             }
@@ -860,17 +1150,20 @@ void update(int ovfl) {
     if(fade_state == 1 && main_state == 0) {
         main_state = 1;
     }
+    if(main_state < 2) {
+        loader_update(LOADER_BUDGET_OPENING_US);
+    }
     switch(main_state) {
         default: case 0: break; // Wait Fade
         case 1: // Wait logo
-            opening_counter--;
+            if(opening_counter > 0) opening_counter--;
             if(opening_counter == OPENING_SOUND_PLAY) {
                 
                 wav64_play(&se_titlelogo, CHANNEL_SFX1);
             }
-            if(opening_counter == 0) {
+            // Leave the logo as soon as the first screen is loaded
+            if(opening_counter == 0 && loader_state >= 2) {
                 main_state = 2;
-                load_titles();
                 opening_counter = OPENING_OUT;
             }
         break;
@@ -921,6 +1214,21 @@ void draw(int cur_frame) {
         rdpq_triangle(&TRIFMT_FILL, fade_v1, fade_v4, fade_v2);
     }
 
+    if(title_order_label_timer > 0 && title_order >= 0) {
+        rdpq_text_printf(&(rdpq_textparms_t){
+            .align = ALIGN_RIGHT,
+            .width = 400,
+        }, 1, 208, 40, "%s", title_order_labels[title_order]);
+    }
+
+    if(catalog_notice_timer > 0) {
+        catalog_notice_timer--;
+        rdpq_text_printf(&(rdpq_textparms_t){
+            .align = ALIGN_RIGHT,
+            .width = 400,
+        }, 1, 208, 440, "Old title.csv list, run n64menu-tool catalog");
+    }
+
     // For measuring performance
     /*float fps = display_get_fps();
     rdpq_text_printf(&(rdpq_textparms_t){
@@ -928,6 +1236,16 @@ void draw(int cur_frame) {
         .width = 400,
     }, 1, 32, 55, "FPS: %.4f", fps);*/
 
+    // For sizing the box art budget
+    /*art_cache_stats_t art_stats;
+    art_cache_get_stats(&art_stats);
+    rdpq_text_printf(&(rdpq_textparms_t){
+        .align = ALIGN_LEFT,
+        .width = 400,
+    }, 1, 32, 70, "Art: %d res %u/%u KiB hit %lu miss %lu evict %lu mip %lu",
+        art_stats.resident, art_stats.bytes_used / 1024, art_stats.budget / 1024,
+        art_stats.hits, art_stats.misses, art_stats.evictions, art_stats.refines);*/
+
     rdpq_detach_show();
 }
 
@@ -0,0 +1,324 @@
+#include <libdragon.h>
+
+#include "../utils/utils.h"
+
+#include "art_cache.h"
+#include "box_art.h"
+
+
+#define SLOT_NONE       (ART_CACHE_NO_SLOT)
+#define SLOT_FAILED     (-2)
+#define SLOT_DEFERRED   (-3)
+
+
+typedef struct {
+    TitleBox *owner;
+    box_art_t *art;
+    size_t size;
+    uint32_t stamp;
+    int prev;
+    int next;
+} art_cache_slot_t;
+
+
+static art_cache_slot_t slots[ART_CACHE_MAX_SLOTS];
+static int lru_head = SLOT_NONE;
+static int lru_tail = SLOT_NONE;
+static int free_head = SLOT_NONE;
+static uint32_t current_stamp;
+static uint32_t window_generation;
+static int window_first_row;
+static int window_last_row = -1;
+static art_cache_size_t *size_callback;
+static art_cache_load_t *load_callback;
+static art_cache_unload_t *unload_callback;
+static art_cache_refine_t *refine_callback;
+static art_cache_refine_size_t *refine_size_callback;
+static art_cache_stats_t stats;
+
+
+static void lru_unlink (int index) {
+    art_cache_slot_t *slot = &slots[index];
+
+    if (slot->prev != SLOT_NONE) {
+        slots[slot->prev].next = slot->next;
+    } else {
+        lru_head = slot->next;
+    }
+
+    if (slot->next != SLOT_NONE) {
+        slots[slot->next].prev = slot->prev;
+    } else {
+        lru_tail = slot->prev;
+    }
+
+    slot->prev = SLOT_NONE;
+    slot->next = SLOT_NONE;
+}
+
+static void lru_push_front (int index) {
+    art_cache_slot_t *slot = &slots[index];
+
+    slot->prev = SLOT_NONE;
+    slot->next = lru_head;
+
+    if (lru_head != SLOT_NONE) {
+        slots[lru_head].prev = index;
+    }
+    lru_head = index;
+
+    if (lru_tail == SLOT_NONE) {
+        lru_tail = index;
+    }
+}
+
+static void slot_touch (int index) {
+    slots[index].stamp = current_stamp;
+    if (lru_head != index) {
+        lru_unlink(index);
+        lru_push_front(index);
+    }
+}
+
+static void slot_release (int index) {
+    art_cache_slot_t *slot = &slots[index];
+
+    lru_unlink(index);
+
+    unload_callback(slot->owner, slot->art);
+    stats.bytes_used -= slot->size;
+    stats.resident -= 1;
+
+    slot->owner->image = NULL;
+    slot->owner->art_slot = SLOT_NONE;
+    slot->owner = NULL;
+    slot->art = NULL;
+    slot->size = 0;
+
+    slot->next = free_head;
+    free_head = index;
+}
+
+static bool evict_one (void) {
+    // NOTE: Sprites touched during the current update are inside the viewport window and must stay resident
+    int index = lru_tail;
+    if ((index == SLOT_NONE) || (slots[index].stamp == current_stamp)) {
+        return false;
+    }
+    slot_release(index);
+    stats.evictions += 1;
+    return true;
+}
+
+static bool make_room (size_t size) {
+    while ((free_head == SLOT_NONE) || ((stats.bytes_used + size) > stats.budget)) {
+        if (!evict_one()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// NOTE: Failed and deferred titles are retried once the window moves, a transient read error doesn't hide the art for good
+static bool title_pending (TitleBox *title) {
+    if ((title->art_slot == SLOT_FAILED) || (title->art_slot == SLOT_DEFERRED)) {
+        return (title->art_window != window_generation);
+    }
+    return (title->art_slot == SLOT_NONE);
+}
+
+static void title_defer (TitleBox *title) {
+    title->art_slot = SLOT_DEFERRED;
+    title->art_window = window_generation;
+    stats.deferrals += 1;
+}
+
+static bool load_title (TitleBox *title) {
+    // NOTE: Art that can't fit next to the window is left on the card instead of being read only to be dropped again
+    size_t estimate = (size_callback != NULL) ? size_callback(title) : 0;
+    if (!make_room(estimate)) {
+        title_defer(title);
+        return false;
+    }
+
+    stats.misses += 1;
+
+    box_art_t *art = load_callback(title);
+
+    if (art == NULL) {
+        title->art_slot = SLOT_FAILED;
+        title->art_window = window_generation;
+        stats.failures += 1;
+        return true;
+    }
+
+    size_t size = art->size;
+
+    if (!make_room(size)) {
+        unload_callback(title, art);
+        title_defer(title);
+        return false;
+    }
+
+    int index = free_head;
+    art_cache_slot_t *slot = &slots[index];
+    free_head = slot->next;
+
+    slot->owner = title;
+    slot->art = art;
+    slot->size = size;
+    lru_push_front(index);
+    slot_touch(index);
+
+    title->image = art;
+    title->art_slot = index;
+
+    stats.loads += 1;
+    stats.resident += 1;
+    stats.bytes_used += size;
+    if (stats.bytes_used > stats.bytes_peak) {
+        stats.bytes_peak = stats.bytes_used;
+    }
+
+    return true;
+}
+
+static bool refine_title (TitleBox *title, bool *refined) {
+    art_cache_slot_t *slot = &slots[title->art_slot];
+
+    *refined = false;
+
+    // NOTE: Extra levels are only loaded once there is room for them, evicting what is outside the window first
+    size_t size = (refine_size_callback != NULL) ? refine_size_callback(title, slot->art, window_generation) : 0;
+    while ((stats.bytes_used + size) > stats.budget) {
+        if (!evict_one()) {
+            return false;
+        }
+    }
+
+    if (!refine_callback(title, slot->art, window_generation)) {
+        return true;
+    }
+
+    *refined = true;
+
+    stats.bytes_used = stats.bytes_used - slot->size + slot->art->size;
+    slot->size = slot->art->size;
+    stats.refines += 1;
+    if (stats.bytes_used > stats.bytes_peak) {
+        stats.bytes_peak = stats.bytes_used;
+    }
+
+    return true;
+}
+
+static int window_row (int first_row, int last_row, int step) {
+    int middle = (first_row + last_row) / 2;
+    int distance = (step + 1) / 2;
+    return (step % 2) ? (middle - distance) : (middle + distance);
+}
+
+
+void art_cache_init (size_t budget, art_cache_size_t *size, art_cache_load_t *load, art_cache_unload_t *unload, art_cache_refine_t *refine, art_cache_refine_size_t *refine_size) {
+    art_cache_clear();
+
+    size_callback = size;
+    load_callback = load;
+    unload_callback = unload;
+    refine_callback = refine;
+    refine_size_callback = refine_size;
+
+    stats = (art_cache_stats_t) {
+        .budget = budget,
+    };
+}
+
+void art_cache_clear (void) {
+    while (lru_head != SLOT_NONE) {
+        slot_release(lru_head);
+    }
+
+    lru_head = SLOT_NONE;
+    lru_tail = SLOT_NONE;
+    free_head = SLOT_NONE;
+
+    for (int i = ART_CACHE_MAX_SLOTS - 1; i >= 0; i--) {
+        slots[i] = (art_cache_slot_t) {
+            .prev = SLOT_NONE,
+            .next = free_head,
+        };
+        free_head = i;
+    }
+}
+
+box_art_t *art_cache_lookup (TitleBox *title) {
+    if (title->art_slot < 0) {
+        return NULL;
+    }
+
+    slot_touch(title->art_slot);
+
+    return slots[title->art_slot].art;
+}
+
+bool art_cache_update (title_table_t *table, int first_row, int last_row, uint32_t budget_us) {
+    uint32_t start = TICKS_READ();
+
+    current_stamp += 1;
+
+    if ((first_row != window_first_row) || (last_row != window_last_row)) {
+        window_first_row = first_row;
+        window_last_row = last_row;
+        window_generation += 1;
+    }
+
+    for (int y = first_row; y <= last_row; y++) {
+        for (int x = 0; x < TITLE_COLUMNS; x++) {
+            TitleBox *title = title_table_get(table, y, x);
+            if ((title != NULL) && (title->art_slot >= 0)) {
+                // NOTE: Hits and misses are counted once per title entering the window, not on every draw
+                if (slots[title->art_slot].stamp != (current_stamp - 1)) {
+                    stats.hits += 1;
+                }
+                slot_touch(title->art_slot);
+            }
+        }
+    }
+
+    // Load missing art starting from the middle of the window, then refine resident art in the same order.
+    // At least one title is processed per call.
+    int steps = ((last_row - first_row) + 1) * 2;
+    int work = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int step = 0; step < steps; step++) {
+            int y = window_row(first_row, last_row, step);
+            if ((y < first_row) || (y > last_row)) {
+                continue;
+            }
+            for (int x = 0; x < TITLE_COLUMNS; x++) {
+                TitleBox *title = title_table_get(table, y, x);
+                if ((title == NULL) || ((pass == 0) ? !title_pending(title) : (title->art_slot < 0))) {
+                    continue;
+                }
+                if ((work > 0) && (TICKS_DISTANCE(start, TICKS_READ()) >= TICKS_FROM_US(budget_us))) {
+                    return true;
+                }
+                bool worked = true;
+                if (!((pass == 0) ? load_title(title) : refine_title(title, &worked))) {
+                    // NOTE: Byte budget is exhausted by art inside the window, nothing more can be loaded
+                    return false;
+                }
+                if (worked) {
+                    work += 1;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void art_cache_get_stats (art_cache_stats_t *stats_out) {
+    *stats_out = stats;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file art_cache.h
+ * @brief Box art LRU cache
+ * @ingroup menu
+ */
+
+#ifndef MENU_ART_CACHE_H__
+#define MENU_ART_CACHE_H__
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "title_table.h"
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+/** @brief Default resident box art budget in bytes */
+#define ART_CACHE_BUDGET        (2 * 1024 * 1024)
+/** @brief Distance in pixels above and below the viewport kept resident */
+#define ART_CACHE_MARGIN        (240.0f)
+/** @brief Maximum number of resident sprites */
+#define ART_CACHE_MAX_SLOTS     (64)
+/** @brief Value of TitleBox::art_slot when the art isn't resident */
+#define ART_CACHE_NO_SLOT       (-1)
+
+/** @brief Loads box art of the title, returns NULL on failure */
+typedef struct box_art_s *art_cache_load_t (TitleBox *title);
+/** @brief Resident size the art of the title is expected to take once loaded, 0 when unknown */
+typedef size_t art_cache_size_t (TitleBox *title);
+/** @brief Releases box art returned by the load callback */
+typedef void art_cache_unload_t (TitleBox *title, struct box_art_s *art);
+/** @brief Loads or drops levels of resident box art, returns true if the resident size changed. `window` changes whenever the window moves. */
+typedef bool art_cache_refine_t (TitleBox *title, struct box_art_s *art, uint32_t window);
+/** @brief Resident size the next refine of the art is expected to add at most, 0 when it loads nothing */
+typedef size_t art_cache_refine_size_t (TitleBox *title, struct box_art_s *art, uint32_t window);
+
+/**
+ * @brief Box art cache counters.
+ *
+ * A miss is art read from the SD card, a hit is resident art coming back into the window.
+ */
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t loads;
+    uint32_t refines;
+    uint32_t evictions;
+    uint32_t failures;
+    uint32_t deferrals;
+    size_t bytes_used;
+    size_t bytes_peak;
+    size_t budget;
+    int resident;
+} art_cache_stats_t;
+
+
+void art_cache_init (size_t budget, art_cache_size_t *size, art_cache_load_t *load, art_cache_unload_t *unload, art_cache_refine_t *refine, art_cache_refine_size_t *refine_size);
+void art_cache_clear (void);
+struct box_art_s *art_cache_lookup (TitleBox *title);
+bool art_cache_update (title_table_t *table, int first_row, int last_row, uint32_t budget_us);
+void art_cache_get_stats (art_cache_stats_t *stats);
+
+/** @} */ /* menu */
+
+
+#endif
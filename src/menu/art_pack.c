@@ -0,0 +1,80 @@
+#include <malloc.h>
+#include <stdlib.h>
+
+#include <fatfs/ff.h>
+
+#include "../utils/fs.h"
+#include "../utils/utils.h"
+
+#include "art_pack.h"
+
+
+static FIL pack_fil;
+static bool pack_open = false;
+static uint32_t pack_size;
+
+
+bool art_pack_open (char *path) {
+    art_pack_header_t header __attribute__((aligned(8)));
+    UINT br;
+
+    art_pack_close();
+
+    if (f_open(&pack_fil, strip_sd_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    if ((f_read(&pack_fil, &header, sizeof(header), &br) != FR_OK) || (br != sizeof(header))) {
+        f_close(&pack_fil);
+        return true;
+    }
+
+    if ((header.magic != ART_PACK_MAGIC) || (header.version != ART_PACK_VERSION) || (header.entry_size != sizeof(art_pack_entry_t))) {
+        f_close(&pack_fil);
+        return true;
+    }
+
+    pack_size = f_size(&pack_fil);
+    pack_open = true;
+
+    return false;
+}
+
+void art_pack_close (void) {
+    if (pack_open) {
+        f_close(&pack_fil);
+        pack_open = false;
+    }
+}
+
+bool art_pack_is_open (void) {
+    return pack_open;
+}
+
+void *art_pack_read (uint32_t offset, uint32_t size) {
+    UINT br;
+
+    if (!pack_open || ((offset % ART_PACK_ALIGNMENT) != 0)) {
+        return NULL;
+    }
+
+    // NOTE: Entries are padded to the sector size, reading whole sectors lets FatFs
+    //       transfer straight into the destination buffer without going through its sector cache.
+    size_t read_size = ALIGN(size, ART_PACK_ALIGNMENT);
+
+    if ((size == 0) || ((offset + read_size) > pack_size)) {
+        return NULL;
+    }
+
+    void *buffer = memalign(16, read_size);
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    if ((f_lseek(&pack_fil, offset) != FR_OK) || (f_read(&pack_fil, buffer, read_size, &br) != FR_OK) || (br != read_size)) {
+        free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
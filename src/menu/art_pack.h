@@ -0,0 +1,106 @@
+/**
+ * @file art_pack.h
+ * @brief Packed box art file
+ * @ingroup menu
+ */
+
+#ifndef MENU_ART_PACK_H__
+#define MENU_ART_PACK_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+#define ART_PACK_PATH           "sd:/menu/art.pak"
+
+#define ART_PACK_MAGIC          (0x4E363441UL)  /* "N64A" */
+#define ART_PACK_VERSION        (3)
+#define ART_PACK_ALIGNMENT      (512)
+/** @brief Maximum number of mip levels per title, each one half the size of the previous */
+#define ART_PACK_MAX_LEVELS     (3)
+
+/** @brief Image pixel formats, values match libdragon tex_format_t */
+#define ART_PACK_FORMAT_RGBA16  (2)
+#define ART_PACK_FORMAT_CI8     (9)
+
+#define ART_PACK_COMPRESSION_NONE   (0)
+#define ART_PACK_COMPRESSION_LZ     (1)
+
+/**
+ * @brief Art pack header.
+ *
+ * Big-endian, followed by `entry_count` entries at `entries_offset`.
+ * Every entry and every level within it starts on an SD sector boundary and is zero padded to the next one.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;
+    uint32_t entry_count;
+    uint32_t entries_offset;
+    uint32_t data_offset;
+    uint32_t __reserved[3];
+} art_pack_header_t;
+
+/** @brief Art pack entry, `flags` holds the compression and `size` covers every level. */
+typedef struct {
+    char id[8];
+    uint32_t offset;
+    uint32_t size;
+    uint16_t width;
+    uint16_t height;
+    uint8_t format;
+    uint8_t flags;
+    uint8_t level_count;
+    uint8_t __reserved[9];
+} art_pack_entry_t;
+
+/**
+ * @brief Level table at the start of every entry.
+ *
+ * Level 0 is the full size image. The smallest level directly follows the table, so the catalog record
+ * size covers the table and that level only and one read is enough to show the title.
+ * Offsets are relative to the entry start.
+ */
+typedef struct {
+    uint8_t level_count;
+    uint8_t __reserved_1;
+    uint16_t width;
+    uint16_t height;
+    uint16_t __reserved_2;
+    uint32_t level_offset[ART_PACK_MAX_LEVELS];
+    uint32_t level_size[ART_PACK_MAX_LEVELS];
+} art_pack_levels_t;
+
+/**
+ * @brief Header of every image stored in the pack.
+ *
+ * Followed by `stored_size` bytes which decode to `data_size` bytes: the palette of `palette_colors` RGBA16 entries
+ * padded to 8 bytes, then the pixels with a stride of `width` texels.
+ */
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t format;
+    uint8_t compression;
+    uint16_t palette_colors;
+    uint32_t data_size;
+    uint32_t stored_size;
+} art_pack_image_t;
+
+
+bool art_pack_open (char *path);
+void art_pack_close (void);
+bool art_pack_is_open (void);
+void *art_pack_read (uint32_t offset, uint32_t size);
+
+/** @} */ /* menu */
+
+
+#endif
@@ -0,0 +1,271 @@
+#include <malloc.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "../utils/utils.h"
+
+#include "art_pack.h"
+#include "box_art.h"
+#include "lz.h"
+
+
+#define TLUT_COLORS     (256)
+
+
+static size_t palette_size (art_pack_image_t *image) {
+    return ALIGN(image->palette_colors * sizeof(uint16_t), 8);
+}
+
+/** Takes ownership of `data`, the image header is located at `header_offset` */
+static bool level_decode (box_art_level_t *level, void *data, size_t size, size_t header_offset) {
+    if ((header_offset + sizeof(art_pack_image_t)) > size) {
+        free(data);
+        return true;
+    }
+
+    // NOTE: Header is copied out, compressed input is released once decoded
+    art_pack_image_t image = *((art_pack_image_t *) ((uint8_t *) (data) + header_offset));
+    uint8_t *payload = (uint8_t *) (data) + header_offset + sizeof(art_pack_image_t);
+
+    if (image.stored_size > (size - header_offset - sizeof(art_pack_image_t))) {
+        free(data);
+        return true;
+    }
+
+    bool indexed = (image.format == ART_PACK_FORMAT_CI8);
+    if ((!indexed && (image.format != ART_PACK_FORMAT_RGBA16)) || (image.palette_colors > TLUT_COLORS)) {
+        free(data);
+        return true;
+    }
+
+    size_t stride = TEX_FORMAT_PIX2BYTES(image.format, image.width);
+    size_t pixels_offset = indexed ? palette_size(&image) : 0;
+
+    if ((indexed && (image.palette_colors == 0)) || ((pixels_offset + (stride * image.height)) > image.data_size)) {
+        free(data);
+        return true;
+    }
+
+    if (image.compression == ART_PACK_COMPRESSION_LZ) {
+        uint8_t *decoded = memalign(64, image.data_size);
+        if ((decoded == NULL) || lz_decompress(payload, image.stored_size, decoded, image.data_size)) {
+            free(decoded);
+            free(data);
+            return true;
+        }
+        // NOTE: Texture is read by the RDP, decoded bytes must leave the CPU data cache
+        data_cache_hit_writeback(decoded, image.data_size);
+        free(data);
+        level->buffer = decoded;
+        level->size = image.data_size;
+        payload = decoded;
+    } else if ((image.compression == ART_PACK_COMPRESSION_NONE) && (image.data_size <= image.stored_size)) {
+        level->buffer = data;
+        level->size = size;
+    } else {
+        free(data);
+        return true;
+    }
+
+    level->palette = indexed ? (uint16_t *) (payload) : NULL;
+    level->palette_colors = image.palette_colors;
+    level->pixels = surface_make(payload + pixels_offset, (tex_format_t) (image.format), image.width, image.height, stride);
+
+    return false;
+}
+
+// NOTE: A level that failed is retried once the window moves, same as the art cache does with whole titles
+static bool level_pending (box_art_t *art, int level, uint32_t window) {
+    if ((level < 0) || (level >= art->level_count) || box_art_level_loaded(art, level) || (art->level_size[level] == 0)) {
+        return false;
+    }
+    return !(art->level_failed[level] && (art->level_window[level] == window));
+}
+
+
+box_art_t *box_art_load_sprite (char *path) {
+    sprite_t *sprite = sprite_load(path);
+    if (sprite == NULL) {
+        return NULL;
+    }
+
+    box_art_t *art = calloc(1, sizeof(box_art_t));
+    if (art == NULL) {
+        sprite_free(sprite);
+        return NULL;
+    }
+
+    tex_format_t format = sprite_get_format(sprite);
+    box_art_level_t *level = &art->levels[0];
+
+    level->pixels = sprite_get_pixels(sprite);
+    level->palette = (format == FMT_CI8) ? sprite_get_palette(sprite) : NULL;
+    level->palette_colors = TLUT_COLORS;
+    level->size = sizeof(sprite_t) + TEX_FORMAT_PIX2BYTES(format, sprite->width * sprite->height);
+    if (format == FMT_CI8) {
+        level->size += TLUT_COLORS * sizeof(uint16_t);
+    }
+
+    art->level_count = 1;
+    art->width = sprite->width;
+    art->height = sprite->height;
+    art->sprite = sprite;
+    art->size = level->size;
+
+    return art;
+}
+
+box_art_t *box_art_load_pack (uint32_t offset, uint32_t size) {
+    if (size < sizeof(art_pack_levels_t)) {
+        return NULL;
+    }
+
+    art_pack_levels_t *levels = art_pack_read(offset, size);
+    if (levels == NULL) {
+        return NULL;
+    }
+
+    int level_count = levels->level_count;
+    if ((level_count < 1) || (level_count > BOX_ART_MAX_LEVELS)) {
+        free(levels);
+        return NULL;
+    }
+
+    box_art_t *art = calloc(1, sizeof(box_art_t));
+    if (art == NULL) {
+        free(levels);
+        return NULL;
+    }
+
+    art->level_count = level_count;
+    art->width = levels->width;
+    art->height = levels->height;
+    art->offset = offset;
+    for (int i = 0; i < level_count; i++) {
+        art->level_offset[i] = levels->level_offset[i];
+        art->level_size[i] = levels->level_size[i];
+    }
+
+    // Smallest level shares the first read with the level table
+    box_art_level_t *smallest = &art->levels[level_count - 1];
+    if (level_decode(smallest, levels, size, sizeof(art_pack_levels_t))) {
+        free(art);
+        return NULL;
+    }
+
+    art->size = smallest->size;
+
+    return art;
+}
+
+bool box_art_load_level (box_art_t *art, int level, uint32_t window) {
+    if (!level_pending(art, level, window)) {
+        return true;
+    }
+
+    uint32_t size = art->level_size[level];
+    void *data = art_pack_read(art->offset + art->level_offset[level], size);
+
+    if ((data == NULL) || level_decode(&art->levels[level], data, size, 0)) {
+        art->level_failed[level] = true;
+        art->level_window[level] = window;
+        return true;
+    }
+
+    art->level_failed[level] = false;
+    art->size += art->levels[level].size;
+
+    return false;
+}
+
+size_t box_art_level_load_size (box_art_t *art, int level, uint32_t window) {
+    if (!level_pending(art, level, window)) {
+        return 0;
+    }
+
+    // NOTE: Upper bound, the level header is only read along with its data. An uncompressed level stays resident as
+    //       stored, a compressed one is decoded to at most RGBA16 pixels and a full TLUT.
+    size_t pixels = (size_t) (MAX(art->width >> level, 1)) * MAX(art->height >> level, 1);
+    size_t decoded = ALIGN(TLUT_COLORS * sizeof(uint16_t), 8) + (pixels * sizeof(uint16_t));
+
+    return MAX(art->level_size[level], decoded);
+}
+
+void box_art_release_level (box_art_t *art, int level) {
+    box_art_level_t *current = &art->levels[level];
+
+    // NOTE: Sprite files only have a single level owned by the sprite itself
+    if ((current->buffer == NULL) || (art->sprite != NULL)) {
+        return;
+    }
+
+    art->size -= current->size;
+    free(current->buffer);
+    *current = (box_art_level_t) { 0 };
+}
+
+bool box_art_level_loaded (box_art_t *art, int level) {
+    return art->levels[level].size > 0;
+}
+
+int box_art_closest_level (box_art_t *art, float scale) {
+    float target = art->width * scale;
+
+    int closest = -1;
+
+    for (int i = 0; i < art->level_count; i++) {
+        if (!box_art_level_loaded(art, i) && (art->level_size[i] == 0)) {
+            continue;
+        }
+        if ((closest < 0) || (fabsf((art->width >> i) - target) < fabsf((art->width >> closest) - target))) {
+            closest = i;
+        }
+    }
+
+    return closest;
+}
+
+void box_art_free (box_art_t *art) {
+    if (art->sprite != NULL) {
+        sprite_free(art->sprite);
+    } else {
+        for (int i = 0; i < art->level_count; i++) {
+            free(art->levels[i].buffer);
+        }
+    }
+    free(art);
+}
+
+void box_art_draw (box_art_t *art, float x, float y, float scale) {
+    int wanted = box_art_closest_level(art, scale);
+    box_art_level_t *level = NULL;
+
+    // Prefer the closest level, then the nearest resident one, larger levels first
+    for (int distance = 0; (level == NULL) && (distance < art->level_count); distance++) {
+        if (((wanted - distance) >= 0) && box_art_level_loaded(art, wanted - distance)) {
+            level = &art->levels[wanted - distance];
+        } else if (((wanted + distance) < art->level_count) && box_art_level_loaded(art, wanted + distance)) {
+            level = &art->levels[wanted + distance];
+        }
+    }
+
+    if (level == NULL) {
+        return;
+    }
+
+    float level_scale_x = (art->width * scale) / level->pixels.width;
+    float level_scale_y = (art->height * scale) / level->pixels.height;
+
+    if (level->palette != NULL) {
+        rdpq_mode_tlut(TLUT_RGBA16);
+        rdpq_tex_upload_tlut(level->palette, 0, level->palette_colors);
+    }
+
+    rdpq_tex_blit(&level->pixels, x, y, &(rdpq_blitparms_t){
+        .scale_x = level_scale_x, .scale_y = level_scale_y,
+    });
+
+    if (level->palette != NULL) {
+        rdpq_mode_tlut(TLUT_NONE);
+    }
+}
@@ -0,0 +1,61 @@
+/**
+ * @file box_art.h
+ * @brief Resident box art image
+ * @ingroup menu
+ */
+
+#ifndef MENU_BOX_ART_H__
+#define MENU_BOX_ART_H__
+
+
+#include <libdragon.h>
+
+#include "art_pack.h"
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+#define BOX_ART_MAX_LEVELS      (ART_PACK_MAX_LEVELS)
+
+/** @brief Single mip level ready for the RDP, either RGBA16 or CI8 with its TLUT. */
+typedef struct {
+    surface_t pixels;
+    uint16_t *palette;
+    int palette_colors;
+    void *buffer;
+    size_t size;
+} box_art_level_t;
+
+/** @brief Box art of a title, level 0 is the full size image and any subset of levels can be resident. */
+typedef struct box_art_s {
+    box_art_level_t levels[BOX_ART_MAX_LEVELS];
+    int level_count;
+    uint16_t width;
+    uint16_t height;
+    sprite_t *sprite;
+    uint32_t offset;
+    uint32_t level_offset[BOX_ART_MAX_LEVELS];
+    uint32_t level_size[BOX_ART_MAX_LEVELS];
+    bool level_failed[BOX_ART_MAX_LEVELS];
+    uint32_t level_window[BOX_ART_MAX_LEVELS];
+    size_t size;
+} box_art_t;
+
+
+box_art_t *box_art_load_sprite (char *path);
+box_art_t *box_art_load_pack (uint32_t offset, uint32_t size);
+bool box_art_load_level (box_art_t *art, int level, uint32_t window);
+size_t box_art_level_load_size (box_art_t *art, int level, uint32_t window);
+void box_art_release_level (box_art_t *art, int level);
+bool box_art_level_loaded (box_art_t *art, int level);
+int box_art_closest_level (box_art_t *art, float scale);
+void box_art_free (box_art_t *art);
+void box_art_draw (box_art_t *art, float x, float y, float scale);
+
+/** @} */ /* menu */
+
+
+#endif
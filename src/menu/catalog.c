@@ -0,0 +1,362 @@
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fatfs/ff.h>
+
+#include "../utils/fs.h"
+#include "../utils/utils.h"
+
+#include "catalog.h"
+
+
+static bool catalog_validate (catalog_t *catalog, size_t size) {
+    catalog_header_t *header = catalog->header;
+
+    if (size < sizeof(catalog_header_t)) {
+        return true;
+    }
+    if ((header->magic != CATALOG_MAGIC) || (header->version != CATALOG_VERSION)) {
+        return true;
+    }
+    if ((header->record_size != sizeof(catalog_record_t)) || (header->columns != CATALOG_COLUMNS)) {
+        return true;
+    }
+    // NOTE: Records are used in place, a misaligned offset would trap on their 32-bit fields
+    if ((header->records_offset < sizeof(catalog_header_t)) || (header->records_offset > size) || (header->records_offset % sizeof(uint32_t))) {
+        return true;
+    }
+    if (header->record_count > ((size - header->records_offset) / sizeof(catalog_record_t))) {
+        return true;
+    }
+    if (header->record_count > CATALOG_MAX_RECORDS) {
+        return true;
+    }
+    if (header->row_count > header->record_count) {
+        return true;
+    }
+
+    return false;
+}
+
+static bool catalog_order_validate (uint16_t *order, uint32_t count, uint8_t *seen) {
+    memset(seen, 0, count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if ((order[i] >= count) || seen[order[i]]) {
+            return true;
+        }
+        seen[order[i]] = 1;
+    }
+
+    return false;
+}
+
+static void catalog_attach_orders (catalog_t *catalog, size_t size) {
+    catalog_header_t *header = catalog->header;
+    uint32_t count = catalog->count;
+    size_t orders_size = (((size_t) (count) * CATALOG_ORDER_COUNT) + CATALOG_LETTER_COUNT + 1) * sizeof(uint16_t);
+
+    if ((header->orders_offset % sizeof(uint16_t)) || (header->orders_offset > size) || (orders_size > (size - header->orders_offset))) {
+        return;
+    }
+
+    uint16_t *orders = (uint16_t *) (catalog->data + header->orders_offset);
+    uint16_t *letter_start = &orders[count * CATALOG_ORDER_COUNT];
+
+    if ((letter_start[0] != 0) || (letter_start[CATALOG_LETTER_COUNT] != count)) {
+        return;
+    }
+    for (int i = 0; i < CATALOG_LETTER_COUNT; i++) {
+        if (letter_start[i] > letter_start[i + 1]) {
+            return;
+        }
+    }
+
+    // NOTE: Every order is checked to be a permutation once here, lookups and in place updates can then skip bounds checks
+    uint8_t *seen = malloc(count ? count : 1);
+    if (seen == NULL) {
+        return;
+    }
+    for (int i = 0; i < CATALOG_ORDER_COUNT; i++) {
+        if (catalog_order_validate(&orders[count * i], count, seen)) {
+            free(seen);
+            return;
+        }
+    }
+    free(seen);
+
+    for (int i = 0; i < CATALOG_ORDER_COUNT; i++) {
+        catalog->orders[i] = &orders[count * i];
+    }
+    catalog->letter_start = letter_start;
+}
+
+static void catalog_attach_names (catalog_t *catalog, size_t size) {
+    catalog_header_t *header = catalog->header;
+
+    if ((header->names_offset >= size) || (((char *) (catalog->data))[size - 1] != '\0')) {
+        return;
+    }
+
+    catalog->names = catalog->data + header->names_offset;
+    catalog->names_size = size - header->names_offset;
+}
+
+static void catalog_order_move (uint16_t *order, uint32_t from, uint32_t to) {
+    uint16_t index = order[from];
+
+    if (from > to) {
+        memmove(&order[to + 1], &order[to], (from - to) * sizeof(uint16_t));
+    }
+
+    order[to] = index;
+}
+
+
+bool catalog_load (char *path, catalog_t *catalog) {
+    FIL fil;
+    UINT br;
+
+    catalog->data = NULL;
+    catalog->header = NULL;
+    catalog->records = NULL;
+    catalog->count = 0;
+    for (int i = 0; i < CATALOG_ORDER_COUNT; i++) {
+        catalog->orders[i] = NULL;
+    }
+    catalog->letter_start = NULL;
+    catalog->names = NULL;
+    catalog->names_size = 0;
+
+    if (f_open(&fil, strip_sd_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    // NOTE: Writer pads the file to the sector size, whole catalog is fetched with one multi-sector read
+    size_t size = f_size(&fil);
+    size_t buffer_size = ALIGN(size, FS_SECTOR_SIZE);
+
+    catalog->data = memalign(16, buffer_size);
+    if (catalog->data == NULL) {
+        f_close(&fil);
+        return true;
+    }
+
+    if ((f_read(&fil, catalog->data, size, &br) != FR_OK) || (br != size)) {
+        f_close(&fil);
+        catalog_free(catalog);
+        return true;
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        catalog_free(catalog);
+        return true;
+    }
+
+    catalog->header = (catalog_header_t *) (catalog->data);
+
+    if (catalog_validate(catalog, size)) {
+        catalog_free(catalog);
+        return true;
+    }
+
+    catalog->records = (catalog_record_t *) (catalog->data + catalog->header->records_offset);
+    catalog->count = catalog->header->record_count;
+
+    // NOTE: Damaged orders or names don't reject the catalog, titles fall back to file order and empty names
+    catalog_attach_orders(catalog, size);
+    catalog_attach_names(catalog, size);
+
+    return false;
+}
+
+bool catalog_load_csv (char *path, catalog_t *catalog) {
+    FIL fil;
+    UINT br;
+
+    memset(catalog, 0, sizeof(catalog_t));
+
+    if (f_open(&fil, strip_sd_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    size_t size = f_size(&fil);
+    char *csv = malloc(size + 1);
+    if (csv == NULL) {
+        f_close(&fil);
+        return true;
+    }
+
+    if ((f_read(&fil, csv, size, &br) != FR_OK) || (br != size)) {
+        f_close(&fil);
+        free(csv);
+        return true;
+    }
+    f_close(&fil);
+    csv[size] = '\0';
+
+    // NOTE: Every ID takes at least two bytes with its separator, enough records are allocated up front
+    uint32_t max_records = MIN((size / 2) + 1, CATALOG_MAX_RECORDS);
+    catalog->data = calloc(1, sizeof(catalog_header_t) + (max_records * sizeof(catalog_record_t)));
+    if (catalog->data == NULL) {
+        free(csv);
+        return true;
+    }
+
+    catalog->header = (catalog_header_t *) (catalog->data);
+    catalog->records = (catalog_record_t *) (catalog->data + sizeof(catalog_header_t));
+
+    // IDs are separated by commas or whitespace, longer tokens are cut to the record ID length as the old list parser did
+    for (char *token = strtok(csv, ", \t\r\n"); (token != NULL) && (catalog->count < max_records); token = strtok(NULL, ", \t\r\n")) {
+        catalog_record_t *record = &catalog->records[catalog->count];
+        strncpy(record->id, token, sizeof(record->id));
+        record->grid_row = catalog->count / CATALOG_COLUMNS;
+        record->grid_column = catalog->count % CATALOG_COLUMNS;
+        record->save_type = CATALOG_SAVE_TYPE_UNKNOWN;
+        catalog->count += 1;
+    }
+    free(csv);
+
+    catalog_header_t *header = catalog->header;
+    header->magic = CATALOG_MAGIC;
+    header->version = CATALOG_VERSION;
+    header->record_size = sizeof(catalog_record_t);
+    header->record_count = catalog->count;
+    header->records_offset = sizeof(catalog_header_t);
+    header->columns = CATALOG_COLUMNS;
+    header->row_count = (catalog->count + CATALOG_COLUMNS - 1) / CATALOG_COLUMNS;
+
+    if (catalog->count == 0) {
+        catalog_free(catalog);
+        return true;
+    }
+
+    // NOTE: The list carries no orders, names or sizes, sprites are read from the per-title files
+    return false;
+}
+
+void catalog_free (catalog_t *catalog) {
+    free(catalog->data);
+    catalog->data = NULL;
+    catalog->header = NULL;
+    catalog->records = NULL;
+    catalog->count = 0;
+    for (int i = 0; i < CATALOG_ORDER_COUNT; i++) {
+        catalog->orders[i] = NULL;
+    }
+    catalog->letter_start = NULL;
+    catalog->names = NULL;
+    catalog->names_size = 0;
+}
+
+char *catalog_name (catalog_t *catalog, uint32_t index) {
+    uint32_t offset = catalog->records[index].name_offset;
+
+    if ((catalog->names == NULL) || (offset >= catalog->names_size)) {
+        return "";
+    }
+
+    return &catalog->names[offset];
+}
+
+uint32_t catalog_order_position (catalog_t *catalog, catalog_order_t order, uint32_t index) {
+    if (catalog->orders[order] == NULL) {
+        return index;
+    }
+
+    for (uint32_t i = 0; i < catalog->count; i++) {
+        if (catalog->orders[order][i] == index) {
+            return i;
+        }
+    }
+
+    return index;
+}
+
+uint32_t catalog_letter_jump (catalog_t *catalog, uint32_t position, int direction) {
+    uint16_t *start = catalog->letter_start;
+
+    if (start == NULL) {
+        return position;
+    }
+
+    int letter = CATALOG_LETTER_COUNT - 1;
+    while ((letter > 0) && (start[letter] > position)) {
+        letter--;
+    }
+
+    if (direction < 0) {
+        if (position > start[letter]) {
+            return start[letter];
+        }
+        for (int i = letter - 1; i >= 0; i--) {
+            if (start[i] < start[i + 1]) {
+                return start[i];
+            }
+        }
+    } else {
+        for (int i = letter + 1; i < CATALOG_LETTER_COUNT; i++) {
+            if (start[i] < start[i + 1]) {
+                return start[i];
+            }
+        }
+    }
+
+    return position;
+}
+
+void catalog_record_play (catalog_t *catalog, uint32_t index) {
+    catalog_record_t *record = &catalog->records[index];
+
+    if (record->play_count < UINT16_MAX) {
+        record->play_count += 1;
+    }
+
+    uint16_t *recent = catalog->orders[CATALOG_ORDER_RECENT];
+    if (recent != NULL) {
+        catalog_order_move(recent, catalog_order_position(catalog, CATALOG_ORDER_RECENT, index), 0);
+    }
+
+    // Title moves ahead of every title played as often or less, ties stay in most recently played order
+    uint16_t *played = catalog->orders[CATALOG_ORDER_PLAYED];
+    if (played != NULL) {
+        uint32_t from = catalog_order_position(catalog, CATALOG_ORDER_PLAYED, index);
+        uint32_t to = from;
+        while ((to > 0) && (catalog->records[played[to - 1]].play_count <= record->play_count)) {
+            to--;
+        }
+        catalog_order_move(played, from, to);
+    }
+}
+
+bool catalog_store_plays (char *path, catalog_t *catalog, uint32_t index) {
+    FIL fil;
+    UINT bw;
+    bool error = false;
+
+    if (f_open(&fil, strip_sd_prefix(path), FA_WRITE) != FR_OK) {
+        return true;
+    }
+
+    // NOTE: Only the record and the two orders that change on launch are rewritten, the rest of the file stays untouched
+    FSIZE_t offset = catalog->header->records_offset + (index * sizeof(catalog_record_t));
+    if ((f_lseek(&fil, offset) != FR_OK) || (f_write(&fil, &catalog->records[index], sizeof(catalog_record_t), &bw) != FR_OK) || (bw != sizeof(catalog_record_t))) {
+        error = true;
+    }
+
+    // Recent and most played orders are adjacent in the file
+    if (!error && (catalog->orders[CATALOG_ORDER_RECENT] != NULL)) {
+        UINT size = catalog->count * sizeof(uint16_t) * 2;
+        offset = catalog->header->orders_offset + (CATALOG_ORDER_RECENT * catalog->count * sizeof(uint16_t));
+        if ((f_lseek(&fil, offset) != FR_OK) || (f_write(&fil, catalog->orders[CATALOG_ORDER_RECENT], size, &bw) != FR_OK) || (bw != size)) {
+            error = true;
+        }
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
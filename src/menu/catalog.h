@@ -0,0 +1,130 @@
+/**
+ * @file catalog.h
+ * @brief Binary title catalog
+ * @ingroup menu
+ */
+
+#ifndef MENU_CATALOG_H__
+#define MENU_CATALOG_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+#define CATALOG_PATH                "sd:/menu/catalog.bin"
+#define CATALOG_CSV_PATH            "sd:/menu/title.csv"
+
+#define CATALOG_MAGIC               (0x4E363443UL)  /* "N64C" */
+#define CATALOG_VERSION             (2)
+#define CATALOG_COLUMNS             (4)
+#define CATALOG_ID_LENGTH           (8)
+#define CATALOG_NAME_LENGTH         (64)
+
+/** @brief Orders are stored as 16-bit record indexes */
+#define CATALOG_MAX_RECORDS         (65535)
+
+/** @brief First letter buckets of the name order, '#' for anything that isn't a letter followed by 'A' to 'Z' */
+#define CATALOG_LETTER_COUNT        (27)
+
+/** @brief Save type stored when the importer couldn't resolve one, menu falls back to the `.save` sidecar */
+#define CATALOG_SAVE_TYPE_UNKNOWN   (0xFF)
+
+/** @brief Precomputed title orders. */
+typedef enum {
+    CATALOG_ORDER_NAME,
+    CATALOG_ORDER_RECENT,
+    CATALOG_ORDER_PLAYED,
+    CATALOG_ORDER_COUNT,
+} catalog_order_t;
+
+/**
+ * @brief Catalog file header.
+ *
+ * All fields are stored big-endian so the file can be used in place after a single read.
+ * Header is followed by `record_count` records starting at `records_offset`, file is padded to the SD sector size.
+ * `orders_offset` holds `CATALOG_ORDER_COUNT` arrays of `record_count` record indexes followed by
+ * `CATALOG_LETTER_COUNT + 1` positions in the name order where each first letter starts.
+ * `names_offset` holds the NUL-terminated title names and runs to the end of the file.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t record_count;
+    uint32_t records_offset;
+    uint8_t columns;
+    uint8_t __reserved_1[3];
+    uint32_t row_count;
+    uint32_t orders_offset;
+    uint32_t names_offset;
+} catalog_header_t;
+
+/**
+ * @brief Catalog title record.
+ *
+ * `sprite_offset` and `sprite_size` locate the box art inside the art pack, a zero size selects the per-title sprite file.
+ * `name_offset` is relative to the names section, `play_count` is updated in place by the menu on every launch.
+ */
+typedef struct {
+    char id[CATALOG_ID_LENGTH];
+    uint32_t rom_size;
+    uint32_t sprite_offset;
+    uint32_t sprite_size;
+    uint16_t grid_row;
+    uint8_t grid_column;
+    uint8_t save_type;
+    uint8_t flags;
+    uint8_t __reserved;
+    uint16_t play_count;
+    uint32_t name_offset;
+} catalog_record_t;
+
+/** @brief Loaded catalog. */
+typedef struct {
+    void *data;
+    catalog_header_t *header;
+    catalog_record_t *records;
+    uint32_t count;
+    uint16_t *orders[CATALOG_ORDER_COUNT];
+    uint16_t *letter_start;
+    char *names;
+    uint32_t names_size;
+} catalog_t;
+
+
+bool catalog_load (char *path, catalog_t *catalog);
+bool catalog_load_csv (char *path, catalog_t *catalog);
+void catalog_free (catalog_t *catalog);
+char *catalog_name (catalog_t *catalog, uint32_t index);
+uint32_t catalog_order_position (catalog_t *catalog, catalog_order_t order, uint32_t index);
+uint32_t catalog_letter_jump (catalog_t *catalog, uint32_t position, int direction);
+void catalog_record_play (catalog_t *catalog, uint32_t index);
+bool catalog_store_plays (char *path, catalog_t *catalog, uint32_t index);
+
+/** @brief Record index at a position of an order, catalogs without valid orders fall back to file order */
+static inline uint32_t catalog_order_get (catalog_t *catalog, catalog_order_t order, uint32_t position) {
+    return catalog->orders[order] ? catalog->orders[order][position] : position;
+}
+
+/** @brief First letter bucket of a title name, shared with the host tool that builds the jump table */
+static inline int catalog_letter (const char *name) {
+    char c = name[0];
+    if ((c >= 'a') && (c <= 'z')) {
+        return (c - 'a') + 1;
+    }
+    if ((c >= 'A') && (c <= 'Z')) {
+        return (c - 'A') + 1;
+    }
+    return 0;
+}
+
+/** @} */ /* menu */
+
+
+#endif
@@ -0,0 +1,124 @@
+#include <string.h>
+
+#include <fatfs/ff.h>
+
+#include "../utils/fs.h"
+
+#include "launch_profile.h"
+
+
+static bool file_matches (char *path, uint32_t size, uint32_t timestamp) {
+    size_t current_size;
+    uint32_t current_timestamp;
+
+    if (file_get_info(path, &current_size, &current_timestamp)) {
+        return false;
+    }
+
+    return (current_size == size) && (current_timestamp == timestamp);
+}
+
+
+bool launch_profile_load (uint32_t index, char *id, char *rom_path, char *save_path, launch_profile_t *profile) {
+    FIL fil;
+    UINT br;
+    bool error = false;
+
+    if (f_open(&fil, strip_sd_prefix(LAUNCH_PROFILE_PATH), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    FSIZE_t offset = (FSIZE_t) (index) * sizeof(launch_profile_t);
+
+    if ((f_lseek(&fil, offset) != FR_OK) || (f_read(&fil, profile, sizeof(launch_profile_t), &br) != FR_OK) || (br != sizeof(launch_profile_t))) {
+        error = true;
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    if (error) {
+        return true;
+    }
+
+    if ((profile->magic != LAUNCH_PROFILE_MAGIC) || (profile->version != LAUNCH_PROFILE_VERSION)) {
+        return true;
+    }
+    if (strncmp(profile->id, id, sizeof(profile->id)) != 0) {
+        return true;
+    }
+    if (profile->save_type >= __FLASHCART_SAVE_TYPE_END) {
+        return true;
+    }
+
+    // NOTE: Two directory lookups replace the sidecar parse, the IPL3 checksums and the cluster chain walk
+    if (!file_matches(rom_path, profile->rom_size, profile->rom_timestamp)) {
+        return true;
+    }
+    if (profile->save_type != FLASHCART_SAVE_TYPE_NONE) {
+        uint32_t cluster;
+        if (!file_matches(save_path, profile->save_size, profile->save_timestamp)) {
+            return true;
+        }
+        // NOTE: The save map sends writeback to fixed sectors, a save restored to other clusters must be mapped again
+        if (file_get_cluster(save_path, &cluster) || (cluster != profile->save_cluster)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool launch_profile_capture (char *id, char *rom_path, char *save_path, launch_profile_t *profile) {
+    size_t size;
+
+    profile->magic = LAUNCH_PROFILE_MAGIC;
+    profile->version = LAUNCH_PROFILE_VERSION;
+    memset(profile->id, 0, sizeof(profile->id));
+    strncpy(profile->id, id, sizeof(profile->id));
+
+    if (file_get_info(rom_path, &size, &profile->rom_timestamp)) {
+        return true;
+    }
+    profile->rom_size = size;
+
+    profile->save_size = 0;
+    profile->save_timestamp = 0;
+    profile->save_cluster = 0;
+
+    if (profile->save_type != FLASHCART_SAVE_TYPE_NONE) {
+        if (file_get_info(save_path, &size, &profile->save_timestamp) || file_get_cluster(save_path, &profile->save_cluster)) {
+            return true;
+        }
+        profile->save_size = size;
+    }
+
+    return false;
+}
+
+bool launch_profile_store (uint32_t index, launch_profile_t *profile) {
+    FIL fil;
+    UINT bw;
+    bool error = false;
+
+    if (f_open(&fil, strip_sd_prefix(LAUNCH_PROFILE_PATH), FA_WRITE | FA_OPEN_ALWAYS) != FR_OK) {
+        return true;
+    }
+
+    // NOTE: Seeking past the end grows the file without clearing it, records of titles
+    //       never launched hold stale cluster contents and are rejected by the magic and ID checks.
+    FSIZE_t offset = (FSIZE_t) (index) * sizeof(launch_profile_t);
+
+    if ((f_lseek(&fil, offset) != FR_OK) || (f_tell(&fil) != offset)) {
+        error = true;
+    } else if ((f_write(&fil, profile, sizeof(launch_profile_t), &bw) != FR_OK) || (bw != sizeof(launch_profile_t))) {
+        error = true;
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file launch_profile.h
+ * @brief Per-title launch profile cache
+ * @ingroup menu
+ */
+
+#ifndef MENU_LAUNCH_PROFILE_H__
+#define MENU_LAUNCH_PROFILE_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../flashcart/flashcart.h"
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+#define LAUNCH_PROFILE_PATH         "sd:/menu/profile.bin"
+
+#define LAUNCH_PROFILE_MAGIC        (0x4E363450UL)  /* "N64P" */
+#define LAUNCH_PROFILE_VERSION      (2)
+
+/**
+ * @brief Launch profile record.
+ *
+ * Results of the first launch of a title: resolved save type, CIC seed and save file location.
+ * Records are stored at the catalog index of the title, a record is trusted only while the ID,
+ * the ROM and the save file sizes and FAT timestamps and the first cluster of the save still match.
+ */
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t save_type;
+    uint8_t cic_seed;
+    uint8_t __reserved_1;
+    char id[8];
+    uint32_t rom_size;
+    uint32_t rom_timestamp;
+    uint32_t save_size;
+    uint32_t save_timestamp;
+    flashcart_save_map_t save_map;
+    uint32_t save_cluster;
+    uint8_t __reserved_2[56];
+} launch_profile_t;
+
+
+bool launch_profile_load (uint32_t index, char *id, char *rom_path, char *save_path, launch_profile_t *profile);
+bool launch_profile_capture (char *id, char *rom_path, char *save_path, launch_profile_t *profile);
+bool launch_profile_store (uint32_t index, launch_profile_t *profile);
+
+/** @} */ /* menu */
+
+
+#endif
@@ -0,0 +1,71 @@
+#include <string.h>
+
+#include "lz.h"
+
+
+static bool read_length (const uint8_t **src, const uint8_t *src_end, size_t *length) {
+    uint8_t byte;
+    do {
+        if (*src >= src_end) {
+            return true;
+        }
+        byte = *(*src)++;
+        *length += byte;
+    } while (byte == 255);
+    return false;
+}
+
+
+bool lz_decompress (const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size) {
+    const uint8_t *src_end = src + src_size;
+    uint8_t *out = dst;
+    uint8_t *out_end = dst + dst_size;
+
+    while (src < src_end) {
+        uint8_t token = *src++;
+
+        size_t literals = (token >> 4);
+        if ((literals == 15) && read_length(&src, src_end, &literals)) {
+            return true;
+        }
+        if ((literals > (size_t) (src_end - src)) || (literals > (size_t) (out_end - out))) {
+            return true;
+        }
+        memcpy(out, src, literals);
+        src += literals;
+        out += literals;
+
+        if (out == out_end) {
+            break;
+        }
+
+        if ((src_end - src) < 2) {
+            return true;
+        }
+        size_t offset = (src[0] << 8) | src[1];
+        src += 2;
+
+        size_t length = (token & 0x0F);
+        if ((length == 15) && read_length(&src, src_end, &length)) {
+            return true;
+        }
+        length += LZ_MIN_MATCH;
+
+        if ((offset == 0) || (offset > (size_t) (out - dst)) || (length > (size_t) (out_end - out))) {
+            return true;
+        }
+
+        const uint8_t *match = out - offset;
+        if (offset >= length) {
+            memcpy(out, match, length);
+            out += length;
+        } else {
+            // NOTE: Overlapping match repeats the last `offset` bytes, copy must go forward byte by byte
+            for (size_t i = 0; i < length; i++) {
+                *out++ = *match++;
+            }
+        }
+    }
+
+    return (src != src_end) || (out != out_end);
+}
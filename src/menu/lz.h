@@ -0,0 +1,42 @@
+/**
+ * @file lz.h
+ * @brief Byte oriented LZ decoder for box art
+ * @ingroup menu
+ */
+
+#ifndef MENU_LZ_H__
+#define MENU_LZ_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+/**
+ * Stream is a list of sequences, each one made of:
+ * - token byte: literal count in the high nibble, match length minus #LZ_MIN_MATCH in the low nibble,
+ *   a nibble value of 15 is continued with bytes added up until one is below 255;
+ * - literal bytes;
+ * - match offset, big-endian 16 bit, only when the output isn't complete yet.
+ *
+ * The last sequence carries literals only.
+ */
+#define LZ_MIN_MATCH        (4)
+#define LZ_MAX_OFFSET       (65535)
+
+/** @brief Worst case size of the encoded stream for the given input size */
+#define LZ_BOUND(size)      ((size) + ((size) / 255) + 16)
+
+
+bool lz_decompress (const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size);
+
+/** @} */ /* menu */
+
+
+#endif
@@ -0,0 +1,246 @@
+#include <string.h>
+
+#include <fatfs/ff.h>
+
+#include "../flashcart/flashcart.h"
+#include "../utils/fs.h"
+#include "../utils/utils.h"
+
+#include "resident_rom.h"
+
+
+static uint8_t sample_buffer[RESIDENT_ROM_SAMPLE_SIZE] __attribute__((aligned(16)));
+static uint8_t chunks_file[ROM_CHUNKS_MAX_FILE_SIZE];
+static size_t chunks_file_size;
+static rom_chunks_t resident_chunks;
+static rom_chunks_t target_chunks;
+
+
+static bool rom_size_supported (uint32_t rom_size) {
+    return (rom_size >= (RESIDENT_ROM_HEAD_SIZE + RESIDENT_ROM_SAMPLE_SIZE)) && (rom_size <= RESIDENT_ROM_MAX_SIZE);
+}
+
+static uint32_t sample_offset (uint32_t rom_size, int index) {
+    uint32_t span = rom_size - RESIDENT_ROM_HEAD_SIZE - RESIDENT_ROM_SAMPLE_SIZE;
+    uint32_t offset = RESIDENT_ROM_HEAD_SIZE + (uint32_t) (((uint64_t) (span) * index) / (RESIDENT_ROM_SAMPLES - 1));
+
+    return (offset & ~(0x07));
+}
+
+static bool sample_checksum (uint32_t rom_size, int index, uint32_t *checksum) {
+    if (flashcart_read_rom(sample_offset(rom_size, index), sample_buffer, sizeof(sample_buffer)) != FLASHCART_OK) {
+        return true;
+    }
+
+    uint32_t *words = (uint32_t *) (sample_buffer);
+    uint32_t hash = 0x811C9DC5UL;
+
+    for (int i = 0; i < (sizeof(sample_buffer) / sizeof(uint32_t)); i++) {
+        hash = (hash ^ words[i]) * 0x01000193UL;
+    }
+
+    *checksum = hash;
+
+    return false;
+}
+
+
+static bool read_file (char *path, void *buffer, size_t max_size, size_t *size) {
+    FIL fil;
+    UINT br;
+    bool error = false;
+
+    if (f_open(&fil, strip_sd_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    if ((f_size(&fil) > max_size) || (f_read(&fil, buffer, f_size(&fil), &br) != FR_OK) || (br != f_size(&fil))) {
+        error = true;
+    }
+    *size = br;
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+static bool write_file (char *path, void *buffer, size_t size) {
+    FIL fil;
+    UINT bw;
+    bool error = false;
+
+    if (f_open(&fil, strip_sd_prefix(path), FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        return true;
+    }
+
+    if ((f_write(&fil, buffer, size, &bw) != FR_OK) || (bw != size)) {
+        error = true;
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+static bool load_record (rom_order_t order, resident_rom_t *record) {
+    size_t size;
+
+    if (read_file(RESIDENT_ROM_PATH, record, sizeof(resident_rom_t), &size) || (size != sizeof(resident_rom_t))) {
+        return true;
+    }
+    if ((record->magic != RESIDENT_ROM_MAGIC) || (record->version != RESIDENT_ROM_VERSION)) {
+        return true;
+    }
+    if ((record->rom_order != order) || !rom_size_supported(record->rom_size)) {
+        return true;
+    }
+
+    return false;
+}
+
+static bool verify_samples (resident_rom_t *record) {
+    // NOTE: A power cycle or a load that didn't finish leaves memory that fails these checks
+    for (int i = 0; i < RESIDENT_ROM_SAMPLES; i++) {
+        uint32_t checksum;
+        if (sample_checksum(record->rom_size, i, &checksum) || (checksum != record->checksums[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool load_target_chunks (char *rom_path, char *chunks_path) {
+    size_t rom_size = file_get_size(rom_path);
+
+    if (read_file(chunks_path, chunks_file, sizeof(chunks_file), &chunks_file_size)) {
+        return true;
+    }
+    if (rom_chunks_parse(chunks_file, chunks_file_size, &target_chunks)) {
+        return true;
+    }
+
+    return (target_chunks.rom_size != rom_size);
+}
+
+
+bool resident_rom_check (char *id, char *rom_path, rom_order_t order, resident_rom_t *record) {
+    size_t rom_size;
+    uint32_t rom_timestamp;
+
+    if (load_record(order, record)) {
+        return true;
+    }
+    if (strncmp(record->id, id, sizeof(record->id)) != 0) {
+        return true;
+    }
+    if (file_get_info(rom_path, &rom_size, &rom_timestamp)) {
+        return true;
+    }
+    if ((rom_size != record->rom_size) || (rom_timestamp != record->rom_timestamp)) {
+        return true;
+    }
+
+    return verify_samples(record);
+}
+
+bool resident_rom_delta (char *rom_path, char *chunks_path, rom_order_t order, uint32_t *chunk_size, uint8_t *changed, uint32_t *changed_count) {
+    resident_rom_t record;
+    size_t size;
+
+    if (load_target_chunks(rom_path, chunks_path) || !rom_size_supported(target_chunks.rom_size)) {
+        return true;
+    }
+
+    // NOTE: The resident ROM may be any title, its chunk list is trusted only while its record still matches memory
+    if (load_record(order, &record) || verify_samples(&record)) {
+        return true;
+    }
+    if (read_file(RESIDENT_ROM_CHUNKS_PATH, chunks_file, sizeof(chunks_file), &size)) {
+        return true;
+    }
+    if (rom_chunks_parse(chunks_file, size, &resident_chunks) || (resident_chunks.rom_size != record.rom_size)) {
+        return true;
+    }
+
+    *chunk_size = (1 << target_chunks.shift);
+    *changed_count = rom_chunks_diff(&resident_chunks, &target_chunks, RESIDENT_ROM_HEAD_SIZE, changed);
+
+    return false;
+}
+
+bool resident_rom_check_head (void) {
+    uint32_t length = MIN(target_chunks.rom_size, (1 << target_chunks.shift));
+    uint64_t hash = ROM_CHUNKS_HASH_INIT;
+
+    // NOTE: The head was just read from the ROM file, a chunk list that doesn't match it is stale
+    for (uint32_t offset = 0; offset < length; offset += sizeof(sample_buffer)) {
+        uint32_t block_size = MIN(length - offset, sizeof(sample_buffer));
+        if (flashcart_read_rom(offset, sample_buffer, ALIGN(block_size, 2)) != FLASHCART_OK) {
+            return true;
+        }
+        hash = rom_chunks_hash(hash, sample_buffer, block_size);
+    }
+
+    return (hash != target_chunks.hashes[0]);
+}
+
+flashcart_err_t resident_rom_verify (char *rom_path, char *chunks_path, flashcart_progress_callback_t *progress) {
+    // NOTE: Titles without a chunk list written at import time have nothing to compare against
+    if (load_target_chunks(rom_path, chunks_path)) {
+        return FLASHCART_OK;
+    }
+
+    return flashcart_verify_rom(&target_chunks, progress);
+}
+
+bool resident_rom_capture (char *id, char *rom_path, rom_order_t order, resident_rom_t *record) {
+    size_t rom_size;
+
+    memset(record, 0, sizeof(resident_rom_t));
+
+    record->magic = RESIDENT_ROM_MAGIC;
+    record->version = RESIDENT_ROM_VERSION;
+    record->rom_order = order;
+    strncpy(record->id, id, sizeof(record->id));
+
+    if (file_get_info(rom_path, &rom_size, &record->rom_timestamp)) {
+        return true;
+    }
+    if (!rom_size_supported(rom_size)) {
+        return true;
+    }
+    record->rom_size = rom_size;
+
+    for (int i = 0; i < RESIDENT_ROM_SAMPLES; i++) {
+        if (sample_checksum(rom_size, i, &record->checksums[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool resident_rom_store (resident_rom_t *record) {
+    return write_file(RESIDENT_ROM_PATH, record, sizeof(resident_rom_t));
+}
+
+bool resident_rom_store_chunks (char *rom_path, char *chunks_path) {
+    if (file_delete(RESIDENT_ROM_CHUNKS_PATH)) {
+        return true;
+    }
+
+    if (load_target_chunks(rom_path, chunks_path)) {
+        return false;
+    }
+
+    return write_file(RESIDENT_ROM_CHUNKS_PATH, chunks_file, chunks_file_size);
+}
+
+bool resident_rom_invalidate (void) {
+    return file_delete(RESIDENT_ROM_PATH);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file resident_rom.h
+ * @brief Record of the ROM left in cartridge memory
+ * @ingroup menu
+ */
+
+#ifndef MENU_RESIDENT_ROM_H__
+#define MENU_RESIDENT_ROM_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../flashcart/flashcart.h"
+#include "../utils/rom_order.h"
+
+#include "rom_chunks.h"
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+#define RESIDENT_ROM_PATH           "sd:/menu/resident.bin"
+#define RESIDENT_ROM_CHUNKS_PATH    "sd:/menu/resident.chk"
+
+#define RESIDENT_ROM_MAGIC          (0x4E363452UL)  /* "N64R" */
+#define RESIDENT_ROM_VERSION        (2)
+
+/** @brief Start of cartridge memory overwritten by the menu image on every boot, reloaded on a relaunch */
+#define RESIDENT_ROM_HEAD_SIZE      (2 * 1024 * 1024)
+/** @brief Largest ROM that fits the cartridge SDRAM without the SC64 flash backed areas */
+#define RESIDENT_ROM_MAX_SIZE       ((64 * 1024 * 1024) - (128 * 1024))
+
+#define RESIDENT_ROM_SAMPLES        (24)
+#define RESIDENT_ROM_SAMPLE_SIZE    (4096)
+
+/**
+ * @brief Resident ROM record.
+ *
+ * Written after a complete ROM load, deleted before any other load starts. Checksums cover
+ * blocks spread between the end of the head and the end of the ROM, a relaunch trusts the
+ * cartridge memory only while the ID, the ROM file size and FAT timestamp and every block match.
+ */
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t rom_order;
+    uint8_t __reserved_1[2];
+    char id[8];
+    uint32_t rom_size;
+    uint32_t rom_timestamp;
+    uint32_t checksums[RESIDENT_ROM_SAMPLES];
+    uint8_t __reserved_2[8];
+} resident_rom_t;
+
+/** @brief Size of the changed chunk bitmap filled by resident_rom_delta() */
+#define RESIDENT_ROM_CHANGED_SIZE   (ROM_CHUNKS_MAX_COUNT / 8)
+
+
+bool resident_rom_check (char *id, char *rom_path, rom_order_t order, resident_rom_t *record);
+bool resident_rom_delta (char *rom_path, char *chunks_path, rom_order_t order, uint32_t *chunk_size, uint8_t *changed, uint32_t *changed_count);
+bool resident_rom_check_head (void);
+flashcart_err_t resident_rom_verify (char *rom_path, char *chunks_path, flashcart_progress_callback_t *progress);
+bool resident_rom_capture (char *id, char *rom_path, rom_order_t order, resident_rom_t *record);
+bool resident_rom_store (resident_rom_t *record);
+bool resident_rom_store_chunks (char *rom_path, char *chunks_path);
+bool resident_rom_invalidate (void);
+
+/** @} */ /* menu */
+
+
+#endif
@@ -0,0 +1,77 @@
+#include <string.h>
+
+#include "rom_chunks.h"
+
+
+static uint32_t read_u32 (const uint8_t *p) {
+    return ((uint32_t) (p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+
+uint64_t rom_chunks_hash (uint64_t hash, const uint8_t *data, size_t length) {
+    // NOTE: FNV-1a over big-endian words, four times fewer 64-bit multiplies than over bytes.
+    //       A chunk hashed in pieces gives the same result as long as every piece but the last is word sized.
+    for (size_t i = 0; (i + 4) <= length; i += 4) {
+        hash = (hash ^ read_u32(data + i)) * 0x00000100000001B3ULL;
+    }
+    for (size_t i = (length & ~3); i < length; i++) {
+        hash = (hash ^ data[i]) * 0x00000100000001B3ULL;
+    }
+
+    return hash;
+}
+
+bool rom_chunks_parse (const uint8_t *data, size_t size, rom_chunks_t *chunks) {
+    if (size < ROM_CHUNKS_HEADER_SIZE) {
+        return true;
+    }
+    if ((read_u32(data) != ROM_CHUNKS_MAGIC) || (data[4] != ROM_CHUNKS_VERSION)) {
+        return true;
+    }
+
+    chunks->shift = data[5];
+    chunks->rom_size = read_u32(data + 8);
+    chunks->count = read_u32(data + 12);
+
+    if ((chunks->shift < ROM_CHUNKS_MIN_SHIFT) || (chunks->shift > ROM_CHUNKS_MAX_SHIFT)) {
+        return true;
+    }
+    if ((chunks->rom_size == 0) || (chunks->rom_size > ROM_CHUNKS_MAX_ROM_SIZE)) {
+        return true;
+    }
+    if (chunks->count != ((chunks->rom_size + (1 << chunks->shift) - 1) >> chunks->shift)) {
+        return true;
+    }
+    if (size < (ROM_CHUNKS_HEADER_SIZE + (chunks->count * sizeof(uint64_t)))) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < chunks->count; i++) {
+        const uint8_t *p = data + ROM_CHUNKS_HEADER_SIZE + (i * sizeof(uint64_t));
+        chunks->hashes[i] = ((uint64_t) (read_u32(p)) << 32) | read_u32(p + 4);
+    }
+
+    return false;
+}
+
+uint32_t rom_chunks_diff (const rom_chunks_t *resident, const rom_chunks_t *target, uint32_t head_size, uint8_t *changed) {
+    uint32_t head_chunks = (head_size + (1 << target->shift) - 1) >> target->shift;
+    uint32_t count = 0;
+
+    memset(changed, 0, (target->count + 7) / 8);
+
+    // NOTE: A hash only vouches for a chunk of the same length at the same offset,
+    //       the chunk that ended the resident ROM is transferred again when the target is longer.
+    for (uint32_t i = 0; i < target->count; i++) {
+        bool same = (resident->shift == target->shift) && (i < resident->count) && (resident->hashes[i] == target->hashes[i]);
+        if (same && ((i + 1) == resident->count) && (resident->rom_size != target->rom_size)) {
+            same = false;
+        }
+        if ((i < head_chunks) || !same) {
+            changed[i / 8] |= (1 << (i % 8));
+            count += 1;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file rom_chunks.h
+ * @brief Per-title ROM chunk hash list
+ * @ingroup menu
+ */
+
+#ifndef MENU_ROM_CHUNKS_H__
+#define MENU_ROM_CHUNKS_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+#define ROM_CHUNKS_MAGIC            (0x4E363448UL)  /* "N64H" */
+#define ROM_CHUNKS_VERSION          (1)
+
+/**
+ * File layout, big-endian:
+ * - 0: magic, 4: version (8 bit), 5: log2 of the chunk size (8 bit), 6: reserved (16 bit);
+ * - 8: ROM size, 12: chunk count;
+ * - 16: one 64-bit hash per chunk, the last chunk may be shorter.
+ */
+#define ROM_CHUNKS_HEADER_SIZE      (16)
+
+#define ROM_CHUNKS_DEFAULT_SHIFT    (17)
+#define ROM_CHUNKS_MIN_SHIFT        (16)
+#define ROM_CHUNKS_MAX_SHIFT        (20)
+
+/** @brief Chunk lists describe ROMs held entirely in the 64 MiB of cartridge SDRAM */
+#define ROM_CHUNKS_MAX_ROM_SIZE     (64 * 1024 * 1024)
+#define ROM_CHUNKS_MAX_COUNT        (ROM_CHUNKS_MAX_ROM_SIZE >> ROM_CHUNKS_MIN_SHIFT)
+
+#define ROM_CHUNKS_MAX_FILE_SIZE    (ROM_CHUNKS_HEADER_SIZE + (ROM_CHUNKS_MAX_COUNT * sizeof(uint64_t)))
+
+/** @brief Starting value of rom_chunks_hash(), FNV-1a 64-bit offset basis */
+#define ROM_CHUNKS_HASH_INIT        (0xCBF29CE484222325ULL)
+
+/** @brief Parsed chunk hash list. */
+typedef struct {
+    uint8_t shift;
+    uint32_t rom_size;
+    uint32_t count;
+    uint64_t hashes[ROM_CHUNKS_MAX_COUNT];
+} rom_chunks_t;
+
+
+uint64_t rom_chunks_hash (uint64_t hash, const uint8_t *data, size_t length);
+bool rom_chunks_parse (const uint8_t *data, size_t size, rom_chunks_t *chunks);
+uint32_t rom_chunks_diff (const rom_chunks_t *resident, const rom_chunks_t *target, uint32_t head_size, uint8_t *changed);
+
+/** @} */ /* menu */
+
+
+#endif
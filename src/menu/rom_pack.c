@@ -0,0 +1,59 @@
+#include <string.h>
+#include <strings.h>
+
+#include "lz.h"
+#include "rom_pack.h"
+
+
+static uint32_t read_u32 (const uint8_t *p) {
+    return ((uint32_t) (p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+
+bool rom_pack_is_path (const char *path) {
+    const char *extension = strrchr(path, '.');
+
+    return (extension != NULL) && (strcasecmp(extension, ROM_PACK_EXTENSION) == 0);
+}
+
+bool rom_pack_parse (const uint8_t *data, size_t size, rom_pack_t *pack) {
+    if (size < ROM_PACK_HEADER_SIZE) {
+        return true;
+    }
+    if ((read_u32(data) != ROM_PACK_MAGIC) || (data[4] != ROM_PACK_VERSION) || (data[5] != ROM_PACK_BLOCK_SHIFT)) {
+        return true;
+    }
+
+    pack->rom_size = read_u32(data + 8);
+    pack->block_count = read_u32(data + 12);
+    pack->data_offset = ROM_PACK_HEADER_SIZE + (pack->block_count * sizeof(uint32_t));
+
+    if ((pack->rom_size == 0) || (pack->rom_size > ROM_PACK_MAX_ROM_SIZE)) {
+        return true;
+    }
+    if (pack->block_count != ((pack->rom_size + ROM_PACK_BLOCK_SIZE - 1) >> ROM_PACK_BLOCK_SHIFT)) {
+        return true;
+    }
+    if (size < pack->data_offset) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < pack->block_count; i++) {
+        pack->stored_sizes[i] = read_u32(data + ROM_PACK_HEADER_SIZE + (i * sizeof(uint32_t)));
+        if ((pack->stored_sizes[i] == 0) || (pack->stored_sizes[i] > LZ_BOUND(ROM_PACK_BLOCK_SIZE))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t rom_pack_block_size (const rom_pack_t *pack, uint32_t index) {
+    uint32_t offset = (index << ROM_PACK_BLOCK_SHIFT);
+
+    return ((pack->rom_size - offset) < ROM_PACK_BLOCK_SIZE) ? (pack->rom_size - offset) : ROM_PACK_BLOCK_SIZE;
+}
+
+bool rom_pack_block_stored (const rom_pack_t *pack, uint32_t index) {
+    return (pack->stored_sizes[index] == rom_pack_block_size(pack, index));
+}
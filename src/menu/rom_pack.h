@@ -0,0 +1,62 @@
+/**
+ * @file rom_pack.h
+ * @brief Block compressed ROM container
+ * @ingroup menu
+ */
+
+#ifndef MENU_ROM_PACK_H__
+#define MENU_ROM_PACK_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+#define ROM_PACK_MAGIC              (0x4E36345AUL)  /* "N64Z" */
+#define ROM_PACK_VERSION            (1)
+#define ROM_PACK_EXTENSION          ".zlz"
+
+/**
+ * File layout, big-endian:
+ * - 0: magic, 4: version (8 bit), 5: log2 of the block size (8 bit), 6: reserved (16 bit);
+ * - 8: ROM size, 12: block count;
+ * - 16: stored size of every block (32 bit), followed by the blocks back to back.
+ *
+ * Blocks hold the ROM in native byte order, each one compressed on its own with lz_decompress().
+ * A block whose stored size equals its ROM size is kept uncompressed, the last block may be shorter.
+ */
+#define ROM_PACK_HEADER_SIZE        (16)
+
+#define ROM_PACK_BLOCK_SHIFT        (17)
+#define ROM_PACK_BLOCK_SIZE         (1 << ROM_PACK_BLOCK_SHIFT)
+
+/** @brief Blocks are decoded into cartridge SDRAM, the SC64 flash backed areas can't be written that way */
+#define ROM_PACK_MAX_ROM_SIZE       ((64 * 1024 * 1024) - (128 * 1024))
+#define ROM_PACK_MAX_BLOCKS         (ROM_PACK_MAX_ROM_SIZE >> ROM_PACK_BLOCK_SHIFT)
+
+#define ROM_PACK_MAX_INDEX_SIZE     (ROM_PACK_HEADER_SIZE + (ROM_PACK_MAX_BLOCKS * sizeof(uint32_t)))
+
+/** @brief Parsed container header and block index. */
+typedef struct {
+    uint32_t rom_size;
+    uint32_t block_count;
+    uint32_t data_offset;
+    uint32_t stored_sizes[ROM_PACK_MAX_BLOCKS];
+} rom_pack_t;
+
+
+bool rom_pack_is_path (const char *path);
+bool rom_pack_parse (const uint8_t *data, size_t size, rom_pack_t *pack);
+uint32_t rom_pack_block_size (const rom_pack_t *pack, uint32_t index);
+bool rom_pack_block_stored (const rom_pack_t *pack, uint32_t index);
+
+/** @} */ /* menu */
+
+
+#endif
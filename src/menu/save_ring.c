@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <fatfs/diskio.h>
+#include <fatfs/ff.h>
+
+#include "../utils/fs.h"
+#include "../utils/utils.h"
+
+#include "rom_chunks.h"
+#include "save_ring.h"
+
+
+#define SAVE_RING_PATH_SIZE     (128)
+#define SAVE_RING_RECORD_MAGIC  (0x4E363453UL)  /* "N64S" */
+#define SAVE_RING_MAX_SIZE      KiB(128)
+#define SAVE_RING_MAX_RUNS      (SAVE_RING_MAX_SIZE / FS_SECTOR_SIZE)
+
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint64_t hash;
+    uint32_t timestamp;
+    uint32_t cluster;
+    uint8_t settled;
+    uint8_t __reserved[7];
+} save_ring_record_t;
+
+
+static uint8_t ring_buffer[KiB(64)] __attribute__((aligned(16)));
+
+
+static void generation_path (char *save_path, int generation, char *path) {
+    snprintf(path, SAVE_RING_PATH_SIZE, "%s.%d", save_path, generation);
+}
+
+static void slot_path (char *save_path, char *path) {
+    snprintf(path, SAVE_RING_PATH_SIZE, "%s.tmp", save_path);
+}
+
+static void record_path (char *save_path, char *path) {
+    snprintf(path, SAVE_RING_PATH_SIZE, "%s.sum", save_path);
+}
+
+static bool load_record (char *path, save_ring_record_t *record) {
+    FIL fil;
+    UINT br;
+    bool error = false;
+
+    if (f_open(&fil, strip_sd_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    if ((f_read(&fil, record, sizeof(save_ring_record_t), &br) != FR_OK) || (br != sizeof(save_ring_record_t))) {
+        error = true;
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error || (record->magic != SAVE_RING_RECORD_MAGIC);
+}
+
+// NOTE: The record is rewritten in place, a launch only flips its settled flag
+static bool write_record (char *path, save_ring_record_t *record) {
+    FIL fil;
+    UINT bw;
+    bool error = false;
+
+    if (f_open(&fil, strip_sd_prefix(path), FA_WRITE | FA_OPEN_ALWAYS) != FR_OK) {
+        return true;
+    }
+
+    if ((f_write(&fil, record, sizeof(save_ring_record_t), &bw) != FR_OK) || (bw != sizeof(save_ring_record_t))) {
+        error = true;
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+static bool store_record (char *path, char *save_path, size_t size, uint64_t hash, bool settled) {
+    save_ring_record_t record = {
+        .magic = SAVE_RING_RECORD_MAGIC,
+        .size = size,
+        .hash = hash,
+        .settled = settled,
+    };
+    size_t current_size;
+
+    if (file_get_info(save_path, &current_size, &record.timestamp) || file_get_cluster(save_path, &record.cluster)) {
+        return true;
+    }
+
+    return write_record(path, &record);
+}
+
+// NOTE: The save and the slot are moved sector run by sector run straight through the SD driver. FatFs would split
+//       every transfer at its cluster boundaries, while a file allocated in one piece is a single multi-sector command.
+//       Without a destination the source is only hashed.
+static bool transfer_file (char *source_path, char *destination_path, size_t size, uint64_t *hash) {
+    static file_run_t source_runs[SAVE_RING_MAX_RUNS];
+    static file_run_t destination_runs[SAVE_RING_MAX_RUNS];
+    uint32_t source_count;
+    uint32_t destination_count = 0;
+    FIL fil;
+    bool error = false;
+
+    if (file_get_runs(source_path, source_runs, SAVE_RING_MAX_RUNS, &source_count)) {
+        return true;
+    }
+    if (destination_path && file_get_runs(destination_path, destination_runs, SAVE_RING_MAX_RUNS, &destination_count)) {
+        return true;
+    }
+
+    if (f_open(&fil, strip_sd_prefix(source_path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    BYTE pdrv = fil.obj.fs->pdrv;
+    uint32_t sector_count = (ALIGN(size, FS_SECTOR_SIZE) / FS_SECTOR_SIZE);
+    uint32_t source_run = 0;
+    uint32_t source_offset = 0;
+    uint32_t destination_run = 0;
+    uint32_t destination_offset = 0;
+
+    *hash = ROM_CHUNKS_HASH_INIT;
+
+    for (uint32_t done = 0; done < sector_count; ) {
+        if ((source_run == source_count) || (destination_path && (destination_run == destination_count))) {
+            error = true;
+            break;
+        }
+
+        uint32_t count = MIN(sector_count - done, sizeof(ring_buffer) / FS_SECTOR_SIZE);
+        count = MIN(count, source_runs[source_run].count - source_offset);
+        if (destination_path) {
+            count = MIN(count, destination_runs[destination_run].count - destination_offset);
+        }
+
+        if (disk_read(pdrv, ring_buffer, source_runs[source_run].sector + source_offset, count) != RES_OK) {
+            error = true;
+            break;
+        }
+        if (destination_path && (disk_write(pdrv, ring_buffer, destination_runs[destination_run].sector + destination_offset, count) != RES_OK)) {
+            error = true;
+            break;
+        }
+        *hash = rom_chunks_hash(*hash, ring_buffer, MIN(count * FS_SECTOR_SIZE, size - (done * FS_SECTOR_SIZE)));
+
+        done += count;
+        source_offset += count;
+        if (source_offset == source_runs[source_run].count) {
+            source_run += 1;
+            source_offset = 0;
+        }
+        if (destination_path) {
+            destination_offset += count;
+            if (destination_offset == destination_runs[destination_run].count) {
+                destination_run += 1;
+                destination_offset = 0;
+            }
+        }
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+static bool hash_file (char *path, size_t size, uint64_t *hash) {
+    return transfer_file(path, NULL, size, hash);
+}
+
+static bool copy_file (char *source_path, char *destination_path, size_t size, uint64_t *hash) {
+    // NOTE: A slot of the right size is overwritten in place and keeps its clusters, only a new or resized one is allocated
+    if (file_get_size(destination_path) != size) {
+        if (file_delete(destination_path) || file_allocate(destination_path, size)) {
+            return true;
+        }
+    }
+
+    return transfer_file(source_path, destination_path, size, hash);
+}
+
+static bool rename_file (char *old_path, char *new_path) {
+    return (f_rename(strip_sd_prefix(old_path), strip_sd_prefix(new_path)) != FR_OK);
+}
+
+// NOTE: Save writeback goes straight to the sectors of the save and leaves its directory entry alone,
+//       a save changed by the game keeps its size and timestamp. Its contents are compared by the hash
+//       recorded for the newest generation instead, reading the save once and the newest generation never.
+static bool save_unchanged (char *save_path, char *newest_path, save_ring_record_t *record, size_t size) {
+    uint64_t hash;
+
+    if (!file_exists(newest_path)) {
+        return false;
+    }
+
+    if (record->magic != SAVE_RING_RECORD_MAGIC) {
+        // NOTE: A ring kept before records were added or a rotation cut short, the newest generation is hashed once to start one
+        if ((file_get_size(newest_path) != size) || hash_file(newest_path, size, &record->hash)) {
+            return false;
+        }
+        record->size = size;
+    }
+
+    if (record->size != size) {
+        return false;
+    }
+    if (hash_file(save_path, size, &hash)) {
+        return false;
+    }
+
+    return (hash == record->hash);
+}
+
+// NOTE: Writeback only changes the save while the title runs. A record settled since then, for a save that
+//       still has the size, date and first cluster it had, is trusted without reading the save again.
+static bool record_settled (char *save_path, save_ring_record_t *record, size_t size) {
+    size_t current_size;
+    uint32_t timestamp;
+    uint32_t cluster;
+
+    if ((record->magic != SAVE_RING_RECORD_MAGIC) || !record->settled || (record->size != size)) {
+        return false;
+    }
+    if (file_get_info(save_path, &current_size, &timestamp) || file_get_cluster(save_path, &cluster)) {
+        return false;
+    }
+
+    return (timestamp == record->timestamp) && (cluster == record->cluster);
+}
+
+static bool ring_update (char *save_path, size_t size, bool settled) {
+    char newest_path[SAVE_RING_PATH_SIZE];
+    char slot[SAVE_RING_PATH_SIZE];
+    char sum_path[SAVE_RING_PATH_SIZE];
+    save_ring_record_t record;
+    uint64_t hash;
+
+    generation_path(save_path, 1, newest_path);
+    slot_path(save_path, slot);
+    record_path(save_path, sum_path);
+
+    bool recorded = !load_record(sum_path, &record);
+    if (!recorded) {
+        record.magic = 0;
+    }
+
+    // NOTE: Launches that didn't change the save would otherwise push the older generations out of the ring
+    if (save_unchanged(save_path, newest_path, &record, size)) {
+        if (recorded && (record.settled == settled)) {
+            return false;
+        }
+        return store_record(sum_path, save_path, size, record.hash, settled);
+    }
+
+    // NOTE: The save is copied into a slot of its own, the oldest generation stays in the ring until the copy is complete.
+    //       A slot left over by an interrupted rotation holds no generation and is overwritten.
+    if (copy_file(save_path, slot, size, &hash)) {
+        return true;
+    }
+
+    // NOTE: The record of the generation about to move back is dropped first, a rotation cut short
+    //       after this point is then treated like a ring without a record instead of a stale one
+    if (file_delete(sum_path)) {
+        return true;
+    }
+
+    for (int generation = SAVE_RING_GENERATIONS - 1; generation >= 1; generation--) {
+        char from[SAVE_RING_PATH_SIZE];
+        char to[SAVE_RING_PATH_SIZE];
+        generation_path(save_path, generation, from);
+        generation_path(save_path, generation + 1, to);
+        if (file_exists(from) && (file_delete(to) || rename_file(from, to))) {
+            return true;
+        }
+    }
+
+    if (rename_file(slot, newest_path)) {
+        return true;
+    }
+
+    // NOTE: Without a record the next check hashes the newest generation again, the ring itself is complete
+    store_record(sum_path, save_path, size, hash, settled);
+
+    return false;
+}
+
+
+bool save_ring_rotate (char *save_path) {
+    char sum_path[SAVE_RING_PATH_SIZE];
+    save_ring_record_t record;
+    size_t size = file_get_size(save_path);
+
+    if (size == 0) {
+        return false;
+    }
+
+    record_path(save_path, sum_path);
+
+    // NOTE: The ring is only brought up to date here when the menu didn't settle it after the last session.
+    //       Either way the record is left unsettled, the session about to start may write the save back.
+    if (!load_record(sum_path, &record) && record_settled(save_path, &record, size)) {
+        record.settled = false;
+        if (write_record(sum_path, &record)) {
+            // NOTE: A record left settled would hide what this session writes back, without one the next check hashes again
+            file_delete(sum_path);
+            return true;
+        }
+        return false;
+    }
+
+    return ring_update(save_path, size, false);
+}
+
+bool save_ring_settle (char *save_path) {
+    char sum_path[SAVE_RING_PATH_SIZE];
+    save_ring_record_t record;
+    size_t size = file_get_size(save_path);
+
+    if (size == 0) {
+        return false;
+    }
+
+    record_path(save_path, sum_path);
+
+    if (!load_record(sum_path, &record) && record_settled(save_path, &record, size)) {
+        return false;
+    }
+
+    return ring_update(save_path, size, true);
+}
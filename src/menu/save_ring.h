@@ -0,0 +1,35 @@
+/**
+ * @file save_ring.h
+ * @brief Previous generations of save files
+ * @ingroup menu
+ */
+
+#ifndef MENU_SAVE_RING_H__
+#define MENU_SAVE_RING_H__
+
+
+#include <stdbool.h>
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+/**
+ * @brief Number of previous save generations kept per title.
+ *
+ * Generation 1 is the newest, stored next to the save as `<id>.sav.1`, older ones follow up to `<id>.sav.3`.
+ * A generation is only added when the save changed since the newest one, `<id>.sav.sum` records the size and hash of the newest.
+ * The menu settles the ring of the last played title on boot, a launch then only reads the save when that didn't happen.
+ */
+#define SAVE_RING_GENERATIONS       (3)
+
+
+bool save_ring_rotate (char *save_path);
+bool save_ring_settle (char *save_path);
+
+/** @} */ /* menu */
+
+
+#endif
@@ -0,0 +1,148 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "title_table.h"
+
+
+#define ARENA_ALIGN(x)  (((x) + 7) & ~((size_t) (7)))
+
+
+bool title_table_create (title_table_t *table, int title_count, int row_count) {
+    memset(table, 0, sizeof(title_table_t));
+
+    if ((title_count < 0) || (row_count < 0)) {
+        return true;
+    }
+
+    size_t titles_size = ARENA_ALIGN(sizeof(TitleBox) * title_count);
+    size_t slots_size = ARENA_ALIGN(sizeof(TitleBox *) * row_count * TITLE_COLUMNS);
+    size_t row_sizes_size = ARENA_ALIGN(sizeof(int) * row_count);
+    size_t row_top_size = ARENA_ALIGN(sizeof(float) * (row_count + 1));
+
+    table->arena_size = titles_size + slots_size + row_sizes_size + row_top_size;
+    table->arena = calloc(1, table->arena_size ? table->arena_size : 1);
+    if (table->arena == NULL) {
+        return true;
+    }
+
+    uint8_t *arena = table->arena;
+
+    table->titles = (TitleBox *) (arena);
+    table->title_count = title_count;
+    table->slots = (TitleBox **) (arena + titles_size);
+    table->row_sizes = (int *) (arena + titles_size + slots_size);
+    table->row_top = (float *) (arena + titles_size + slots_size + row_sizes_size);
+    table->row_count = row_count;
+    table->row_capacity = row_count;
+
+    return false;
+}
+
+void title_table_free (title_table_t *table) {
+    free(table->arena);
+    memset(table, 0, sizeof(title_table_t));
+}
+
+// Clears every slot so titles can be placed in a different order, the arena is reused as is
+bool title_table_reset (title_table_t *table, int row_count) {
+    if ((row_count < 0) || (row_count > table->row_capacity)) {
+        return true;
+    }
+
+    memset(table->slots, 0, sizeof(TitleBox *) * table->row_capacity * TITLE_COLUMNS);
+    memset(table->row_sizes, 0, sizeof(int) * table->row_capacity);
+    table->row_count = row_count;
+
+    return false;
+}
+
+bool title_table_place (title_table_t *table, int index, int row, int column) {
+    if ((index < 0) || (index >= table->title_count)) {
+        return true;
+    }
+    if ((row < 0) || (row >= table->row_count) || (column < 0) || (column >= TITLE_COLUMNS)) {
+        return true;
+    }
+
+    TitleBox **slot = &table->slots[(row * TITLE_COLUMNS) + column];
+
+    if (*slot == NULL) {
+        table->row_sizes[row] += 1;
+    }
+
+    *slot = &table->titles[index];
+    (*slot)->row = row;
+
+    return false;
+}
+
+float title_table_layout (title_table_t *table, float min_x, float max_x, float min_y) {
+    float currentRowY = min_y;
+
+    for (int y = 0; y < table->row_count; y++) {
+        int currentRowCount = table->row_sizes[y];
+        table->row_top[y] = currentRowY;
+        if (currentRowCount == 0) {
+            continue;
+        }
+
+        float rowScale = 1.0f;
+        if (currentRowCount > 2) {
+            rowScale = (max_x - min_x) / (currentRowCount * TITLE_BOX_WIDTH_E);
+        }
+        float scaledTitleX = TITLE_BOX_WIDTH_E * rowScale;
+
+        for (int x = 0; x < TITLE_COLUMNS; x++) {
+            TitleBox *current = table->slots[(y * TITLE_COLUMNS) + x];
+            if (current == NULL) {
+                continue;
+            }
+            current->scale = rowScale;
+            current->sprite.x = min_x + scaledTitleX * x;
+            current->sprite.y = currentRowY;
+        }
+
+        currentRowY += TITLE_BOX_HEIGHT_E * rowScale;
+    }
+
+    if (table->row_top) {
+        table->row_top[table->row_count] = currentRowY;
+    }
+
+    return currentRowY;
+}
+
+bool title_table_rows_in_range (title_table_t *table, float min_y, float max_y, int *first_row, int *last_row) {
+    if ((table->row_count == 0) || (min_y >= max_y)) {
+        return true;
+    }
+
+    // First row ending below min_y
+    int low = 0;
+    int high = table->row_count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (table->row_top[mid + 1] <= min_y) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    *first_row = low;
+
+    // Last row starting above max_y
+    low = *first_row;
+    high = table->row_count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (table->row_top[mid] < max_y) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    *last_row = low - 1;
+
+    return (*first_row > *last_row);
+}
@@ -0,0 +1,95 @@
+/**
+ * @file title_table.h
+ * @brief Arena-backed title table and grid layout
+ * @ingroup menu
+ */
+
+#ifndef MENU_TITLE_TABLE_H__
+#define MENU_TITLE_TABLE_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "catalog.h"
+
+
+/**
+ * @addtogroup menu
+ * @{
+ */
+
+#define TITLE_COLUMNS           (CATALOG_COLUMNS)
+
+#define TITLE_BOX_WIDTH_E       256.0f
+#define TITLE_BOX_HEIGHT_E      179.0f
+
+struct sprite_s;
+
+typedef struct SquareSprite_s {
+    float x, y;
+    float width;
+    float height;
+} SquareSprite;
+
+typedef struct TitleBox_s {
+    char id[CATALOG_ID_LENGTH + 1];
+    catalog_record_t * record;
+    struct box_art_s * image;
+    SquareSprite sprite;
+    float scale;
+    float scaleGrow;
+    float offset_x, offset_y;
+    int isSelected;
+    float selectedOutline;
+    float outlineCounter;
+    float screenX;
+    float screenY;
+    int row;
+    int art_slot;
+    uint32_t art_window;
+} TitleBox;
+
+/**
+ * @brief Title table.
+ *
+ * Titles, the row slot index, per-row title counts and row positions share a single allocation sized from the catalog.
+ */
+typedef struct {
+    void *arena;
+    size_t arena_size;
+    TitleBox *titles;
+    int title_count;
+    TitleBox **slots;
+    int *row_sizes;
+    float *row_top;
+    int row_count;
+    int row_capacity;
+} title_table_t;
+
+
+bool title_table_create (title_table_t *table, int title_count, int row_count);
+void title_table_free (title_table_t *table);
+bool title_table_reset (title_table_t *table, int row_count);
+bool title_table_place (title_table_t *table, int index, int row, int column);
+float title_table_layout (title_table_t *table, float min_x, float max_x, float min_y);
+bool title_table_rows_in_range (title_table_t *table, float min_y, float max_y, int *first_row, int *last_row);
+
+static inline int title_table_row_size (title_table_t *table, int row) {
+    if ((row < 0) || (row >= table->row_count)) {
+        return 0;
+    }
+    return table->row_sizes[row];
+}
+
+static inline TitleBox *title_table_get (title_table_t *table, int row, int column) {
+    if ((row < 0) || (row >= table->row_count) || (column < 0) || (column >= TITLE_COLUMNS)) {
+        return NULL;
+    }
+    return table->slots[(row * TITLE_COLUMNS) + column];
+}
+
+/** @} */ /* menu */
+
+
+#endif
@@ -2,12 +2,103 @@
 #include <string.h>
 #include <strings.h>
 
+#include <fatfs/diskio.h>
 #include <fatfs/ff.h>
 
 #include "fs.h"
 #include "utils.h"
 
 
+// NOTE: Contiguous save files and the save ring slots rely on f_expand(), a FatFs built without it must not go unnoticed
+#if !FF_USE_EXPAND
+#error "FF_USE_EXPAND must be enabled in the libdragon FatFs config (src/fatfs/ffconf.h)"
+#endif
+
+
+#define FAT_WINDOW_SECTORS  (8)
+#define FILL_SECTORS        (64)
+
+
+static uint8_t fill_buffer[FILL_SECTORS * FS_SECTOR_SIZE] __attribute__((aligned(16)));
+
+static uint8_t fat_window[FAT_WINDOW_SECTORS * FS_SECTOR_SIZE] __attribute__((aligned(8)));
+static LBA_t fat_window_sector;
+static uint32_t fat_window_count;
+
+static file_run_t *runs_list;
+static uint32_t runs_max;
+static uint32_t runs_count;
+static bool runs_overflow;
+
+
+static bool file_runs_callback (uint32_t sector_count, uint32_t file_sector, uint32_t run_sector, uint32_t run_size) {
+    uint32_t count = MIN(run_size, sector_count - file_sector);
+
+    if (runs_count > 0) {
+        file_run_t *last = &runs_list[runs_count - 1];
+        if ((last->sector + last->count) == run_sector) {
+            last->count += count;
+            return false;
+        }
+    }
+
+    if (runs_count == runs_max) {
+        runs_overflow = true;
+        return true;
+    }
+
+    runs_list[runs_count].sector = run_sector;
+    runs_list[runs_count].count = count;
+    runs_count += 1;
+
+    return false;
+}
+
+
+// NOTE: A run that goes on into the next FAT sector reads ahead with a single SD command, as many sectors as
+//       the run already filled and no more than the rest of the file needs. Anything else reads only the sector
+//       needed, on a fragmented card the chain jumps away long before a longer read ahead would be used.
+//       The sector held in the FatFs window may be newer than the card, it's read from there instead.
+static bool fat_next_cluster (FATFS *fs, uint32_t cluster, uint32_t run_length, uint32_t remaining, uint32_t *next) {
+    uint32_t entry_size = (fs->fs_type == FS_FAT16) ? 2 : 4;
+    uint32_t entries = (FS_SECTOR_SIZE / entry_size);
+    LBA_t sector = fs->fatbase + ((cluster * entry_size) / FS_SECTOR_SIZE);
+    uint32_t offset = ((cluster * entry_size) % FS_SECTOR_SIZE);
+    uint8_t *entry;
+
+    if (sector == fs->winsect) {
+        entry = fs->win + offset;
+    } else {
+        if ((fat_window_count == 0) || (sector < fat_window_sector) || (sector >= (fat_window_sector + fat_window_count))) {
+            bool sequential = (fat_window_count > 0) && (sector == (fat_window_sector + fat_window_count));
+            uint32_t count = 1;
+            if (sequential) {
+                count = MIN(MIN(FAT_WINDOW_SECTORS, (fs->fatbase + fs->fsize) - sector), MAX(1, run_length / entries));
+                count = MIN(count, ((offset / entry_size) + remaining + entries - 1) / entries);
+            }
+            if (disk_read(fs->pdrv, fat_window, sector, count) != RES_OK) {
+                fat_window_count = 0;
+                return true;
+            }
+            fat_window_sector = sector;
+            fat_window_count = count;
+        }
+        entry = fat_window + ((sector - fat_window_sector) * FS_SECTOR_SIZE) + offset;
+    }
+
+    if (entry_size == 2) {
+        *next = entry[0] | (entry[1] << 8);
+    } else {
+        *next = (entry[0] | (entry[1] << 8) | (entry[2] << 16) | ((uint32_t) (entry[3]) << 24));
+        if (fs->fs_type == FS_FAT32) {
+            *next &= 0x0FFFFFFF;
+        }
+    }
+
+    return false;
+}
+
+
 char *strip_sd_prefix (char *path) {
     const char *prefix = "sd:/";
 
@@ -40,6 +131,32 @@ size_t file_get_size (char *path) {
     return (size_t) (fno.fsize);
 }
 
+bool file_get_info (char *path, size_t *size, uint32_t *timestamp) {
+    FILINFO fno;
+
+    if ((f_stat(strip_sd_prefix(path), &fno) != FR_OK) || (fno.fattrib & AM_DIR)) {
+        return true;
+    }
+
+    *size = (size_t) (fno.fsize);
+    *timestamp = (((uint32_t) (fno.fdate)) << 16) | fno.ftime;
+
+    return false;
+}
+
+// NOTE: A file copied back from a backup keeps its size and date but not its clusters, the first one tells them apart
+bool file_get_cluster (char *path, uint32_t *cluster) {
+    FIL fil;
+
+    if (f_open(&fil, strip_sd_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    *cluster = fil.obj.sclust;
+
+    return (f_close(&fil) != FR_OK);
+}
+
 bool file_delete (char *path) {
     if (file_exists(path)) {
         return (f_unlink(strip_sd_prefix(path)) != FR_OK);
@@ -55,11 +172,17 @@ bool file_allocate (char *path, size_t size) {
         return true;
     }
 
-    if (f_lseek(&fil, size) != FR_OK) {
-        error = true;
-    }
+    // NOTE: A file in one piece keeps the save writeback table to a single run, a card without
+    //       enough contiguous free space still gets the file through the usual cluster by cluster extend.
+    FRESULT res = f_expand(&fil, size, 1);
 
-    if (f_tell(&fil) != size) {
+    if (res == FR_DENIED) {
+        // NOTE: FatFs stops short of the requested offset when the card is full, that's not reported as an error
+        if ((f_lseek(&fil, size) != FR_OK) || (f_tell(&fil) != size)) {
+            error = true;
+        }
+    } else if ((res != FR_OK) || (f_size(&fil) != size)) {
+        // NOTE: f_expand() sets the file size but leaves the file pointer at the start
         error = true;
     }
 
@@ -67,28 +190,32 @@ bool file_allocate (char *path, size_t size) {
         error = true;
     }
 
+    // NOTE: A file left short would be taken as an existing file of the wrong size on the next try
+    if (error) {
+        f_unlink(strip_sd_prefix(path));
+    }
+
     return error;
 }
 
 bool file_fill (char *path, uint8_t value) {
     FIL fil;
     bool error = false;
-    uint8_t buffer[FS_SECTOR_SIZE * 8];
     FRESULT res;
     UINT bytes_to_write;
     UINT bytes_written;
 
-    for (int i = 0; i < sizeof(buffer); i++) {
-        buffer[i] = value;
-    }
+    memset(fill_buffer, value, sizeof(fill_buffer));
 
     if (f_open(&fil, strip_sd_prefix(path), FA_WRITE) != FR_OK) {
         return true;
     }
 
-    for (int i = 0; i < f_size(&fil); i += sizeof(buffer)) {
-        bytes_to_write = MIN(f_size(&fil) - f_tell(&fil), sizeof(buffer));
-        res = f_write(&fil, buffer, bytes_to_write, &bytes_written);
+    // NOTE: Whole sector writes from an aligned buffer bypass the FatFs sector buffer,
+    //       each one is a single multi-sector SD command.
+    for (FSIZE_t i = 0; i < f_size(&fil); i += sizeof(fill_buffer)) {
+        bytes_to_write = MIN(f_size(&fil) - f_tell(&fil), sizeof(fill_buffer));
+        res = f_write(&fil, fill_buffer, bytes_to_write, &bytes_written);
         if ((res != FR_OK) || (bytes_to_write != bytes_written)) {
             error = true;
             break;
@@ -106,7 +233,7 @@ bool file_fill (char *path, uint8_t value) {
     return error;
 }
 
-bool file_get_sectors (char *path, void (*callback) (uint32_t sector_count, uint32_t file_sector, uint32_t cluster_sector, uint32_t cluster_size)) {
+bool file_get_sectors (char *path, bool (*callback) (uint32_t sector_count, uint32_t file_sector, uint32_t run_sector, uint32_t run_size)) {
     FATFS *fs;
     FIL fil;
     bool error = false;
@@ -122,21 +249,55 @@ bool file_get_sectors (char *path, void (*callback) (uint32_t sector_count, uint
     fs = fil.obj.fs;
 
     uint32_t sector_count = (ALIGN(f_size(&fil), FS_SECTOR_SIZE) / FS_SECTOR_SIZE);
+    uint32_t cluster = fil.obj.sclust;
 
-    uint32_t cluster_sector = 0;
+    // NOTE: exFAT files allocated in one piece carry no FAT chain at all
+    bool contiguous = (fs->fs_type == FS_EXFAT) && ((fil.obj.stat & 3) == 2);
 
-    for (int file_sector = 0; file_sector < sector_count; file_sector += fs->csize) {
-        if ((f_lseek(&fil, (file_sector * FS_SECTOR_SIZE) + (FS_SECTOR_SIZE / 2))) != FR_OK) {
+    // NOTE: FAT12 entries straddle bytes and sectors, such small volumes keep the walk through FatFs
+    bool walk_fat = (fs->fs_type != FS_FAT12);
+
+    fat_window_count = 0;
+
+    for (uint32_t file_sector = 0; (file_sector < sector_count) && !error; ) {
+        if ((cluster < 2) || (cluster >= fs->n_fatent)) {
             error = true;
             break;
         }
-        uint32_t cluster = fil.clust;
-        if (cluster >= fs->n_fatent) {
-            error = true;
-            break;
+
+        uint32_t first = cluster;
+        uint32_t length = 1;
+        uint32_t needed = ((sector_count - file_sector) + fs->csize - 1) / fs->csize;
+
+        if (contiguous) {
+            length = needed;
+        } else if (!walk_fat) {
+            if (f_lseek(&fil, ((file_sector + fs->csize) * FS_SECTOR_SIZE) + (FS_SECTOR_SIZE / 2)) != FR_OK) {
+                error = true;
+                break;
+            }
+            cluster = fil.clust;
+        } else {
+            // One pass over the chain, adjacent clusters grow the current run
+            while (length < needed) {
+                if (fat_next_cluster(fs, cluster, length, needed - length, &cluster)) {
+                    error = true;
+                    break;
+                }
+                if (cluster != (first + length)) {
+                    break;
+                }
+                length += 1;
+            }
+        }
+
+        if (!error) {
+            // NOTE: The callback stops the walk once it has no use for the rest of the chain
+            if (callback(sector_count, file_sector, fs->database + ((LBA_t) (fs->csize) * (first - 2)), length * fs->csize)) {
+                break;
+            }
+            file_sector += length * fs->csize;
         }
-        cluster_sector = (fs->database + ((LBA_t) (fs->csize) * (cluster - 2)));
-        callback(sector_count, file_sector, cluster_sector, fs->csize);
     }
 
     if (f_close(&fil) != FR_OK) {
@@ -146,6 +307,19 @@ bool file_get_sectors (char *path, void (*callback) (uint32_t sector_count, uint
     return error;
 }
 
+bool file_get_runs (char *path, file_run_t *runs, uint32_t max_runs, uint32_t *run_count) {
+    runs_list = runs;
+    runs_max = max_runs;
+    runs_count = 0;
+    runs_overflow = false;
+
+    bool error = file_get_sectors(path, file_runs_callback);
+
+    *run_count = runs_count;
+
+    return (error || runs_overflow);
+}
+
 bool file_has_extensions (char *path, const char *extensions[]) {
     char *ext = strrchr(path, '.');
 
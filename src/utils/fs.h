@@ -10,14 +10,23 @@
 #define FS_SECTOR_SIZE      (512)
 
 
+typedef struct {
+    uint32_t sector;
+    uint32_t count;
+} file_run_t;
+
+
 char *strip_sd_prefix (char *path);
 
 bool file_exists (char *path);
 size_t file_get_size (char *path);
+bool file_get_info (char *path, size_t *size, uint32_t *timestamp);
+bool file_get_cluster (char *path, uint32_t *cluster);
 bool file_delete (char *path);
 bool file_allocate (char *path, size_t size);
 bool file_fill (char *path, uint8_t value);
-bool file_get_sectors (char *path, void (*callback) (uint32_t sector_count, uint32_t file_sector, uint32_t cluster_sector, uint32_t cluster_size));
+bool file_get_sectors (char *path, bool (*callback) (uint32_t sector_count, uint32_t file_sector, uint32_t run_sector, uint32_t run_size));
+bool file_get_runs (char *path, file_run_t *runs, uint32_t max_runs, uint32_t *run_count);
 bool file_has_extensions (char *path, const char *extensions[]);
 
 bool directory_exists (char *path);
@@ -0,0 +1,75 @@
+#include <string.h>
+#include <strings.h>
+
+#include "rom_order.h"
+
+
+rom_order_t rom_order_detect (const uint8_t *header) {
+    if (memcmp(header, "\x80\x37\x12\x40", 4) == 0) {
+        return ROM_ORDER_Z64;
+    }
+    if (memcmp(header, "\x37\x80\x40\x12", 4) == 0) {
+        return ROM_ORDER_V64;
+    }
+    if (memcmp(header, "\x40\x12\x37\x80", 4) == 0) {
+        return ROM_ORDER_N64;
+    }
+    return ROM_ORDER_UNKNOWN;
+}
+
+rom_order_t rom_order_from_extension (const char *path) {
+    const char *extension = strrchr(path, '.');
+
+    if (extension == NULL) {
+        return ROM_ORDER_UNKNOWN;
+    }
+    if (strcasecmp(extension, ".z64") == 0) {
+        return ROM_ORDER_Z64;
+    }
+    if (strcasecmp(extension, ".v64") == 0) {
+        return ROM_ORDER_V64;
+    }
+    if (strcasecmp(extension, ".n64") == 0) {
+        return ROM_ORDER_N64;
+    }
+    return ROM_ORDER_UNKNOWN;
+}
+
+// NOTE: Both swaps work a 32-bit word at a time, a word load and store replace four byte loads and stores.
+//       Buffers must be word aligned, a trailing halfword is swapped on its own.
+void rom_order_swap_16 (void *data, size_t length) {
+    uint32_t *words = (uint32_t *) (data);
+
+    for (size_t i = 0; i < (length / 4); i++) {
+        uint32_t w = words[i];
+        words[i] = ((w & 0x00FF00FFUL) << 8) | ((w >> 8) & 0x00FF00FFUL);
+    }
+
+    if (length & 2) {
+        uint8_t *tail = (uint8_t *) (data) + (length & ~3);
+        uint8_t t = tail[0];
+        tail[0] = tail[1];
+        tail[1] = t;
+    }
+}
+
+void rom_order_swap_32 (void *data, size_t length) {
+    uint32_t *words = (uint32_t *) (data);
+
+    for (size_t i = 0; i < (length / 4); i++) {
+        words[i] = __builtin_bswap32(words[i]);
+    }
+}
+
+void rom_order_convert (void *data, size_t length, rom_order_t order) {
+    switch (order) {
+        case ROM_ORDER_V64:
+            rom_order_swap_16(data, length);
+            break;
+        case ROM_ORDER_N64:
+            rom_order_swap_32(data, length);
+            break;
+        default:
+            break;
+    }
+}
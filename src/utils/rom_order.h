@@ -0,0 +1,24 @@
+#ifndef UTILS_ROM_ORDER_H__
+#define UTILS_ROM_ORDER_H__
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+typedef enum {
+    ROM_ORDER_Z64,
+    ROM_ORDER_V64,
+    ROM_ORDER_N64,
+    ROM_ORDER_UNKNOWN,
+} rom_order_t;
+
+
+rom_order_t rom_order_detect (const uint8_t *header);
+rom_order_t rom_order_from_extension (const char *path);
+void rom_order_swap_16 (void *data, size_t length);
+void rom_order_swap_32 (void *data, size_t length);
+void rom_order_convert (void *data, size_t length, rom_order_t order);
+
+
+#endif
@@ -0,0 +1,481 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/menu/lz.h"
+
+#include "artcodec.h"
+#include "common.h"
+
+
+#define LZ_HASH_BITS        (16)
+#define LZ_HASH_SIZE        (1 << LZ_HASH_BITS)
+#define LZ_WINDOW           (LZ_MAX_OFFSET + 1)
+#define LZ_CHAIN_DEPTH      (32)
+#define LZ_NO_POSITION      (-1)
+
+#define SPRITE_HEADER_SIZE      (8)
+#define SPRITE_FLAGS_TEXFORMAT  (0x1F)
+
+#define CI8_COLORS          (256)
+#define RGB555_COLORS       (32768)
+
+
+static const struct {
+    const char *name;
+    art_encoding_t encoding;
+} encodings[] = {
+    { "rgba16", { ART_PACK_FORMAT_RGBA16, ART_PACK_COMPRESSION_NONE } },
+    { "rgba16-lz", { ART_PACK_FORMAT_RGBA16, ART_PACK_COMPRESSION_LZ } },
+    { "ci8", { ART_PACK_FORMAT_CI8, ART_PACK_COMPRESSION_NONE } },
+    { "ci8-lz", { ART_PACK_FORMAT_CI8, ART_PACK_COMPRESSION_LZ } },
+};
+
+
+static uint32_t lz_hash (const uint8_t *p) {
+    uint32_t v = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+static uint8_t *lz_put_length (uint8_t *p, size_t length) {
+    while (length >= 255) {
+        *p++ = 255;
+        length -= 255;
+    }
+    *p++ = length;
+    return p;
+}
+
+static uint8_t *lz_put_sequence (uint8_t *p, const uint8_t *literals, size_t literal_count, size_t offset, size_t match_length) {
+    size_t match_code = (match_length > 0) ? (match_length - LZ_MIN_MATCH) : 0;
+
+    *p++ = (MIN(literal_count, 15) << 4) | MIN(match_code, 15);
+    if (literal_count >= 15) {
+        p = lz_put_length(p, literal_count - 15);
+    }
+
+    memcpy(p, literals, literal_count);
+    p += literal_count;
+
+    if (match_length > 0) {
+        put_u16(p, offset);
+        p += 2;
+        if (match_code >= 15) {
+            p = lz_put_length(p, match_code - 15);
+        }
+    }
+
+    return p;
+}
+
+size_t lz_compress (const uint8_t *src, size_t size, uint8_t *dst, size_t capacity) {
+    if (capacity < LZ_BOUND(size)) {
+        return 0;
+    }
+
+    int32_t *head = xmalloc(LZ_HASH_SIZE * sizeof(int32_t));
+    int32_t *chain = xmalloc(LZ_WINDOW * sizeof(int32_t));
+
+    for (int i = 0; i < LZ_HASH_SIZE; i++) {
+        head[i] = LZ_NO_POSITION;
+    }
+
+    uint8_t *p = dst;
+    size_t anchor = 0;
+    size_t pos = 0;
+
+    while ((pos + LZ_MIN_MATCH) <= size) {
+        uint32_t hash = lz_hash(src + pos);
+        size_t best_length = 0;
+        size_t best_offset = 0;
+
+        int32_t candidate = head[hash];
+        for (int depth = 0; (depth < LZ_CHAIN_DEPTH) && (candidate != LZ_NO_POSITION); depth++) {
+            size_t offset = pos - candidate;
+            if (offset > LZ_MAX_OFFSET) {
+                break;
+            }
+            size_t length = 0;
+            size_t limit = size - pos;
+            while ((length < limit) && (src[candidate + length] == src[pos + length])) {
+                length += 1;
+            }
+            if (length > best_length) {
+                best_length = length;
+                best_offset = offset;
+            }
+            candidate = chain[candidate % LZ_WINDOW];
+        }
+
+        chain[pos % LZ_WINDOW] = head[hash];
+        head[hash] = pos;
+
+        if (best_length < LZ_MIN_MATCH) {
+            pos += 1;
+            continue;
+        }
+
+        p = lz_put_sequence(p, src + anchor, pos - anchor, best_offset, best_length);
+
+        // Matched bytes still feed the hash chains so later matches can reference them
+        for (size_t i = pos + 1; (i < (pos + best_length)) && ((i + LZ_MIN_MATCH) <= size); i++) {
+            uint32_t skipped = lz_hash(src + i);
+            chain[i % LZ_WINDOW] = head[skipped];
+            head[skipped] = i;
+        }
+
+        pos += best_length;
+        anchor = pos;
+    }
+
+    if (anchor < size) {
+        p = lz_put_sequence(p, src + anchor, size - anchor, 0, 0);
+    }
+
+    free(chain);
+    free(head);
+
+    return p - dst;
+}
+
+
+typedef struct {
+    uint16_t color;
+    uint32_t count;
+} quantize_color_t;
+
+typedef struct {
+    int first;
+    int count;
+} quantize_box_t;
+
+static int color_channel (uint16_t color, int channel) {
+    return (color >> (11 - (channel * 5))) & 0x1F;
+}
+
+static int quantize_axis;
+
+static int compare_channel (const void *a, const void *b) {
+    return color_channel(((const quantize_color_t *) (a))->color, quantize_axis) - color_channel(((const quantize_color_t *) (b))->color, quantize_axis);
+}
+
+static int box_longest_axis (quantize_color_t *colors, quantize_box_t *box, int *range) {
+    int min[3] = { 31, 31, 31 };
+    int max[3] = { 0, 0, 0 };
+
+    for (int i = box->first; i < (box->first + box->count); i++) {
+        for (int channel = 0; channel < 3; channel++) {
+            int value = color_channel(colors[i].color, channel);
+            min[channel] = MIN(min[channel], value);
+            max[channel] = MAX(max[channel], value);
+        }
+    }
+
+    int axis = 0;
+    for (int channel = 1; channel < 3; channel++) {
+        if ((max[channel] - min[channel]) > (max[axis] - min[axis])) {
+            axis = channel;
+        }
+    }
+    *range = max[axis] - min[axis];
+
+    return axis;
+}
+
+static uint16_t box_average (quantize_color_t *colors, quantize_box_t *box) {
+    uint64_t sum[3] = { 0, 0, 0 };
+    uint64_t total = 0;
+
+    for (int i = box->first; i < (box->first + box->count); i++) {
+        for (int channel = 0; channel < 3; channel++) {
+            sum[channel] += (uint64_t) (color_channel(colors[i].color, channel)) * colors[i].count;
+        }
+        total += colors[i].count;
+    }
+
+    uint16_t color = 0x0001;
+    for (int channel = 0; channel < 3; channel++) {
+        color |= ((sum[channel] + (total / 2)) / total) << (11 - (channel * 5));
+    }
+
+    return color;
+}
+
+static int nearest_color (uint16_t color, const uint16_t *palette, int first, int count) {
+    int best = first;
+    int best_distance = 1 << 30;
+
+    for (int i = first; i < count; i++) {
+        int distance = 0;
+        for (int channel = 0; channel < 3; channel++) {
+            int delta = color_channel(color, channel) - color_channel(palette[i], channel);
+            distance += delta * delta;
+        }
+        if (distance < best_distance) {
+            best = i;
+            best_distance = distance;
+        }
+    }
+
+    return best;
+}
+
+int quantize_ci8 (const uint16_t *pixels, size_t count, uint16_t *palette, uint8_t *indices) {
+    uint32_t *histogram = xcalloc(RGB555_COLORS, sizeof(uint32_t));
+    bool transparent = false;
+
+    for (size_t i = 0; i < count; i++) {
+        if ((pixels[i] & 0x0001) == 0) {
+            transparent = true;
+        } else {
+            histogram[pixels[i] >> 1] += 1;
+        }
+    }
+
+    // NOTE: Transparent pixels share a reserved black entry at index 0, median cut only sees opaque colors
+    int first = transparent ? 1 : 0;
+    int available = CI8_COLORS - first;
+
+    quantize_color_t *colors = xmalloc(RGB555_COLORS * sizeof(quantize_color_t));
+    int color_count = 0;
+    for (int i = 0; i < RGB555_COLORS; i++) {
+        if (histogram[i] > 0) {
+            colors[color_count++] = (quantize_color_t) { .color = (i << 1) | 1, .count = histogram[i] };
+        }
+    }
+
+    quantize_box_t boxes[CI8_COLORS];
+    int box_count = 0;
+    if (color_count > 0) {
+        boxes[box_count++] = (quantize_box_t) { .first = 0, .count = color_count };
+    }
+
+    while (box_count < MIN(available, color_count)) {
+        int split = -1;
+        int split_axis = 0;
+        uint64_t split_score = 0;
+
+        for (int i = 0; i < box_count; i++) {
+            if (boxes[i].count < 2) {
+                continue;
+            }
+            int range;
+            int axis = box_longest_axis(colors, &boxes[i], &range);
+            uint64_t pixels_in_box = 0;
+            for (int c = boxes[i].first; c < (boxes[i].first + boxes[i].count); c++) {
+                pixels_in_box += colors[c].count;
+            }
+            uint64_t score = (uint64_t) (range + 1) * pixels_in_box;
+            if (score > split_score) {
+                split = i;
+                split_axis = axis;
+                split_score = score;
+            }
+        }
+
+        if (split < 0) {
+            break;
+        }
+
+        quantize_box_t *box = &boxes[split];
+        quantize_axis = split_axis;
+        qsort(&colors[box->first], box->count, sizeof(quantize_color_t), compare_channel);
+
+        uint64_t total = 0;
+        for (int c = box->first; c < (box->first + box->count); c++) {
+            total += colors[c].count;
+        }
+        uint64_t half = 0;
+        int median = box->first;
+        while ((median < (box->first + box->count - 1)) && ((half + colors[median].count) <= (total / 2))) {
+            half += colors[median].count;
+            median += 1;
+        }
+        if (median == box->first) {
+            median += 1;
+        }
+
+        boxes[box_count++] = (quantize_box_t) { .first = median, .count = box->first + box->count - median };
+        box->count = median - box->first;
+    }
+
+    if (transparent) {
+        palette[0] = 0x0000;
+    }
+    for (int i = 0; i < box_count; i++) {
+        palette[first + i] = box_average(colors, &boxes[i]);
+    }
+    int palette_colors = first + box_count;
+
+    // Reuse the histogram as a color to index map, every opaque color is matched once
+    for (int i = 0; i < RGB555_COLORS; i++) {
+        histogram[i] = (histogram[i] > 0) ? nearest_color((i << 1) | 1, palette, first, palette_colors) : 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        indices[i] = ((pixels[i] & 0x0001) == 0) ? 0 : histogram[pixels[i] >> 1];
+    }
+
+    free(colors);
+    free(histogram);
+
+    return MAX(palette_colors, 1);
+}
+
+
+bool art_image_from_sprite (const uint8_t *data, size_t size, art_image_t *image) {
+    if (size < SPRITE_HEADER_SIZE) {
+        return true;
+    }
+
+    image->width = get_u16(data + 0);
+    image->height = get_u16(data + 2);
+
+    if ((data[5] & SPRITE_FLAGS_TEXFORMAT) != ART_PACK_FORMAT_RGBA16) {
+        return true;
+    }
+
+    size_t count = image->width * image->height;
+    if ((SPRITE_HEADER_SIZE + (count * sizeof(uint16_t))) > size) {
+        return true;
+    }
+
+    image->pixels = xmalloc(MAX(count, 1) * sizeof(uint16_t));
+    for (size_t i = 0; i < count; i++) {
+        image->pixels[i] = get_u16(data + SPRITE_HEADER_SIZE + (i * sizeof(uint16_t)));
+    }
+
+    return false;
+}
+
+size_t art_image_to_sprite (const art_image_t *image, uint8_t **data) {
+    size_t count = image->width * image->height;
+    size_t size = SPRITE_HEADER_SIZE + (count * sizeof(uint16_t));
+    uint8_t *p = xmalloc(size);
+
+    put_u16(p + 0, image->width);
+    put_u16(p + 2, image->height);
+    put_u8(p + 4, sizeof(uint16_t));
+    put_u8(p + 5, ART_PACK_FORMAT_RGBA16);
+    put_u8(p + 6, 1);
+    put_u8(p + 7, 1);
+
+    for (size_t i = 0; i < count; i++) {
+        put_u16(p + SPRITE_HEADER_SIZE + (i * sizeof(uint16_t)), image->pixels[i]);
+    }
+
+    *data = p;
+
+    return size;
+}
+
+void art_image_downscale (const art_image_t *source, art_image_t *image) {
+    image->width = MAX((source->width + 1) / 2, 1);
+    image->height = MAX((source->height + 1) / 2, 1);
+    image->pixels = xmalloc(image->width * image->height * sizeof(uint16_t));
+
+    // 2x2 box filter, odd edges reuse the last row or column
+    for (int y = 0; y < image->height; y++) {
+        for (int x = 0; x < image->width; x++) {
+            int sum[3] = { 0, 0, 0 };
+            int opaque = 0;
+            for (int i = 0; i < 4; i++) {
+                int sx = MIN((x * 2) + (i & 1), source->width - 1);
+                int sy = MIN((y * 2) + (i >> 1), source->height - 1);
+                uint16_t color = source->pixels[(sy * source->width) + sx];
+                for (int channel = 0; channel < 3; channel++) {
+                    sum[channel] += color_channel(color, channel);
+                }
+                opaque += (color & 0x0001);
+            }
+            uint16_t color = (opaque >= 2) ? 0x0001 : 0x0000;
+            for (int channel = 0; channel < 3; channel++) {
+                color |= ((sum[channel] + 2) / 4) << (11 - (channel * 5));
+            }
+            image->pixels[(y * image->width) + x] = color;
+        }
+    }
+}
+
+void art_image_free (art_image_t *image) {
+    free(image->pixels);
+    image->pixels = NULL;
+}
+
+size_t art_image_encode (const art_image_t *image, art_encoding_t encoding, uint8_t **blob) {
+    size_t count = image->width * image->height;
+    uint16_t palette_colors = 0;
+    size_t data_size;
+    uint8_t *data;
+
+    if (encoding.format == ART_PACK_FORMAT_CI8) {
+        uint16_t palette[CI8_COLORS] = { 0 };
+        uint8_t *indices = xmalloc(MAX(count, 1));
+        palette_colors = quantize_ci8(image->pixels, count, palette, indices);
+        size_t palette_size = ALIGN(palette_colors * sizeof(uint16_t), 8);
+        data_size = palette_size + count;
+        data = xcalloc(1, data_size);
+        for (int i = 0; i < palette_colors; i++) {
+            put_u16(data + (i * sizeof(uint16_t)), palette[i]);
+        }
+        memcpy(data + palette_size, indices, count);
+        free(indices);
+    } else {
+        data_size = count * sizeof(uint16_t);
+        data = xmalloc(MAX(data_size, 1));
+        for (size_t i = 0; i < count; i++) {
+            put_u16(data + (i * sizeof(uint16_t)), image->pixels[i]);
+        }
+    }
+
+    uint8_t *stored = data;
+    size_t stored_size = data_size;
+    uint8_t compression = ART_PACK_COMPRESSION_NONE;
+
+    if (encoding.compression == ART_PACK_COMPRESSION_LZ) {
+        uint8_t *compressed = xmalloc(LZ_BOUND(data_size));
+        size_t compressed_size = lz_compress(data, data_size, compressed, LZ_BOUND(data_size));
+        // NOTE: Incompressible images are stored as-is, they are then read straight into the texture buffer
+        if ((compressed_size > 0) && (compressed_size < data_size)) {
+            stored = compressed;
+            stored_size = compressed_size;
+            compression = ART_PACK_COMPRESSION_LZ;
+        } else {
+            free(compressed);
+        }
+    }
+
+    *blob = xcalloc(1, sizeof(art_pack_image_t) + stored_size);
+    put_u16(*blob + 0, image->width);
+    put_u16(*blob + 2, image->height);
+    put_u8(*blob + 4, encoding.format);
+    put_u8(*blob + 5, compression);
+    put_u16(*blob + 6, palette_colors);
+    put_u32(*blob + 8, data_size);
+    put_u32(*blob + 12, stored_size);
+    memcpy(*blob + sizeof(art_pack_image_t), stored, stored_size);
+
+    if (stored != data) {
+        free(stored);
+    }
+    free(data);
+
+    return sizeof(art_pack_image_t) + stored_size;
+}
+
+bool art_encoding_parse (const char *name, art_encoding_t *encoding) {
+    for (size_t i = 0; i < sizeof(encodings) / sizeof(encodings[0]); i++) {
+        if (strcmp(name, encodings[i].name) == 0) {
+            *encoding = encodings[i].encoding;
+            return false;
+        }
+    }
+    return true;
+}
+
+const char *art_encoding_name (art_encoding_t encoding) {
+    for (size_t i = 0; i < sizeof(encodings) / sizeof(encodings[0]); i++) {
+        if ((encodings[i].encoding.format == encoding.format) && (encodings[i].encoding.compression == encoding.compression)) {
+            return encodings[i].name;
+        }
+    }
+    return "unknown";
+}
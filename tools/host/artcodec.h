@@ -0,0 +1,37 @@
+#ifndef HOST_ARTCODEC_H__
+#define HOST_ARTCODEC_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../src/menu/art_pack.h"
+
+
+/** @brief Decoded RGBA16 box art, pixels are in host byte order. */
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t *pixels;
+} art_image_t;
+
+typedef struct {
+    uint8_t format;
+    uint8_t compression;
+} art_encoding_t;
+
+
+size_t lz_compress (const uint8_t *src, size_t size, uint8_t *dst, size_t capacity);
+int quantize_ci8 (const uint16_t *pixels, size_t count, uint16_t *palette, uint8_t *indices);
+
+bool art_image_from_sprite (const uint8_t *data, size_t size, art_image_t *image);
+size_t art_image_to_sprite (const art_image_t *image, uint8_t **data);
+void art_image_downscale (const art_image_t *source, art_image_t *image);
+void art_image_free (art_image_t *image);
+size_t art_image_encode (const art_image_t *image, art_encoding_t encoding, uint8_t **blob);
+bool art_encoding_parse (const char *name, art_encoding_t *encoding);
+const char *art_encoding_name (art_encoding_t encoding);
+
+
+#endif
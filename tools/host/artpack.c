@@ -0,0 +1,438 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/menu/art_pack.h"
+#include "../../src/menu/lz.h"
+
+#include "artcodec.h"
+#include "catalog.h"
+#include "commands.h"
+#include "common.h"
+
+
+#define MIN_LEVEL_WIDTH     (16)
+
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t first_size;
+    uint16_t width;
+    uint16_t height;
+    uint8_t compression;
+    uint8_t level_count;
+} art_file_t;
+
+
+static char *sprite_path (const char *root, const char *id) {
+    return path_printf("%s/menu/title/%s/%s_e.sprite", root, id, id);
+}
+
+static bool sprite_is_compressed (const uint8_t *data, size_t size) {
+    return (size >= 4) && (memcmp(data, "DCA3", 4) == 0);
+}
+
+static void pack_entry_serialize (uint8_t *p, const char *id, uint32_t offset, const art_file_t *file, art_encoding_t encoding) {
+    memset(p, 0, sizeof(art_pack_entry_t));
+    memcpy(p, id, CATALOG_ID_LENGTH);
+    put_u32(p + 8, offset);
+    put_u32(p + 12, file->size);
+    put_u16(p + 16, file->width);
+    put_u16(p + 18, file->height);
+    put_u8(p + 20, encoding.format);
+    put_u8(p + 21, file->compression);
+    put_u8(p + 22, file->level_count);
+}
+
+static void build_entry (art_image_t *image, art_encoding_t encoding, int max_levels, art_file_t *file) {
+    art_image_t levels[ART_PACK_MAX_LEVELS] = { *image };
+    uint8_t *blobs[ART_PACK_MAX_LEVELS];
+    size_t blob_sizes[ART_PACK_MAX_LEVELS];
+    int level_count = 1;
+
+    while ((level_count < max_levels) && ((levels[level_count - 1].width / 2) >= MIN_LEVEL_WIDTH)) {
+        art_image_downscale(&levels[level_count - 1], &levels[level_count]);
+        level_count += 1;
+    }
+
+    for (int i = 0; i < level_count; i++) {
+        blob_sizes[i] = art_image_encode(&levels[i], encoding, &blobs[i]);
+    }
+
+    // Level table and the smallest level come first and fill the first read, larger levels follow sector aligned
+    int smallest = level_count - 1;
+    size_t level_offset[ART_PACK_MAX_LEVELS];
+    level_offset[smallest] = sizeof(art_pack_levels_t);
+    size_t size = ALIGN(level_offset[smallest] + blob_sizes[smallest], ART_PACK_ALIGNMENT);
+    for (int i = smallest - 1; i >= 0; i--) {
+        level_offset[i] = size;
+        size += ALIGN(blob_sizes[i], ART_PACK_ALIGNMENT);
+    }
+
+    file->data = xcalloc(1, size);
+    file->size = size;
+    file->first_size = level_offset[smallest] + blob_sizes[smallest];
+    file->width = image->width;
+    file->height = image->height;
+    file->compression = blobs[0][5];
+    file->level_count = level_count;
+
+    put_u8(file->data + 0, level_count);
+    put_u16(file->data + 2, image->width);
+    put_u16(file->data + 4, image->height);
+    for (int i = 0; i < level_count; i++) {
+        put_u32(file->data + 8 + (i * 4), level_offset[i]);
+        put_u32(file->data + 8 + (ART_PACK_MAX_LEVELS * 4) + (i * 4), blob_sizes[i]);
+        memcpy(file->data + level_offset[i], blobs[i], blob_sizes[i]);
+        free(blobs[i]);
+    }
+
+    for (int i = 1; i < level_count; i++) {
+        art_image_free(&levels[i]);
+    }
+}
+
+
+int cmd_pack_art (int argc, char **argv) {
+    art_encoding_t encoding = { ART_PACK_FORMAT_RGBA16, ART_PACK_COMPRESSION_NONE };
+    int max_levels = ART_PACK_MAX_LEVELS;
+
+    while ((argc == 3) || (argc == 5)) {
+        if (strcmp(argv[0], "--format") == 0) {
+            if (art_encoding_parse(argv[1], &encoding)) {
+                die("unknown format %s, expected rgba16, rgba16-lz, ci8 or ci8-lz", argv[1]);
+            }
+        } else if (strcmp(argv[0], "--levels") == 0) {
+            max_levels = atoi(argv[1]);
+            if ((max_levels < 1) || (max_levels > ART_PACK_MAX_LEVELS)) {
+                die("level count must be between 1 and %d", ART_PACK_MAX_LEVELS);
+            }
+        } else {
+            break;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc != 1) {
+        fprintf(stderr, "usage: n64menu-tool pack-art [--format rgba16|rgba16-lz|ci8|ci8-lz] [--levels 1-%d] <sd-root>\n", ART_PACK_MAX_LEVELS);
+        return EXIT_FAILURE;
+    }
+
+    char *catalog_path = path_join(argv[0], "menu/catalog.bin");
+    char *pack_path = path_join(argv[0], "menu/art.pak");
+    size_t source_bytes = 0;
+
+    catalog_list_t list;
+    if (catalog_read(catalog_path, &list)) {
+        die("couldn't read catalog %s, run the catalog command first", catalog_path);
+    }
+
+    art_file_t *files = xcalloc(MAX(list.count, 1), sizeof(art_file_t));
+    uint32_t packed = 0;
+
+    for (uint32_t i = 0; i < list.count; i++) {
+        catalog_entry_t *entry = &list.entries[i];
+        char *path = sprite_path(argv[0], entry->id);
+
+        entry->sprite_offset = 0;
+        entry->sprite_size = 0;
+
+        uint8_t *data;
+        size_t size;
+        art_image_t image;
+
+        if (file_read_all(path, &data, &size)) {
+            fprintf(stderr, "%s: no box art, skipping\n", entry->id);
+            free(path);
+            continue;
+        }
+
+        if (sprite_is_compressed(data, size)) {
+            // NOTE: DCA3 sprites are only understood by sprite_load, they stay as per-title files
+            fprintf(stderr, "%s: sprite is compressed, keeping the per-title file\n", entry->id);
+        } else if (art_image_from_sprite(data, size, &image)) {
+            fprintf(stderr, "%s: not an RGBA16 sprite, keeping the per-title file\n", entry->id);
+        } else {
+            build_entry(&image, encoding, max_levels, &files[i]);
+            source_bytes += size;
+            art_image_free(&image);
+            packed += 1;
+        }
+
+        free(data);
+        free(path);
+    }
+
+    size_t entries_offset = sizeof(art_pack_header_t);
+    size_t data_offset = ALIGN(entries_offset + (packed * sizeof(art_pack_entry_t)), ART_PACK_ALIGNMENT);
+    size_t pack_size = data_offset;
+
+    for (uint32_t i = 0; i < list.count; i++) {
+        pack_size += ALIGN(files[i].size, ART_PACK_ALIGNMENT);
+    }
+
+    uint8_t *pack = xcalloc(1, pack_size);
+
+    put_u32(pack + 0, ART_PACK_MAGIC);
+    put_u16(pack + 4, ART_PACK_VERSION);
+    put_u16(pack + 6, sizeof(art_pack_entry_t));
+    put_u32(pack + 8, packed);
+    put_u32(pack + 12, entries_offset);
+    put_u32(pack + 16, data_offset);
+
+    uint8_t *p = pack + entries_offset;
+    size_t offset = data_offset;
+
+    for (uint32_t i = 0; i < list.count; i++) {
+        if (files[i].data == NULL) {
+            continue;
+        }
+
+        catalog_entry_t *entry = &list.entries[i];
+        entry->sprite_offset = offset;
+        entry->sprite_size = files[i].first_size;
+
+        pack_entry_serialize(p, entry->id, offset, &files[i], encoding);
+        memcpy(pack + offset, files[i].data, files[i].size);
+
+        p += sizeof(art_pack_entry_t);
+        offset += ALIGN(files[i].size, ART_PACK_ALIGNMENT);
+
+        free(files[i].data);
+    }
+
+    if (file_write_all(pack_path, pack, pack_size)) {
+        die("couldn't write %s", pack_path);
+    }
+    if (catalog_write(catalog_path, &list)) {
+        die("couldn't write %s", catalog_path);
+    }
+
+    printf("Packed %u of %u sprite(s) as %s into %s (%zu bytes, sources %zu bytes)\n",
+        packed, list.count, art_encoding_name(encoding), pack_path, pack_size, source_bytes
+    );
+
+    free(pack);
+    free(files);
+    free(pack_path);
+    free(catalog_path);
+    catalog_list_free(&list);
+
+    return EXIT_SUCCESS;
+}
+
+int cmd_bench_art (int argc, char **argv) {
+    if ((argc < 1) || (argc > 2)) {
+        fprintf(stderr, "usage: n64menu-tool bench-art <sd-root> [iterations]\n");
+        return EXIT_FAILURE;
+    }
+
+    int iterations = (argc > 1) ? atoi(argv[1]) : 10;
+
+    char *catalog_path = path_join(argv[0], "menu/catalog.bin");
+    char *pack_path = path_join(argv[0], "menu/art.pak");
+
+    catalog_list_t list;
+    if (catalog_read(catalog_path, &list)) {
+        die("couldn't read catalog %s", catalog_path);
+    }
+
+    uint8_t *buffer = xmalloc(MiB(1));
+    uint64_t file_bytes = 0;
+    uint64_t pack_bytes = 0;
+    uint32_t file_opens = 0;
+    uint32_t pack_reads = 0;
+
+    double start = time_now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        for (uint32_t i = 0; i < list.count; i++) {
+            char *path = sprite_path(argv[0], list.entries[i].id);
+            FILE *f = fopen(path, "rb");
+            free(path);
+            if (f == NULL) {
+                continue;
+            }
+            file_opens += 1;
+            file_bytes += fread(buffer, 1, MiB(1), f);
+            fclose(f);
+        }
+    }
+    double file_time = (time_now() - start) / iterations;
+
+    FILE *pack = fopen(pack_path, "rb");
+    if (pack == NULL) {
+        die("couldn't open %s, run the pack-art command first", pack_path);
+    }
+
+    start = time_now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        for (uint32_t i = 0; i < list.count; i++) {
+            catalog_entry_t *entry = &list.entries[i];
+            size_t read_size = ALIGN(entry->sprite_size, ART_PACK_ALIGNMENT);
+            if ((read_size == 0) || (read_size > MiB(1))) {
+                continue;
+            }
+            fseek(pack, entry->sprite_offset, SEEK_SET);
+            pack_reads += 1;
+            pack_bytes += fread(buffer, 1, read_size, pack);
+        }
+    }
+    double pack_time = (time_now() - start) / iterations;
+
+    fclose(pack);
+
+    printf("per-title files  %6u open(s)  %10llu bytes  %8.3f ms/pass\n",
+        file_opens / iterations, (unsigned long long) (file_bytes / iterations), file_time * 1e3
+    );
+    printf("art pack         %6u seek(s)  %10llu bytes  %8.3f ms/pass\n",
+        pack_reads / iterations, (unsigned long long) (pack_bytes / iterations), pack_time * 1e3
+    );
+
+    free(buffer);
+    free(pack_path);
+    free(catalog_path);
+    catalog_list_free(&list);
+
+    return EXIT_SUCCESS;
+}
+
+static void synthetic_image (art_image_t *image, uint32_t seed) {
+    image->width = 256;
+    image->height = 179;
+    image->pixels = xmalloc(image->width * image->height * sizeof(uint16_t));
+
+    // Smooth gradients with a band of noise, roughly what scanned box art compresses like
+    for (int y = 0; y < image->height; y++) {
+        for (int x = 0; x < image->width; x++) {
+            seed = (seed * 1103515245) + 12345;
+            int noise = ((y > 60) && (y < 120)) ? ((seed >> 16) & 0x7) : 0;
+            int r = ((x >> 3) + noise) & 0x1F;
+            int g = ((y / 6) + noise) & 0x1F;
+            int b = (((x + y) >> 4) + noise) & 0x1F;
+            image->pixels[(y * image->width) + x] = (r << 11) | (g << 6) | (b << 1) | 1;
+        }
+    }
+}
+
+int cmd_bench_art_codec (int argc, char **argv) {
+    static const char *names[] = { "rgba16", "rgba16-lz", "ci8", "ci8-lz" };
+
+    int iterations = (argc > 1) ? atoi(argv[1]) : 20;
+
+    art_image_t *images;
+    uint32_t image_count = 0;
+
+    if ((argc > 0) && (strcmp(argv[0], "-") != 0)) {
+        char *catalog_path = path_join(argv[0], "menu/catalog.bin");
+        catalog_list_t list;
+        if (catalog_read(catalog_path, &list)) {
+            die("couldn't read catalog %s", catalog_path);
+        }
+        images = xcalloc(MAX(list.count, 1), sizeof(art_image_t));
+        for (uint32_t i = 0; i < list.count; i++) {
+            char *path = sprite_path(argv[0], list.entries[i].id);
+            uint8_t *data;
+            size_t size;
+            if (!file_read_all(path, &data, &size)) {
+                if (!sprite_is_compressed(data, size) && !art_image_from_sprite(data, size, &images[image_count])) {
+                    image_count += 1;
+                }
+                free(data);
+            }
+            free(path);
+        }
+        catalog_list_free(&list);
+        free(catalog_path);
+    } else {
+        image_count = 16;
+        images = xcalloc(image_count, sizeof(art_image_t));
+        for (uint32_t i = 0; i < image_count; i++) {
+            synthetic_image(&images[i], i);
+        }
+    }
+
+    if (image_count == 0) {
+        die("no uncompressed RGBA16 sprites found");
+    }
+
+    printf("%u image(s), %d decode iteration(s)\n", image_count, iterations);
+    printf("%-10s %12s %12s %12s %10s %12s\n", "format", "stored/img", "sd sectors", "resident/img", "encode ms", "decode MB/s");
+
+    for (size_t e = 0; e < sizeof(names) / sizeof(names[0]); e++) {
+        art_encoding_t encoding;
+        art_encoding_parse(names[e], &encoding);
+
+        uint8_t **blobs = xcalloc(image_count, sizeof(uint8_t *));
+        uint64_t stored_bytes = 0;
+        uint64_t sectors = 0;
+        uint64_t resident_bytes = 0;
+
+        double start = time_now();
+        for (uint32_t i = 0; i < image_count; i++) {
+            size_t size = art_image_encode(&images[i], encoding, &blobs[i]);
+            stored_bytes += size;
+            sectors += ALIGN(size, ART_PACK_ALIGNMENT) / ART_PACK_ALIGNMENT;
+            resident_bytes += get_u32(blobs[i] + 8);
+        }
+        double encode_time = time_now() - start;
+
+        uint8_t *decoded = xmalloc(MiB(1));
+        uint64_t decoded_bytes = 0;
+
+        // Round trip every compressed image against its uncompressed encoding before timing
+        for (uint32_t i = 0; (encoding.compression == ART_PACK_COMPRESSION_LZ) && (i < image_count); i++) {
+            uint8_t *raw;
+            art_image_encode(&images[i], (art_encoding_t) { encoding.format, ART_PACK_COMPRESSION_NONE }, &raw);
+            uint32_t data_size = get_u32(blobs[i] + 8);
+            bool failed = (blobs[i][5] == ART_PACK_COMPRESSION_LZ)
+                ? lz_decompress(blobs[i] + sizeof(art_pack_image_t), get_u32(blobs[i] + 12), decoded, data_size)
+                : (memcpy(decoded, blobs[i] + sizeof(art_pack_image_t), data_size), false);
+            if (failed || (memcmp(decoded, raw + sizeof(art_pack_image_t), data_size) != 0)) {
+                die("%s: image %u doesn't round trip", names[e], i);
+            }
+            free(raw);
+        }
+
+        start = time_now();
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            for (uint32_t i = 0; i < image_count; i++) {
+                uint8_t *blob = blobs[i];
+                uint32_t data_size = get_u32(blob + 8);
+                uint32_t stored_size = get_u32(blob + 12);
+                if (blob[5] == ART_PACK_COMPRESSION_LZ) {
+                    if (lz_decompress(blob + sizeof(art_pack_image_t), stored_size, decoded, data_size)) {
+                        die("%s: image %u failed to decode", names[e], i);
+                    }
+                } else {
+                    memcpy(decoded, blob + sizeof(art_pack_image_t), data_size);
+                }
+                decoded_bytes += data_size;
+            }
+        }
+        double decode_time = time_now() - start;
+
+        printf("%-10s %12llu %12llu %12llu %10.2f %12.1f\n",
+            names[e],
+            (unsigned long long) (stored_bytes / image_count),
+            (unsigned long long) (sectors / image_count),
+            (unsigned long long) (resident_bytes / image_count),
+            (encode_time * 1e3) / image_count,
+            (decoded_bytes / (1024.0 * 1024.0)) / MAX(decode_time, 1e-9)
+        );
+
+        for (uint32_t i = 0; i < image_count; i++) {
+            free(blobs[i]);
+        }
+        free(blobs);
+        free(decoded);
+    }
+
+    for (uint32_t i = 0; i < image_count; i++) {
+        art_image_free(&images[i]);
+    }
+    free(images);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/utils/rom_order.h"
+
+#include "commands.h"
+#include "common.h"
+
+
+typedef void swap_kernel_t (void *data, size_t length);
+
+
+// NOTE: Byte at a time loops, as the importer converted ROMs before the shared kernels
+static void reference_swap_16 (void *data, size_t length) {
+    uint8_t *buffer = (uint8_t *) (data);
+
+    for (size_t i = 0; i < length; i += 2) {
+        uint8_t t = buffer[i];
+        buffer[i] = buffer[i + 1];
+        buffer[i + 1] = t;
+    }
+}
+
+static void reference_swap_32 (void *data, size_t length) {
+    uint8_t *buffer = (uint8_t *) (data);
+
+    for (size_t i = 0; i < length; i += 4) {
+        uint8_t t0 = buffer[i];
+        uint8_t t1 = buffer[i + 1];
+        buffer[i] = buffer[i + 3];
+        buffer[i + 1] = buffer[i + 2];
+        buffer[i + 2] = t1;
+        buffer[i + 3] = t0;
+    }
+}
+
+static double time_kernel (swap_kernel_t *kernel, uint8_t *buffer, size_t size, int iterations) {
+    double start = time_now();
+
+    for (int i = 0; i < iterations; i++) {
+        kernel(buffer, size);
+    }
+
+    return (time_now() - start) / iterations;
+}
+
+
+int cmd_bench_byteswap (int argc, char **argv) {
+    uint32_t size_mib = (argc > 0) ? strtoul(argv[0], NULL, 0) : 64;
+    int iterations = (argc > 1) ? atoi(argv[1]) : 4;
+
+    if ((size_mib == 0) || (iterations <= 0)) {
+        fprintf(stderr, "usage: n64menu-tool bench-byteswap [size-mib] [iterations]\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t size = MiB((size_t) (size_mib));
+    uint8_t *source = xmalloc(size);
+    uint8_t *expected = xmalloc(size);
+    uint8_t *buffer = xmalloc(size);
+    uint32_t state = 0x2545F491UL;
+
+    for (size_t i = 0; i < size; i++) {
+        state = (state * 1103515245UL) + 12345;
+        source[i] = (state >> 16);
+    }
+
+    struct {
+        const char *name;
+        swap_kernel_t *reference;
+        swap_kernel_t *kernel;
+    } orders[] = {
+        { "v64", reference_swap_16, rom_order_swap_16 },
+        { "n64", reference_swap_32, rom_order_swap_32 },
+    };
+
+    printf("%u MiB, %d iterations\n", size_mib, iterations);
+
+    for (int i = 0; i < (sizeof(orders) / sizeof(orders[0])); i++) {
+        memcpy(expected, source, size);
+        orders[i].reference(expected, size);
+        memcpy(buffer, source, size);
+        orders[i].kernel(buffer, size);
+        if (memcmp(buffer, expected, size) != 0) {
+            die("%s word kernel output doesn't match the byte loop", orders[i].name);
+        }
+
+        double reference_elapsed = time_kernel(orders[i].reference, buffer, size, iterations);
+        double kernel_elapsed = time_kernel(orders[i].kernel, buffer, size, iterations);
+
+        printf("%s: byte loop %8.1f MB/s, word kernel %8.1f MB/s, %.1fx\n", orders[i].name,
+            (size / reference_elapsed) / 1e6, (size / kernel_elapsed) / 1e6, reference_elapsed / kernel_elapsed
+        );
+    }
+
+    free(buffer);
+    free(expected);
+    free(source);
+
+    return EXIT_SUCCESS;
+}
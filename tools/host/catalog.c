@@ -0,0 +1,688 @@
+#define _DEFAULT_SOURCE
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "../../src/flashcart/flashcart.h"
+#include "../../src/utils/rom_order.h"
+
+#include "commands.h"
+#include "common.h"
+#include "catalog.h"
+#include "rompack.h"
+
+
+#define HEADER_SIZE     (32)
+#define RECORD_SIZE     (32)
+
+#define ROM_NAME_OFFSET (0x20)
+#define ROM_NAME_LENGTH (20)
+
+
+static const char *save_type_names[__FLASHCART_SAVE_TYPE_END] = {
+    [FLASHCART_SAVE_TYPE_NONE] = "none",
+    [FLASHCART_SAVE_TYPE_EEPROM_4K] = "eeprom4k",
+    [FLASHCART_SAVE_TYPE_EEPROM_16K] = "eeprom16k",
+    [FLASHCART_SAVE_TYPE_SRAM] = "sram",
+    [FLASHCART_SAVE_TYPE_SRAM_BANKED] = "srambanked",
+    [FLASHCART_SAVE_TYPE_SRAM_128K] = "sram128k",
+    [FLASHCART_SAVE_TYPE_FLASHRAM] = "flashram",
+    [FLASHCART_SAVE_TYPE_FLASHRAM_PKST2] = "flashram-pkst2",
+};
+
+static const char *order_names[CATALOG_ORDER_COUNT] = {
+    [CATALOG_ORDER_NAME] = "name",
+    [CATALOG_ORDER_RECENT] = "recent",
+    [CATALOG_ORDER_PLAYED] = "played",
+};
+
+// qsort has no context argument, the comparators read the list being ordered from here
+static catalog_list_t *sort_list;
+static uint32_t *sort_rank;
+
+
+void catalog_list_init (catalog_list_t *list) {
+    list->entries = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+void catalog_list_free (catalog_list_t *list) {
+    free(list->entries);
+    catalog_list_init(list);
+}
+
+catalog_entry_t *catalog_list_add (catalog_list_t *list, const char *id) {
+    if ((strlen(id) >= CATALOG_ID_LENGTH) || (list->count >= CATALOG_MAX_RECORDS)) {
+        return NULL;
+    }
+
+    if (list->count == list->capacity) {
+        list->capacity = MAX(list->capacity * 2, 64);
+        list->entries = realloc(list->entries, list->capacity * sizeof(catalog_entry_t));
+        if (list->entries == NULL) {
+            die("out of memory");
+        }
+    }
+
+    catalog_entry_t *entry = &list->entries[list->count++];
+    memset(entry, 0, sizeof(catalog_entry_t));
+    strcpy(entry->id, id);
+    catalog_entry_set_name(entry, id, strlen(id));
+    entry->save_type = CATALOG_SAVE_TYPE_UNKNOWN;
+
+    return entry;
+}
+
+void catalog_entry_set_name (catalog_entry_t *entry, const char *name, size_t length) {
+    length = MIN(length, CATALOG_NAME_LENGTH - 1);
+    memset(entry->name, 0, CATALOG_NAME_LENGTH);
+    memcpy(entry->name, name, length);
+}
+
+void catalog_layout (catalog_list_t *list) {
+    for (uint32_t i = 0; i < list->count; i++) {
+        list->entries[i].grid_row = (i / CATALOG_COLUMNS);
+        list->entries[i].grid_column = (i % CATALOG_COLUMNS);
+    }
+}
+
+static int compare_by_name (const void *a, const void *b) {
+    const catalog_entry_t *x = &sort_list->entries[*(const uint16_t *) (a)];
+    const catalog_entry_t *y = &sort_list->entries[*(const uint16_t *) (b)];
+
+    int letter = catalog_letter(x->name) - catalog_letter(y->name);
+    if (letter != 0) {
+        return letter;
+    }
+    int name = strcasecmp(x->name, y->name);
+    if (name != 0) {
+        return name;
+    }
+    return strcmp(x->id, y->id);
+}
+
+static int compare_by_recent (const void *a, const void *b) {
+    uint16_t i = *(const uint16_t *) (a);
+    uint16_t j = *(const uint16_t *) (b);
+    const catalog_entry_t *x = &sort_list->entries[i];
+    const catalog_entry_t *y = &sort_list->entries[j];
+
+    if ((x->recent == 0) != (y->recent == 0)) {
+        return (x->recent == 0) ? 1 : -1;
+    }
+    if (x->recent != y->recent) {
+        return (x->recent < y->recent) ? -1 : 1;
+    }
+    return (sort_rank[i] < sort_rank[j]) ? -1 : (sort_rank[i] > sort_rank[j]);
+}
+
+static int compare_by_plays (const void *a, const void *b) {
+    uint16_t i = *(const uint16_t *) (a);
+    uint16_t j = *(const uint16_t *) (b);
+    const catalog_entry_t *x = &sort_list->entries[i];
+    const catalog_entry_t *y = &sort_list->entries[j];
+
+    if (x->play_count != y->play_count) {
+        return (x->play_count > y->play_count) ? -1 : 1;
+    }
+    return (sort_rank[i] < sort_rank[j]) ? -1 : (sort_rank[i] > sort_rank[j]);
+}
+
+static void sort_order (catalog_list_t *list, uint16_t *order, int (*compare) (const void *, const void *), uint32_t *rank) {
+    for (uint32_t i = 0; i < list->count; i++) {
+        order[i] = i;
+    }
+
+    sort_list = list;
+    sort_rank = rank;
+    qsort(order, list->count, sizeof(uint16_t), compare);
+
+    for (uint32_t i = 0; i < list->count; i++) {
+        rank[order[i]] = i;
+    }
+}
+
+void catalog_orders (catalog_list_t *list, uint16_t *orders, uint16_t *letter_start) {
+    uint16_t *name = &orders[list->count * CATALOG_ORDER_NAME];
+    uint16_t *recent = &orders[list->count * CATALOG_ORDER_RECENT];
+    uint16_t *played = &orders[list->count * CATALOG_ORDER_PLAYED];
+    uint32_t *rank = xcalloc(MAX(list->count, 1), sizeof(uint32_t));
+
+    // Ties of each order are broken by the previous one, which is what the menu reproduces when it updates them in place:
+    // titles never played stay in name order and titles played equally often stay in most recently played order.
+    sort_order(list, name, compare_by_name, rank);
+    sort_order(list, recent, compare_by_recent, rank);
+    sort_order(list, played, compare_by_plays, rank);
+
+    uint32_t i = 0;
+    for (int letter = 0; letter <= CATALOG_LETTER_COUNT; letter++) {
+        while ((i < list->count) && (catalog_letter(list->entries[name[i]].name) < letter)) {
+            i++;
+        }
+        letter_start[letter] = (letter == CATALOG_LETTER_COUNT) ? list->count : i;
+    }
+
+    free(rank);
+}
+
+static int compare_entry_ids (const void *a, const void *b) {
+    return strcmp((*(catalog_entry_t * const *) (a))->id, (*(catalog_entry_t * const *) (b))->id);
+}
+
+void catalog_merge_plays (catalog_list_t *list, catalog_list_t *previous) {
+    catalog_entry_t **sorted = xcalloc(MAX(previous->count, 1), sizeof(catalog_entry_t *));
+
+    for (uint32_t i = 0; i < previous->count; i++) {
+        sorted[i] = &previous->entries[i];
+    }
+    qsort(sorted, previous->count, sizeof(catalog_entry_t *), compare_entry_ids);
+
+    for (uint32_t i = 0; i < list->count; i++) {
+        catalog_entry_t *entry = &list->entries[i];
+        catalog_entry_t *key = entry;
+        catalog_entry_t **match = bsearch(&key, sorted, previous->count, sizeof(catalog_entry_t *), compare_entry_ids);
+        if (match != NULL) {
+            entry->play_count = (*match)->play_count;
+            entry->recent = (*match)->recent;
+        }
+    }
+
+    free(sorted);
+}
+
+int catalog_order_from_name (const char *name) {
+    for (int i = 0; i < CATALOG_ORDER_COUNT; i++) {
+        if (strcmp(name, order_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void catalog_list_synthetic (catalog_list_t *list, uint32_t count) {
+    catalog_list_init(list);
+
+    for (uint32_t i = 0; i < count; i++) {
+        char id[CATALOG_ID_LENGTH];
+        snprintf(id, sizeof(id), "%05X", i & 0xFFFFF);
+        catalog_entry_t *entry = catalog_list_add(list, id);
+        entry->rom_size = MiB(8) + i;
+        entry->sprite_offset = i * 0x16600;
+        entry->sprite_size = 0x165E8;
+        entry->save_type = i % __FLASHCART_SAVE_TYPE_END;
+        char name[CATALOG_NAME_LENGTH];
+        int length = snprintf(name, sizeof(name), "%c Title %u", "0ABCDEFGHIJKLMNOPQRSTUVWXYZ"[(i * 7) % 27], i);
+        catalog_entry_set_name(entry, name, length);
+    }
+    catalog_layout(list);
+
+    // A tenth of the titles played, ranks must be dense to survive the round trip
+    for (uint32_t i = 0, rank = 0; i < count; i += 10) {
+        list->entries[i].play_count = 1 + (i % 13);
+        list->entries[i].recent = ++rank;
+    }
+}
+
+size_t catalog_serialize (catalog_list_t *list, uint8_t **data) {
+    size_t orders_offset = HEADER_SIZE + ((size_t) (list->count) * RECORD_SIZE);
+    size_t orders_size = (((size_t) (list->count) * CATALOG_ORDER_COUNT) + CATALOG_LETTER_COUNT + 1) * sizeof(uint16_t);
+    size_t names_offset = orders_offset + orders_size;
+    size_t names_size = 0;
+    for (uint32_t i = 0; i < list->count; i++) {
+        names_size += strlen(list->entries[i].name) + 1;
+    }
+    size_t size = ALIGN(names_offset + names_size, SECTOR_SIZE);
+    uint8_t *p = xcalloc(1, size);
+
+    put_u32(&p[0], CATALOG_MAGIC);
+    put_u16(&p[4], CATALOG_VERSION);
+    put_u16(&p[6], RECORD_SIZE);
+    put_u32(&p[8], list->count);
+    put_u32(&p[12], HEADER_SIZE);
+    put_u8(&p[16], CATALOG_COLUMNS);
+    put_u32(&p[20], (list->count + CATALOG_COLUMNS - 1) / CATALOG_COLUMNS);
+    put_u32(&p[24], orders_offset);
+    put_u32(&p[28], names_offset);
+
+    size_t name_offset = 0;
+
+    for (uint32_t i = 0; i < list->count; i++) {
+        catalog_entry_t *entry = &list->entries[i];
+        uint8_t *record = &p[HEADER_SIZE + (i * RECORD_SIZE)];
+        memcpy(&record[0], entry->id, CATALOG_ID_LENGTH);
+        put_u32(&record[8], entry->rom_size);
+        put_u32(&record[12], entry->sprite_offset);
+        put_u32(&record[16], entry->sprite_size);
+        put_u16(&record[20], entry->grid_row);
+        put_u8(&record[22], entry->grid_column);
+        put_u8(&record[23], entry->save_type);
+        put_u8(&record[24], entry->flags);
+        put_u16(&record[26], entry->play_count);
+        put_u32(&record[28], name_offset);
+
+        strcpy((char *) (&p[names_offset + name_offset]), entry->name);
+        name_offset += strlen(entry->name) + 1;
+    }
+
+    uint16_t *orders = xcalloc((list->count * CATALOG_ORDER_COUNT) + CATALOG_LETTER_COUNT + 1, sizeof(uint16_t));
+    catalog_orders(list, orders, &orders[list->count * CATALOG_ORDER_COUNT]);
+    for (size_t i = 0; i < (orders_size / sizeof(uint16_t)); i++) {
+        put_u16(&p[orders_offset + (i * sizeof(uint16_t))], orders[i]);
+    }
+    free(orders);
+
+    *data = p;
+
+    return size;
+}
+
+bool catalog_deserialize (const uint8_t *data, size_t size, catalog_list_t *list) {
+    catalog_list_init(list);
+
+    if (size < HEADER_SIZE) {
+        return true;
+    }
+    if ((get_u32(&data[0]) != CATALOG_MAGIC) || (get_u16(&data[4]) != CATALOG_VERSION)) {
+        return true;
+    }
+    if ((get_u16(&data[6]) != RECORD_SIZE) || (data[16] != CATALOG_COLUMNS)) {
+        return true;
+    }
+
+    uint32_t count = get_u32(&data[8]);
+    uint32_t offset = get_u32(&data[12]);
+    uint32_t orders_offset = get_u32(&data[24]);
+    uint32_t names_offset = get_u32(&data[28]);
+
+    // Same checks as the menu, see catalog_validate() in src/menu/catalog.c
+    if ((offset < HEADER_SIZE) || (offset > size) || (offset % sizeof(uint32_t)) || (count > ((size - offset) / RECORD_SIZE)) || (count > CATALOG_MAX_RECORDS)) {
+        return true;
+    }
+    if ((orders_offset > size) || ((((size_t) (count) * CATALOG_ORDER_COUNT) * sizeof(uint16_t)) > (size - orders_offset))) {
+        return true;
+    }
+    if (names_offset > size) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *record = &data[offset + (i * RECORD_SIZE)];
+        char id[CATALOG_ID_LENGTH + 1] = { 0 };
+        memcpy(id, record, CATALOG_ID_LENGTH);
+        catalog_entry_t *entry = catalog_list_add(list, id);
+        if (entry == NULL) {
+            catalog_list_free(list);
+            return true;
+        }
+        entry->rom_size = get_u32(&record[8]);
+        entry->sprite_offset = get_u32(&record[12]);
+        entry->sprite_size = get_u32(&record[16]);
+        entry->grid_row = get_u16(&record[20]);
+        entry->grid_column = record[22];
+        entry->save_type = record[23];
+        entry->flags = record[24];
+        entry->play_count = get_u16(&record[26]);
+
+        uint32_t name_offset = get_u32(&record[28]);
+        if (name_offset < (size - names_offset)) {
+            const char *name = (const char *) (&data[names_offset + name_offset]);
+            catalog_entry_set_name(entry, name, strnlen(name, size - names_offset - name_offset));
+        }
+    }
+
+    // Only the relative order of played titles is kept, ranks come out dense
+    uint32_t rank = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t index = get_u16(&data[orders_offset + ((count * CATALOG_ORDER_RECENT) + i) * sizeof(uint16_t)]);
+        if ((index < count) && (list->entries[index].play_count > 0) && (list->entries[index].recent == 0)) {
+            list->entries[index].recent = ++rank;
+        }
+    }
+
+    return false;
+}
+
+bool catalog_write (const char *path, catalog_list_t *list) {
+    uint8_t *data;
+    size_t size = catalog_serialize(list, &data);
+    bool error = file_write_all(path, data, size);
+    free(data);
+    return error;
+}
+
+bool catalog_read (const char *path, catalog_list_t *list) {
+    uint8_t *data;
+    size_t size;
+
+    if (file_read_all(path, &data, &size)) {
+        return true;
+    }
+
+    bool error = catalog_deserialize(data, size, list);
+
+    free(data);
+
+    return error;
+}
+
+int catalog_save_type_from_name (const char *name) {
+    for (int i = 0; i < __FLASHCART_SAVE_TYPE_END; i++) {
+        if (strcmp(name, save_type_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char *catalog_save_type_name (uint8_t save_type) {
+    if (save_type == CATALOG_SAVE_TYPE_UNKNOWN) {
+        return "sidecar";
+    }
+    if (save_type >= __FLASHCART_SAVE_TYPE_END) {
+        return "invalid";
+    }
+    return save_type_names[save_type];
+}
+
+static uint8_t read_save_sidecar (const char *path) {
+    char value[32] = { 0 };
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return FLASHCART_SAVE_TYPE_NONE;
+    }
+    if (fgets(value, sizeof(value), f) == NULL) {
+        value[0] = '\0';
+    }
+    fclose(f);
+    value[strcspn(value, "\r\n")] = '\0';
+
+    int save_type = catalog_save_type_from_name(value);
+
+    return (save_type < 0) ? FLASHCART_SAVE_TYPE_NONE : save_type;
+}
+
+static size_t trim_name (char *name, size_t length) {
+    while ((length > 0) && ((name[length - 1] == ' ') || (name[length - 1] == '\0') || (name[length - 1] == '\r') || (name[length - 1] == '\n'))) {
+        length--;
+    }
+    return length;
+}
+
+// Display name comes from the optional `<id>_e.name` file, then the internal name in the ROM header
+static void read_title_name (const char *name_path, const char *rom_path, catalog_entry_t *entry) {
+    char name[CATALOG_NAME_LENGTH] = { 0 };
+    size_t length = 0;
+
+    FILE *f = fopen(name_path, "r");
+    if (f != NULL) {
+        if (fgets(name, sizeof(name), f) != NULL) {
+            length = trim_name(name, strcspn(name, "\r\n"));
+        }
+        fclose(f);
+    }
+
+    uint8_t header[ROM_NAME_OFFSET + ROM_NAME_LENGTH] __attribute__((aligned(4)));
+    uint32_t rom_size;
+    bool header_read = false;
+
+    if ((length == 0) && rom_pack_is_path(rom_path)) {
+        header_read = !rom_pack_file_head(rom_path, &rom_size, header, sizeof(header));
+    } else if ((length == 0) && ((f = fopen(rom_path, "rb")) != NULL)) {
+        header_read = (fread(header, sizeof(header), 1, f) == 1);
+        rom_order_convert(header, sizeof(header), rom_order_from_extension(rom_path));
+        fclose(f);
+    }
+
+    if (header_read) {
+        memcpy(name, header + ROM_NAME_OFFSET, ROM_NAME_LENGTH);
+        for (int i = 0; i < ROM_NAME_LENGTH; i++) {
+            if ((name[i] != '\0') && ((name[i] < ' ') || (name[i] > '~'))) {
+                name[i] = ' ';
+            }
+        }
+        length = trim_name(name, strnlen(name, ROM_NAME_LENGTH));
+    }
+
+    if (length > 0) {
+        catalog_entry_set_name(entry, name, length);
+    }
+}
+
+char *catalog_rom_path (const char *root, const char *id) {
+    static const char *extensions[] = { "z64", ROM_PACK_EXTENSION + 1, "v64", "n64" };
+    uint64_t size;
+
+    // NOTE: The menu picks the first of these that exists, the path of a missing ROM names the native order
+    for (int i = 0; i < (sizeof(extensions) / sizeof(extensions[0])); i++) {
+        char *path = path_printf("%s/menu/title/%s/%s_e.%s", root, id, id, extensions[i]);
+        if (!file_size(path, &size)) {
+            return path;
+        }
+        free(path);
+    }
+
+    return path_printf("%s/menu/title/%s/%s_e.z64", root, id, id);
+}
+
+static bool add_library_title (const char *root, const char *id, catalog_list_t *list) {
+    catalog_entry_t *entry = catalog_list_add(list, id);
+    if (entry == NULL) {
+        if (list->count >= CATALOG_MAX_RECORDS) {
+            fprintf(stderr, "error: catalog is limited to %d titles, skipping %s\n", CATALOG_MAX_RECORDS, id);
+        } else {
+            fprintf(stderr, "error: title ID is too long: %s\n", id);
+        }
+        return true;
+    }
+
+    char *rom_path = catalog_rom_path(root, id);
+    char *save_path = path_printf("%s/menu/title/%s/%s_e.save", root, id, id);
+    char *name_path = path_printf("%s/menu/title/%s/%s_e.name", root, id, id);
+
+    uint64_t rom_size;
+    bool error = file_size(rom_path, &rom_size);
+    uint8_t header[4];
+    uint32_t packed_size;
+    if (!error && rom_pack_is_path(rom_path)) {
+        error = rom_pack_file_head(rom_path, &packed_size, header, sizeof(header));
+        rom_size = packed_size;
+    }
+    if (error) {
+        fprintf(stderr, "error: missing ROM: %s\n", rom_path);
+    } else if (rom_size > MiB(78)) {
+        fprintf(stderr, "error: ROM exceeds the 78 MiB limit: %s\n", rom_path);
+        error = true;
+    }
+
+    entry->rom_size = (uint32_t) (rom_size);
+    entry->save_type = read_save_sidecar(save_path);
+    read_title_name(name_path, rom_path, entry);
+
+    free(name_path);
+    free(save_path);
+    free(rom_path);
+
+    return error;
+}
+
+static int compare_names (const void *a, const void *b) {
+    return strcmp(*(char * const *) (a), *(char * const *) (b));
+}
+
+bool catalog_scan_library (const char *root, catalog_list_t *list) {
+    char *csv_path = path_join(root, "menu/title.csv");
+    uint8_t *csv;
+    size_t csv_size;
+    bool error = false;
+
+    catalog_list_init(list);
+
+    if (!file_read_all(csv_path, &csv, &csv_size)) {
+        char id[64];
+        size_t length = 0;
+        for (size_t i = 0; i <= csv_size; i++) {
+            char c = (i < csv_size) ? csv[i] : '\0';
+            if ((c == ',') || (c == ' ') || (c == '\r') || (c == '\n') || (c == '\0')) {
+                if (length > 0) {
+                    id[length] = '\0';
+                    error |= add_library_title(root, id, list);
+                }
+                length = 0;
+            } else if (length < (sizeof(id) - 1)) {
+                id[length++] = c;
+            }
+        }
+        free(csv);
+    } else {
+        char *title_root = path_join(root, "menu/title");
+        DIR *dir = opendir(title_root);
+        if (dir == NULL) {
+            fprintf(stderr, "error: neither menu/title.csv nor menu/title exists under %s\n", root);
+            free(title_root);
+            free(csv_path);
+            return true;
+        }
+
+        char **names = NULL;
+        size_t count = 0;
+        struct dirent *dirent;
+        while ((dirent = readdir(dir)) != NULL) {
+            if ((dirent->d_name[0] == '.') || (dirent->d_type != DT_DIR)) {
+                continue;
+            }
+            names = realloc(names, (count + 1) * sizeof(char *));
+            names[count++] = strdup(dirent->d_name);
+        }
+        closedir(dir);
+
+        qsort(names, count, sizeof(char *), compare_names);
+
+        for (size_t i = 0; i < count; i++) {
+            error |= add_library_title(root, names[i], list);
+            free(names[i]);
+        }
+        free(names);
+        free(title_root);
+    }
+
+    free(csv_path);
+
+    catalog_layout(list);
+
+    return error;
+}
+
+
+int cmd_catalog (int argc, char **argv) {
+    if (argc != 1) {
+        fprintf(stderr, "usage: n64menu-tool catalog <sd-root>\n");
+        return EXIT_FAILURE;
+    }
+
+    catalog_list_t list;
+    catalog_list_t previous;
+
+    if (catalog_scan_library(argv[0], &list)) {
+        catalog_list_free(&list);
+        return EXIT_FAILURE;
+    }
+
+    // Play counts and the recently played order survive a rebuild
+    char *path = path_join(argv[0], "menu/catalog.bin");
+    if (!catalog_read(path, &previous)) {
+        catalog_merge_plays(&list, &previous);
+        catalog_list_free(&previous);
+    }
+
+    if (catalog_write(path, &list)) {
+        die("couldn't write %s", path);
+    }
+
+    printf("Wrote %u title(s) to %s\n", list.count, path);
+
+    free(path);
+    catalog_list_free(&list);
+
+    return EXIT_SUCCESS;
+}
+
+int cmd_catalog_dump (int argc, char **argv) {
+    int order = -1;
+
+    if ((argc == 2) && ((order = catalog_order_from_name(argv[1])) < 0)) {
+        argc = 0;
+    }
+    if ((argc != 1) && (argc != 2)) {
+        fprintf(stderr, "usage: n64menu-tool catalog-dump <catalog.bin> [name|recent|played]\n");
+        return EXIT_FAILURE;
+    }
+
+    catalog_list_t list;
+
+    if (catalog_read(argv[0], &list)) {
+        die("couldn't read catalog %s", argv[0]);
+    }
+
+    uint16_t *orders = xcalloc((list.count * CATALOG_ORDER_COUNT) + CATALOG_LETTER_COUNT + 1, sizeof(uint16_t));
+    catalog_orders(&list, orders, &orders[list.count * CATALOG_ORDER_COUNT]);
+
+    printf("%-8s %10s %-14s %6s %3s %10s %8s %5s  %s\n", "id", "rom size", "save", "row", "col", "sprite", "size", "plays", "name");
+    for (uint32_t i = 0; i < list.count; i++) {
+        catalog_entry_t *entry = &list.entries[(order < 0) ? i : orders[(list.count * order) + i]];
+        printf("%-8s %10u %-14s %6u %3u %10u %8u %5u  %s\n",
+            entry->id, entry->rom_size, catalog_save_type_name(entry->save_type),
+            entry->grid_row, entry->grid_column, entry->sprite_offset, entry->sprite_size,
+            entry->play_count, entry->name
+        );
+    }
+
+    free(orders);
+    catalog_list_free(&list);
+
+    return EXIT_SUCCESS;
+}
+
+int cmd_bench_catalog (int argc, char **argv) {
+    uint32_t count = MIN((argc > 0) ? strtoul(argv[0], NULL, 0) : 10000, CATALOG_MAX_RECORDS);
+    int iterations = (argc > 1) ? atoi(argv[1]) : 100;
+
+    catalog_list_t list;
+    catalog_list_synthetic(&list, count);
+
+    uint16_t *orders = xcalloc((count * CATALOG_ORDER_COUNT) + CATALOG_LETTER_COUNT + 1, sizeof(uint16_t));
+    double start = time_now();
+    for (int i = 0; i < iterations; i++) {
+        catalog_orders(&list, orders, &orders[count * CATALOG_ORDER_COUNT]);
+    }
+    double order_elapsed = (time_now() - start) / iterations;
+    free(orders);
+
+    uint8_t *data;
+    size_t size = catalog_serialize(&list, &data);
+
+    start = time_now();
+    for (int i = 0; i < iterations; i++) {
+        catalog_list_t parsed;
+        if (catalog_deserialize(data, size, &parsed)) {
+            die("catalog failed to parse");
+        }
+        catalog_list_free(&parsed);
+    }
+    double elapsed = (time_now() - start) / iterations;
+
+    printf("records:      %u\n", count);
+    printf("file size:    %zu bytes (%zu sectors)\n", size, size / SECTOR_SIZE);
+    printf("parse time:   %.3f ms\n", elapsed * 1e3);
+    printf("per record:   %.1f ns\n", (elapsed * 1e9) / MAX(count, 1));
+    printf("order build:  %.3f ms (host only, the menu never sorts)\n", order_elapsed * 1e3);
+
+    free(data);
+    catalog_list_free(&list);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#ifndef HOST_CATALOG_H__
+#define HOST_CATALOG_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../src/menu/catalog.h"
+
+
+/**
+ * @brief Host side representation of a catalog record.
+ *
+ * `recent` is the 1-based rank of the title in the recently played order, 0 for titles never played.
+ */
+typedef struct {
+    char id[CATALOG_ID_LENGTH];
+    char name[CATALOG_NAME_LENGTH];
+    uint32_t rom_size;
+    uint32_t sprite_offset;
+    uint32_t sprite_size;
+    uint16_t grid_row;
+    uint8_t grid_column;
+    uint8_t save_type;
+    uint8_t flags;
+    uint16_t play_count;
+    uint32_t recent;
+} catalog_entry_t;
+
+typedef struct {
+    catalog_entry_t *entries;
+    uint32_t count;
+    uint32_t capacity;
+} catalog_list_t;
+
+
+void catalog_list_init (catalog_list_t *list);
+void catalog_list_free (catalog_list_t *list);
+catalog_entry_t *catalog_list_add (catalog_list_t *list, const char *id);
+void catalog_entry_set_name (catalog_entry_t *entry, const char *name, size_t length);
+void catalog_layout (catalog_list_t *list);
+void catalog_orders (catalog_list_t *list, uint16_t *orders, uint16_t *letter_start);
+void catalog_merge_plays (catalog_list_t *list, catalog_list_t *previous);
+int catalog_order_from_name (const char *name);
+void catalog_list_synthetic (catalog_list_t *list, uint32_t count);
+
+size_t catalog_serialize (catalog_list_t *list, uint8_t **data);
+bool catalog_deserialize (const uint8_t *data, size_t size, catalog_list_t *list);
+bool catalog_write (const char *path, catalog_list_t *list);
+bool catalog_read (const char *path, catalog_list_t *list);
+
+int catalog_save_type_from_name (const char *name);
+const char *catalog_save_type_name (uint8_t save_type);
+char *catalog_rom_path (const char *root, const char *id);
+bool catalog_scan_library (const char *root, catalog_list_t *list);
+
+
+#endif
@@ -0,0 +1,224 @@
+#define _DEFAULT_SOURCE
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/menu/resident_rom.h"
+#include "../../src/menu/rom_pack.h"
+#include "../../src/utils/rom_order.h"
+
+#include "catalog.h"
+#include "chunks.h"
+#include "commands.h"
+#include "common.h"
+
+
+void chunk_builder_init (chunk_builder_t *builder, uint8_t shift) {
+    memset(builder, 0, sizeof(chunk_builder_t));
+    builder->chunks.shift = shift;
+    builder->hash = ROM_CHUNKS_HASH_INIT;
+}
+
+void chunk_builder_update (chunk_builder_t *builder, const uint8_t *data, size_t length) {
+    uint64_t chunk_size = (1ULL << builder->chunks.shift);
+
+    while (length > 0) {
+        uint64_t offset = (builder->size % chunk_size);
+        size_t piece = MIN(length, chunk_size - offset);
+
+        // Anything past the cartridge SDRAM is only counted, such ROMs get no list
+        if (builder->size < ROM_CHUNKS_MAX_ROM_SIZE) {
+            builder->hash = rom_chunks_hash(builder->hash, data, piece);
+            if ((offset + piece) == chunk_size) {
+                builder->chunks.hashes[builder->chunks.count++] = builder->hash;
+                builder->hash = ROM_CHUNKS_HASH_INIT;
+            }
+        }
+
+        builder->size += piece;
+        data += piece;
+        length -= piece;
+    }
+}
+
+bool chunk_builder_finish (chunk_builder_t *builder) {
+    if ((builder->size == 0) || (builder->size > ROM_CHUNKS_MAX_ROM_SIZE)) {
+        return true;
+    }
+
+    if ((builder->size % (1ULL << builder->chunks.shift)) != 0) {
+        builder->chunks.hashes[builder->chunks.count++] = builder->hash;
+    }
+    builder->chunks.rom_size = builder->size;
+
+    return false;
+}
+
+bool chunk_file_write (const char *path, const rom_chunks_t *chunks) {
+    size_t size = ROM_CHUNKS_HEADER_SIZE + (chunks->count * sizeof(uint64_t));
+    uint8_t *data = xcalloc(1, size);
+
+    put_u32(data, ROM_CHUNKS_MAGIC);
+    put_u8(data + 4, ROM_CHUNKS_VERSION);
+    put_u8(data + 5, chunks->shift);
+    put_u32(data + 8, chunks->rom_size);
+    put_u32(data + 12, chunks->count);
+    for (uint32_t i = 0; i < chunks->count; i++) {
+        put_u64(data + ROM_CHUNKS_HEADER_SIZE + (i * sizeof(uint64_t)), chunks->hashes[i]);
+    }
+
+    bool error = file_write_all(path, data, size);
+
+    free(data);
+
+    return error;
+}
+
+bool chunk_file_read (const char *path, rom_chunks_t *chunks) {
+    uint8_t *data;
+    size_t size;
+
+    if (file_read_all(path, &data, &size)) {
+        return true;
+    }
+
+    bool error = rom_chunks_parse(data, size, chunks);
+
+    free(data);
+
+    return error;
+}
+
+bool chunk_file_build (const char *rom_path, const char *path) {
+    FILE *f = fopen(rom_path, "rb");
+    if (f == NULL) {
+        return true;
+    }
+
+    chunk_builder_t *builder = xmalloc(sizeof(chunk_builder_t));
+    uint8_t *buffer = xmalloc(MiB(1));
+    size_t count;
+
+    rom_order_t order = rom_order_from_extension(rom_path);
+
+    // NOTE: Hashes always cover the ROM in native order, as the menu compares them against cartridge memory
+    chunk_builder_init(builder, ROM_CHUNKS_DEFAULT_SHIFT);
+    while ((count = fread(buffer, 1, MiB(1), f)) > 0) {
+        rom_order_convert(buffer, count, order);
+        chunk_builder_update(builder, buffer, count);
+    }
+
+    bool error = ferror(f) || chunk_builder_finish(builder) || chunk_file_write(path, &builder->chunks);
+
+    fclose(f);
+    free(buffer);
+    free(builder);
+
+    return error;
+}
+
+
+static char *title_file (const char *root, const char *id, const char *extension) {
+    return path_printf("%s/menu/title/%s/%s_e.%s", root, id, id, extension);
+}
+
+static bool hash_title (const char *root, const char *id) {
+    char *rom_path = catalog_rom_path(root, id);
+    char *path = title_file(root, id, "chk");
+    bool error = false;
+    uint64_t size;
+
+    if (file_size(rom_path, &size)) {
+        fprintf(stderr, "error: couldn't open %s\n", rom_path);
+        error = true;
+    } else if (rom_pack_is_path(rom_path)) {
+        printf("%s: compressed container, always loaded in full, skipped\n", id);
+    } else if (size > ROM_CHUNKS_MAX_ROM_SIZE) {
+        printf("%s: larger than the cartridge SDRAM, skipped\n", id);
+    } else if (chunk_file_build(rom_path, path)) {
+        fprintf(stderr, "error: couldn't write %s\n", path);
+        error = true;
+    } else {
+        printf("%s: %llu bytes\n", id, (unsigned long long) (size));
+    }
+
+    free(path);
+    free(rom_path);
+
+    return error;
+}
+
+int cmd_chunk_hashes (int argc, char **argv) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: n64menu-tool chunk-hashes <sd-root> [id...]\n");
+        return EXIT_FAILURE;
+    }
+
+    bool error = false;
+
+    for (int i = 1; i < argc; i++) {
+        error |= hash_title(argv[0], argv[i]);
+    }
+
+    if (argc == 1) {
+        char *title_root = path_join(argv[0], "menu/title");
+        DIR *dir = opendir(title_root);
+        if (dir == NULL) {
+            die("couldn't open %s", title_root);
+        }
+        struct dirent *dirent;
+        while ((dirent = readdir(dir)) != NULL) {
+            if ((dirent->d_name[0] == '.') || (dirent->d_type != DT_DIR)) {
+                continue;
+            }
+            error |= hash_title(argv[0], dirent->d_name);
+        }
+        closedir(dir);
+        free(title_root);
+    }
+
+    return error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int cmd_chunk_diff (int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: n64menu-tool chunk-diff <sd-root> <resident-id> <target-id>\n");
+        return EXIT_FAILURE;
+    }
+
+    rom_chunks_t *resident = xmalloc(sizeof(rom_chunks_t));
+    rom_chunks_t *target = xmalloc(sizeof(rom_chunks_t));
+    uint8_t changed[ROM_CHUNKS_MAX_COUNT / 8];
+
+    for (int i = 0; i < 2; i++) {
+        char *path = title_file(argv[0], argv[1 + i], "chk");
+        if (chunk_file_read(path, (i == 0) ? resident : target)) {
+            die("couldn't read %s, run the chunk-hashes command first", path);
+        }
+        free(path);
+    }
+
+    uint32_t chunk_size = (1 << target->shift);
+    uint32_t count = rom_chunks_diff(resident, target, RESIDENT_ROM_HEAD_SIZE, changed);
+    uint64_t bytes = 0;
+
+    for (uint32_t i = 0; i < target->count; i++) {
+        if (changed[i / 8] & (1 << (i % 8))) {
+            bytes += MIN(target->rom_size - ((uint64_t) (i) * chunk_size), chunk_size);
+        }
+    }
+
+    uint32_t head_chunks = MIN((RESIDENT_ROM_HEAD_SIZE + chunk_size - 1) / chunk_size, target->count);
+
+    printf("%u of %u chunks of %u KiB changed (%u in the reloaded head)\n", count, target->count, chunk_size / 1024, head_chunks);
+    printf("%llu of %u bytes loaded, %.1f%% of a full load\n",
+        (unsigned long long) (bytes), target->rom_size, (100.0 * bytes) / target->rom_size
+    );
+
+    free(resident);
+    free(target);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,32 @@
+#ifndef HOST_CHUNKS_H__
+#define HOST_CHUNKS_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../src/menu/rom_chunks.h"
+
+
+/**
+ * @brief Chunk hash list built while a ROM streams through in z64 byte order.
+ *
+ * Data may arrive in pieces of any word multiple, hashes are split on chunk boundaries.
+ */
+typedef struct {
+    rom_chunks_t chunks;
+    uint64_t size;
+    uint64_t hash;
+} chunk_builder_t;
+
+
+void chunk_builder_init (chunk_builder_t *builder, uint8_t shift);
+void chunk_builder_update (chunk_builder_t *builder, const uint8_t *data, size_t length);
+bool chunk_builder_finish (chunk_builder_t *builder);
+bool chunk_file_write (const char *path, const rom_chunks_t *chunks);
+bool chunk_file_read (const char *path, rom_chunks_t *chunks);
+bool chunk_file_build (const char *rom_path, const char *path);
+
+
+#endif
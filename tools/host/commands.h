@@ -0,0 +1,25 @@
+#ifndef HOST_COMMANDS_H__
+#define HOST_COMMANDS_H__
+
+
+int cmd_catalog (int argc, char **argv);
+int cmd_catalog_dump (int argc, char **argv);
+int cmd_bench_catalog (int argc, char **argv);
+int cmd_bench_layout (int argc, char **argv);
+int cmd_pack_art (int argc, char **argv);
+int cmd_bench_art (int argc, char **argv);
+int cmd_bench_art_codec (int argc, char **argv);
+int cmd_import (int argc, char **argv);
+int cmd_bench_rom_load (int argc, char **argv);
+int cmd_mock_sc64_load (int argc, char **argv);
+int cmd_mock_rom_pack_load (int argc, char **argv);
+int cmd_bench_fat_walk (int argc, char **argv);
+int cmd_mock_fs (int argc, char **argv);
+int cmd_chunk_hashes (int argc, char **argv);
+int cmd_chunk_diff (int argc, char **argv);
+int cmd_bench_byteswap (int argc, char **argv);
+int cmd_rom_pack (int argc, char **argv);
+int cmd_bench_rom_pack (int argc, char **argv);
+
+
+#endif
@@ -0,0 +1,144 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "common.h"
+
+
+void die (const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "error: ");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    exit(EXIT_FAILURE);
+}
+
+void *xmalloc (size_t size) {
+    void *p = malloc(size ? size : 1);
+    if (p == NULL) {
+        die("out of memory");
+    }
+    return p;
+}
+
+void *xcalloc (size_t count, size_t size) {
+    void *p = calloc(count ? count : 1, size ? size : 1);
+    if (p == NULL) {
+        die("out of memory");
+    }
+    return p;
+}
+
+char *path_join (const char *a, const char *b) {
+    return path_printf("%s/%s", a, b);
+}
+
+char *path_printf (const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+
+    char *path = xmalloc(length + 1);
+
+    va_start(args, fmt);
+    vsnprintf(path, length + 1, fmt, args);
+    va_end(args);
+
+    return path;
+}
+
+bool file_read_all (const char *path, uint8_t **data, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return true;
+    }
+
+    if (fseek(f, 0, SEEK_END) != 0) {
+        fclose(f);
+        return true;
+    }
+    long length = ftell(f);
+    if ((length < 0) || (fseek(f, 0, SEEK_SET) != 0)) {
+        fclose(f);
+        return true;
+    }
+
+    *data = xmalloc(length);
+    *size = (size_t) (length);
+
+    if (fread(*data, 1, *size, f) != *size) {
+        free(*data);
+        fclose(f);
+        return true;
+    }
+
+    fclose(f);
+
+    return false;
+}
+
+bool file_write_all (const char *path, const void *data, size_t size) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return true;
+    }
+
+    bool error = (fwrite(data, 1, size, f) != size);
+
+    if (fclose(f) != 0) {
+        error = true;
+    }
+
+    return error;
+}
+
+bool file_size (const char *path, uint64_t *size) {
+    struct stat st;
+
+    if ((stat(path, &st) != 0) || !S_ISREG(st.st_mode)) {
+        return true;
+    }
+
+    *size = (uint64_t) (st.st_size);
+
+    return false;
+}
+
+bool make_directories (const char *path) {
+    char *directory = strdup(path);
+    bool error = false;
+
+    for (char *separator = directory + 1; ; separator++) {
+        char c = *separator;
+        if ((c == '/') || (c == '\0')) {
+            *separator = '\0';
+            if ((mkdir(directory, 0777) != 0) && (errno != EEXIST)) {
+                error = true;
+                break;
+            }
+            *separator = c;
+        }
+        if (c == '\0') {
+            break;
+        }
+    }
+
+    free(directory);
+
+    return error;
+}
+
+double time_now (void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
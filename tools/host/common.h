@@ -0,0 +1,66 @@
+#ifndef HOST_COMMON_H__
+#define HOST_COMMON_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define ALIGN(x, a)     (((x) + ((a) - 1)) & ~((a) - 1))
+#define MIN(a, b)       ((a) < (b) ? (a) : (b))
+#define MAX(a, b)       ((a) > (b) ? (a) : (b))
+
+#define KiB(x)          ((x) * 1024)
+#define MiB(x)          ((x) * 1024 * 1024)
+
+#define SECTOR_SIZE     (512)
+
+
+static inline void put_u8 (uint8_t *p, uint8_t v) {
+    p[0] = v;
+}
+
+static inline void put_u16 (uint8_t *p, uint16_t v) {
+    p[0] = (v >> 8);
+    p[1] = v;
+}
+
+static inline void put_u32 (uint8_t *p, uint32_t v) {
+    p[0] = (v >> 24);
+    p[1] = (v >> 16);
+    p[2] = (v >> 8);
+    p[3] = v;
+}
+
+static inline void put_u64 (uint8_t *p, uint64_t v) {
+    put_u32(p, v >> 32);
+    put_u32(p + 4, v);
+}
+
+static inline uint16_t get_u16 (const uint8_t *p) {
+    return (p[0] << 8) | p[1];
+}
+
+static inline uint32_t get_u32 (const uint8_t *p) {
+    return ((uint32_t) (p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static inline uint64_t get_u64 (const uint8_t *p) {
+    return ((uint64_t) (get_u32(p)) << 32) | get_u32(p + 4);
+}
+
+
+void die (const char *fmt, ...) __attribute__((noreturn, format(printf, 1, 2)));
+void *xmalloc (size_t size);
+void *xcalloc (size_t count, size_t size);
+char *path_join (const char *a, const char *b);
+char *path_printf (const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+bool file_read_all (const char *path, uint8_t **data, size_t *size);
+bool file_write_all (const char *path, const void *data, size_t size);
+bool file_size (const char *path, uint64_t *size);
+bool make_directories (const char *path);
+double time_now (void);
+
+
+#endif
@@ -0,0 +1,870 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mock/fatfs/diskio.h"
+#include "mock/fatfs/ff.h"
+
+#include "common.h"
+#include "fatfsmock.h"
+
+
+#define MAX_ENTRIES         (64)
+#define MAX_PATH_LENGTH     (256)
+
+#define NO_WINDOW           ((LBA_t) (0xFFFFFFFF))
+
+#define FA_MODIFIED         (0x40)
+
+#define CART_ADDRESS        (0x10000000UL)
+#define CART_END            (0x20000000UL)
+
+
+typedef struct {
+    bool used;
+    bool directory;
+    char path[MAX_PATH_LENGTH];
+    DWORD sclust;
+    FSIZE_t size;
+    BYTE stat;
+    uint32_t timestamp;
+} entry_t;
+
+static struct {
+    fat_image_t *image;
+    FATFS fs;
+    uint8_t *allocated;
+    entry_t entries[MAX_ENTRIES];
+    uint32_t clock;
+    fatfs_mock_cart_write_t *cart_write;
+    fatfs_mock_device_hook_t *device_hook;
+    uint32_t violations;
+} mock;
+
+
+static void violation (const char *fmt, ...) {
+    va_list args;
+
+    fprintf(stderr, "fatfs violation: ");
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+
+    mock.violations += 1;
+}
+
+static bool device_read (void *buffer, uint32_t sector, uint32_t count) {
+    if (mock.device_hook) {
+        mock.device_hook();
+    }
+    return fat_device_read(mock.image, buffer, sector, count);
+}
+
+static bool device_write (const void *buffer, uint32_t sector, uint32_t count) {
+    if (mock.device_hook) {
+        mock.device_hook();
+    }
+    return fat_device_write(mock.image, buffer, sector, count);
+}
+
+static bool is_cart_address (const void *buffer) {
+    uintptr_t address = (uintptr_t) (buffer);
+    return (mock.cart_write != NULL) && (address >= CART_ADDRESS) && (address < CART_END);
+}
+
+static uint32_t cluster_bytes (void) {
+    return mock.fs.csize * SECTOR_SIZE;
+}
+
+static LBA_t cluster_sector (DWORD cluster) {
+    return mock.fs.database + ((LBA_t) (mock.fs.csize) * (cluster - 2));
+}
+
+static bool valid_cluster (DWORD cluster) {
+    return (cluster >= 2) && (cluster < mock.fs.n_fatent);
+}
+
+
+// NOTE: The FAT sector held in the window is written back only when the window moves, FatFs also
+//       writes it on sync. Walks that read the card directly must take a dirty window into account.
+static bool move_window (LBA_t sector) {
+    if (sector == mock.fs.winsect) {
+        return false;
+    }
+    if (mock.fs.wflag) {
+        if (device_write( mock.fs.win, mock.fs.winsect, 1)) {
+            return true;
+        }
+        mock.fs.wflag = 0;
+    }
+    if (device_read( mock.fs.win, sector, 1)) {
+        mock.fs.winsect = NO_WINDOW;
+        return true;
+    }
+    mock.fs.winsect = sector;
+    return false;
+}
+
+static uint8_t *window_byte (uint32_t offset) {
+    if (move_window(mock.fs.fatbase + (offset / SECTOR_SIZE))) {
+        return NULL;
+    }
+    return mock.fs.win + (offset % SECTOR_SIZE);
+}
+
+static bool get_fat (DWORD cluster, DWORD *value) {
+    uint8_t *p;
+
+    switch (mock.fs.fs_type) {
+        case FS_FAT12: {
+            uint32_t offset = cluster + (cluster / 2);
+            uint32_t word;
+            if ((p = window_byte(offset)) == NULL) {
+                return true;
+            }
+            word = p[0];
+            if ((p = window_byte(offset + 1)) == NULL) {
+                return true;
+            }
+            word |= (p[0] << 8);
+            *value = (cluster & 1) ? (word >> 4) : (word & 0xFFF);
+            return false;
+        }
+        case FS_FAT16:
+            if ((p = window_byte(cluster * 2)) == NULL) {
+                return true;
+            }
+            *value = p[0] | (p[1] << 8);
+            return false;
+        default:
+            if ((p = window_byte(cluster * 4)) == NULL) {
+                return true;
+            }
+            *value = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) (p[3]) << 24);
+            if (mock.fs.fs_type == FS_FAT32) {
+                *value &= 0x0FFFFFFF;
+            }
+            return false;
+    }
+}
+
+static bool put_fat (DWORD cluster, DWORD value) {
+    uint8_t *p;
+
+    switch (mock.fs.fs_type) {
+        case FS_FAT12: {
+            uint32_t offset = cluster + (cluster / 2);
+            if ((p = window_byte(offset)) == NULL) {
+                return true;
+            }
+            *p = (cluster & 1) ? ((*p & 0x0F) | (value << 4)) : value;
+            mock.fs.wflag = 1;
+            if ((p = window_byte(offset + 1)) == NULL) {
+                return true;
+            }
+            *p = (cluster & 1) ? (value >> 4) : ((*p & 0xF0) | ((value >> 8) & 0x0F));
+            mock.fs.wflag = 1;
+            return false;
+        }
+        case FS_FAT16:
+            if ((p = window_byte(cluster * 2)) == NULL) {
+                return true;
+            }
+            p[0] = value;
+            p[1] = (value >> 8);
+            break;
+        default:
+            if ((p = window_byte(cluster * 4)) == NULL) {
+                return true;
+            }
+            if (mock.fs.fs_type == FS_FAT32) {
+                value = (value & 0x0FFFFFFF) | ((uint32_t) (p[3] & 0xF0) << 24);
+            }
+            p[0] = value;
+            p[1] = (value >> 8);
+            p[2] = (value >> 16);
+            p[3] = (value >> 24);
+            break;
+    }
+
+    mock.fs.wflag = 1;
+
+    return false;
+}
+
+
+static entry_t *find_entry (const TCHAR *path) {
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        if (mock.entries[i].used && (strcmp(mock.entries[i].path, path) == 0)) {
+            return &mock.entries[i];
+        }
+    }
+    return NULL;
+}
+
+static entry_t *add_entry (const TCHAR *path, bool directory) {
+    if (strlen(path) >= MAX_PATH_LENGTH) {
+        return NULL;
+    }
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        entry_t *entry = &mock.entries[i];
+        if (!entry->used) {
+            memset(entry, 0, sizeof(entry_t));
+            entry->used = true;
+            entry->directory = directory;
+            strcpy(entry->path, path);
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static bool is_root (const TCHAR *path) {
+    return (path[0] == '\0') || (strcmp(path, "/") == 0);
+}
+
+static void sync_entry (FIL *fp) {
+    entry_t *entry = &mock.entries[fp->entry];
+    entry->sclust = fp->obj.sclust;
+    entry->size = fp->obj.objsize;
+    entry->stat = fp->obj.stat;
+}
+
+
+static DWORD find_free (DWORD start) {
+    if (!valid_cluster(start)) {
+        start = 2;
+    }
+    for (DWORD i = 0; i < (mock.fs.n_fatent - 2); i++) {
+        DWORD cluster = 2 + (((start - 2) + i) % (mock.fs.n_fatent - 2));
+        if (!mock.allocated[cluster]) {
+            return cluster;
+        }
+    }
+    return 0;
+}
+
+static uint32_t file_clusters (FIL *fp) {
+    return (fp->obj.sclust == 0) ? 0 : ((fp->obj.objsize + cluster_bytes() - 1) / cluster_bytes());
+}
+
+// Same as FatFs, a lookup resumes from the cluster of the current position when it lies ahead
+static bool locate (FIL *fp, uint32_t index, DWORD *cluster) {
+    DWORD current = fp->obj.sclust;
+    uint32_t current_index = 0;
+
+    if ((fp->obj.stat & 3) == 2) {
+        *cluster = fp->obj.sclust + index;
+        return false;
+    }
+
+    if ((fp->fptr > 0) && valid_cluster(fp->clust) && (((fp->fptr - 1) / cluster_bytes()) <= index)) {
+        current = fp->clust;
+        current_index = (fp->fptr - 1) / cluster_bytes();
+    }
+
+    while (current_index < index) {
+        if (!valid_cluster(current) || get_fat(current, &current)) {
+            return true;
+        }
+        current_index += 1;
+    }
+
+    if (!valid_cluster(current)) {
+        return true;
+    }
+
+    *cluster = current;
+
+    return false;
+}
+
+// NOTE: exFAT files start out contiguous without a FAT chain, the chain is written out the first time
+//       the file can't grow into the cluster right after its end.
+static bool extend_chain (FIL *fp, uint32_t count) {
+    DWORD last = 0;
+    DWORD cluster;
+
+    if (count > 0) {
+        if (locate(fp, count - 1, &last)) {
+            return true;
+        }
+        cluster = (valid_cluster(last + 1) && !mock.allocated[last + 1]) ? (last + 1) : find_free(mock.fs.last_clst + 1);
+    } else {
+        cluster = find_free(mock.fs.last_clst + 1);
+    }
+
+    if (cluster == 0) {
+        return true;
+    }
+
+    mock.allocated[cluster] = 1;
+    mock.fs.last_clst = cluster;
+
+    if (count == 0) {
+        fp->obj.sclust = cluster;
+        if (mock.fs.fs_type == FS_EXFAT) {
+            fp->obj.stat = 2;
+            return false;
+        }
+        return put_fat(cluster, fat_end_of_chain(mock.image));
+    }
+
+    if ((fp->obj.stat & 3) == 2) {
+        if (cluster == (last + 1)) {
+            return false;
+        }
+        for (DWORD i = fp->obj.sclust; i < last; i++) {
+            if (put_fat(i, i + 1)) {
+                return true;
+            }
+        }
+        fp->obj.stat = 0;
+    }
+
+    return put_fat(last, cluster) || put_fat(cluster, fat_end_of_chain(mock.image));
+}
+
+// Grows the file to hold the given size, stops short when the volume is full
+static FSIZE_t grow (FIL *fp, FSIZE_t size) {
+    uint32_t needed = (size + cluster_bytes() - 1) / cluster_bytes();
+    uint32_t count = file_clusters(fp);
+
+    while ((count < needed) && !extend_chain(fp, count)) {
+        count += 1;
+    }
+
+    return MIN(size, (FSIZE_t) (count) * cluster_bytes());
+}
+
+static void free_chain (DWORD cluster, FSIZE_t size, BYTE stat) {
+    uint32_t count = (size + cluster_bytes() - 1) / cluster_bytes();
+
+    for (uint32_t i = 0; (i < count) && valid_cluster(cluster); i++) {
+        DWORD next = cluster + 1;
+        if ((stat & 3) != 2) {
+            if (get_fat(cluster, &next) || put_fat(cluster, 0)) {
+                break;
+            }
+        }
+        mock.allocated[cluster] = 0;
+        cluster = next;
+    }
+}
+
+
+void fatfs_mock_mount (fat_image_t *image) {
+    static const BYTE types[] = {
+        [FAT_TYPE_FAT12] = FS_FAT12,
+        [FAT_TYPE_FAT16] = FS_FAT16,
+        [FAT_TYPE_FAT32] = FS_FAT32,
+        [FAT_TYPE_EXFAT] = FS_EXFAT,
+    };
+
+    memset(&mock, 0, sizeof(mock));
+
+    mock.image = image;
+    mock.fs.fs_type = types[image->type];
+    mock.fs.csize = image->cluster_sectors;
+    mock.fs.n_fatent = image->cluster_count + 2;
+    mock.fs.fsize = image->fat_sectors;
+    mock.fs.fatbase = image->fat_sector;
+    mock.fs.database = image->data_sector;
+    mock.fs.winsect = NO_WINDOW;
+
+    mock.allocated = xcalloc(mock.fs.n_fatent, 1);
+    for (DWORD cluster = 2; cluster < mock.fs.n_fatent; cluster++) {
+        mock.allocated[cluster] = (fat_get_entry(image, cluster) != 0);
+    }
+
+    entry_t *entry = add_entry(FATFS_MOCK_FILE_PATH, false);
+    entry->sclust = image->file_cluster;
+    entry->size = image->file_size;
+    entry->timestamp = ++mock.clock;
+}
+
+void fatfs_mock_unmount (void) {
+    fatfs_mock_sync();
+    free(mock.allocated);
+    memset(&mock, 0, sizeof(mock));
+}
+
+void fatfs_mock_sync (void) {
+    if (mock.fs.wflag && (mock.fs.winsect != NO_WINDOW)) {
+        device_write( mock.fs.win, mock.fs.winsect, 1);
+        mock.fs.wflag = 0;
+    }
+}
+
+void fatfs_mock_invalidate (void) {
+    fatfs_mock_sync();
+    mock.fs.winsect = NO_WINDOW;
+}
+
+void fatfs_mock_set_cart (fatfs_mock_cart_write_t *write) {
+    mock.cart_write = write;
+}
+
+bool fatfs_mock_window_dirty (void) {
+    return mock.fs.wflag && (mock.fs.winsect != NO_WINDOW);
+}
+
+void fatfs_mock_set_device_hook (fatfs_mock_device_hook_t *hook) {
+    mock.device_hook = hook;
+}
+
+uint32_t fatfs_mock_violations (void) {
+    return mock.violations;
+}
+
+// Reference walk straight from the image with the window laid over it, nothing is counted
+bool fatfs_mock_file_runs (const char *path, fat_run_t *runs, uint32_t max_runs, uint32_t *run_count) {
+    entry_t *entry = find_entry(path);
+    fat_image_t *image = mock.image;
+    uint8_t saved[SECTOR_SIZE];
+    bool window = (mock.fs.winsect != NO_WINDOW);
+    bool error = false;
+
+    *run_count = 0;
+
+    if ((entry == NULL) || entry->directory) {
+        return true;
+    }
+
+    if (window) {
+        memcpy(saved, image->data + (mock.fs.winsect * SECTOR_SIZE), SECTOR_SIZE);
+        memcpy(image->data + (mock.fs.winsect * SECTOR_SIZE), mock.fs.win, SECTOR_SIZE);
+    }
+
+    uint32_t sector_count = ALIGN(entry->size, SECTOR_SIZE) / SECTOR_SIZE;
+    DWORD cluster = entry->sclust;
+
+    for (uint32_t file_sector = 0; file_sector < sector_count; file_sector += mock.fs.csize) {
+        if (file_sector > 0) {
+            cluster = ((entry->stat & 3) == 2) ? (cluster + 1) : fat_get_entry(image, cluster);
+        }
+        if (!valid_cluster(cluster)) {
+            error = true;
+            break;
+        }
+        uint32_t sector = cluster_sector(cluster);
+        uint32_t count = MIN(mock.fs.csize, sector_count - file_sector);
+        if ((*run_count > 0) && ((runs[*run_count - 1].sector + runs[*run_count - 1].count) == sector)) {
+            runs[*run_count - 1].count += count;
+            continue;
+        }
+        if (*run_count == max_runs) {
+            error = true;
+            break;
+        }
+        runs[*run_count].sector = sector;
+        runs[*run_count].count = count;
+        *run_count += 1;
+    }
+
+    if (window) {
+        memcpy(image->data + (mock.fs.winsect * SECTOR_SIZE), saved, SECTOR_SIZE);
+    }
+
+    return error;
+}
+
+bool fatfs_mock_read_file (const char *path, void *buffer, size_t size) {
+    entry_t *entry = find_entry(path);
+    uint32_t max_runs = (size / SECTOR_SIZE) + 1;
+    fat_run_t *runs = xmalloc(max_runs * sizeof(fat_run_t));
+    uint32_t run_count;
+    size_t offset = 0;
+
+    if ((entry == NULL) || (entry->size != size) || fatfs_mock_file_runs(path, runs, max_runs, &run_count)) {
+        free(runs);
+        return true;
+    }
+
+    for (uint32_t i = 0; i < run_count; i++) {
+        size_t length = MIN((size_t) (runs[i].count) * SECTOR_SIZE, size - offset);
+        memcpy((uint8_t *) (buffer) + offset, mock.image->data + ((size_t) (runs[i].sector) * SECTOR_SIZE), length);
+        offset += length;
+    }
+
+    free(runs);
+
+    return false;
+}
+
+
+DRESULT disk_read (BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
+    LBA_t fat_end = mock.fs.fatbase + mock.fs.fsize;
+
+    if (pdrv != mock.fs.pdrv) {
+        return RES_PARERR;
+    }
+    if ((sector < fat_end) && ((sector + count) > fat_end)) {
+        violation("read of %u sectors at %u runs past the end of the FAT at %u", count, sector, fat_end);
+    }
+    return device_read( buff, sector, count) ? RES_ERROR : RES_OK;
+}
+
+DRESULT disk_write (BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
+    if (pdrv != mock.fs.pdrv) {
+        return RES_PARERR;
+    }
+    return device_write( buff, sector, count) ? RES_ERROR : RES_OK;
+}
+
+
+FRESULT f_open (FIL *fp, const TCHAR *path, BYTE mode) {
+    entry_t *entry = find_entry(path);
+
+    memset(fp, 0, sizeof(FIL));
+
+    if (entry != NULL) {
+        if (entry->directory) {
+            return FR_NO_FILE;
+        }
+        if (mode & FA_CREATE_NEW) {
+            return FR_EXIST;
+        }
+    } else {
+        if (!(mode & (FA_CREATE_NEW | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS))) {
+            return FR_NO_FILE;
+        }
+        if ((entry = add_entry(path, false)) == NULL) {
+            return FR_DENIED;
+        }
+        mode |= FA_MODIFIED;
+    }
+
+    fp->obj.fs = &mock.fs;
+    fp->obj.sclust = entry->sclust;
+    fp->obj.objsize = entry->size;
+    fp->obj.stat = entry->stat;
+    fp->flag = mode & (FA_READ | FA_WRITE | FA_MODIFIED);
+    fp->entry = entry - mock.entries;
+
+    if ((mode & FA_CREATE_ALWAYS) && (fp->obj.objsize > 0)) {
+        free_chain(fp->obj.sclust, fp->obj.objsize, fp->obj.stat);
+        fp->obj.sclust = 0;
+        fp->obj.objsize = 0;
+        fp->obj.stat = 0;
+        fp->flag |= FA_MODIFIED;
+        sync_entry(fp);
+    }
+
+    fp->clust = fp->obj.sclust;
+
+    if ((mode & FA_OPEN_APPEND) == FA_OPEN_APPEND) {
+        return f_lseek(fp, fp->obj.objsize);
+    }
+
+    return FR_OK;
+}
+
+FRESULT f_close (FIL *fp) {
+    if (fp->obj.fs != &mock.fs) {
+        return FR_INVALID_OBJECT;
+    }
+
+    if (fp->flag & FA_MODIFIED) {
+        sync_entry(fp);
+        mock.entries[fp->entry].timestamp = ++mock.clock;
+    }
+
+    fp->obj.fs = NULL;
+
+    return FR_OK;
+}
+
+FRESULT f_read (FIL *fp, void *buff, UINT btr, UINT *br) {
+    uint8_t *buffer = buff;
+    uint8_t sector_buffer[SECTOR_SIZE];
+
+    *br = 0;
+
+    if ((fp->obj.fs != &mock.fs) || !(fp->flag & FA_READ)) {
+        return FR_DENIED;
+    }
+
+    btr = MIN(btr, fp->obj.objsize - fp->fptr);
+
+    while (btr > 0) {
+        DWORD cluster;
+        if (locate(fp, fp->fptr / cluster_bytes(), &cluster)) {
+            return FR_INT_ERR;
+        }
+        fp->clust = cluster;
+
+        uint32_t cluster_sector_index = (fp->fptr % cluster_bytes()) / SECTOR_SIZE;
+        LBA_t sector = cluster_sector(cluster) + cluster_sector_index;
+        uint32_t offset = fp->fptr % SECTOR_SIZE;
+        uint32_t length;
+
+        if ((offset == 0) && (btr >= SECTOR_SIZE)) {
+            uint32_t count = MIN(btr / SECTOR_SIZE, mock.fs.csize - cluster_sector_index);
+            length = count * SECTOR_SIZE;
+            if (is_cart_address(buffer)) {
+                // NOTE: The SD driver DMAs whole sectors into cart space, modelled by a device read handed to the cart
+                uint8_t *data = xmalloc(length);
+                if (device_read( data, sector, count)) {
+                    free(data);
+                    return FR_DISK_ERR;
+                }
+                mock.cart_write((uint32_t) ((uintptr_t) (buffer)), data, length);
+                free(data);
+            } else if (device_read( buffer, sector, count)) {
+                return FR_DISK_ERR;
+            }
+        } else {
+            length = MIN(SECTOR_SIZE - offset, btr);
+            if (device_read( sector_buffer, sector, 1)) {
+                return FR_DISK_ERR;
+            }
+            if (is_cart_address(buffer)) {
+                violation("%u bytes of sector %u copied by the CPU into cart space at 0x%08X", length, sector, (uint32_t) ((uintptr_t) (buffer)));
+                mock.cart_write((uint32_t) ((uintptr_t) (buffer)), sector_buffer + offset, length);
+            } else {
+                memcpy(buffer, sector_buffer + offset, length);
+            }
+        }
+
+        fp->fptr += length;
+        buffer += length;
+        btr -= length;
+        *br += length;
+    }
+
+    return FR_OK;
+}
+
+FRESULT f_write (FIL *fp, const void *buff, UINT btw, UINT *bw) {
+    const uint8_t *buffer = buff;
+    uint8_t sector_buffer[SECTOR_SIZE];
+
+    *bw = 0;
+
+    if ((fp->obj.fs != &mock.fs) || !(fp->flag & FA_WRITE)) {
+        return FR_DENIED;
+    }
+
+    if ((fp->fptr + btw) > fp->obj.objsize) {
+        FSIZE_t size = fp->obj.objsize;
+        FSIZE_t end = grow(fp, fp->fptr + btw);
+        fp->obj.objsize = MAX(size, end);
+        btw = (end > fp->fptr) ? (end - fp->fptr) : 0;
+        fp->flag |= FA_MODIFIED;
+        sync_entry(fp);
+    }
+
+    while (btw > 0) {
+        DWORD cluster;
+        if (locate(fp, fp->fptr / cluster_bytes(), &cluster)) {
+            return FR_INT_ERR;
+        }
+        fp->clust = cluster;
+
+        uint32_t cluster_sector_index = (fp->fptr % cluster_bytes()) / SECTOR_SIZE;
+        LBA_t sector = cluster_sector(cluster) + cluster_sector_index;
+        uint32_t offset = fp->fptr % SECTOR_SIZE;
+        uint32_t length;
+
+        if ((offset == 0) && (btw >= SECTOR_SIZE)) {
+            uint32_t count = MIN(btw / SECTOR_SIZE, mock.fs.csize - cluster_sector_index);
+            length = count * SECTOR_SIZE;
+            if (device_write( buffer, sector, count)) {
+                return FR_DISK_ERR;
+            }
+        } else {
+            length = MIN(SECTOR_SIZE - offset, btw);
+            if (device_read( sector_buffer, sector, 1)) {
+                return FR_DISK_ERR;
+            }
+            memcpy(sector_buffer + offset, buffer, length);
+            if (device_write( sector_buffer, sector, 1)) {
+                return FR_DISK_ERR;
+            }
+        }
+
+        fp->fptr += length;
+        buffer += length;
+        btw -= length;
+        *bw += length;
+    }
+
+    fp->flag |= FA_MODIFIED;
+
+    return FR_OK;
+}
+
+// NOTE: As in FatFs a full volume isn't an error, the position just stops at the end of what could be allocated
+FRESULT f_lseek (FIL *fp, FSIZE_t ofs) {
+    if (fp->obj.fs != &mock.fs) {
+        return FR_INVALID_OBJECT;
+    }
+
+    if (ofs > fp->obj.objsize) {
+        if (fp->flag & FA_WRITE) {
+            FSIZE_t size = fp->obj.objsize;
+            ofs = grow(fp, ofs);
+            fp->obj.objsize = MAX(size, ofs);
+            fp->flag |= FA_MODIFIED;
+            sync_entry(fp);
+        } else {
+            ofs = fp->obj.objsize;
+        }
+    }
+
+    if (ofs > 0) {
+        DWORD cluster;
+        if (locate(fp, (ofs - 1) / cluster_bytes(), &cluster)) {
+            return FR_INT_ERR;
+        }
+        fp->clust = cluster;
+    } else {
+        fp->clust = fp->obj.sclust;
+    }
+
+    fp->fptr = ofs;
+
+    return FR_OK;
+}
+
+// NOTE: Only allocation in one contiguous run (opt 1) is modelled, the file pointer stays put as in FatFs
+FRESULT f_expand (FIL *fp, FSIZE_t fsz, BYTE opt) {
+    if (fp->obj.fs != &mock.fs) {
+        return FR_INVALID_OBJECT;
+    }
+    if ((fsz == 0) || (fp->obj.objsize != 0) || !(fp->flag & FA_WRITE) || (opt != 1)) {
+        return FR_DENIED;
+    }
+
+    uint32_t needed = (fsz + cluster_bytes() - 1) / cluster_bytes();
+    DWORD start = valid_cluster(mock.fs.last_clst) ? mock.fs.last_clst : 2;
+    DWORD first = 0;
+    uint32_t length = 0;
+
+    for (DWORD i = 0; i < (mock.fs.n_fatent - 2); i++) {
+        DWORD cluster = 2 + (((start - 2) + i) % (mock.fs.n_fatent - 2));
+        if ((cluster == 2) && (length > 0)) {
+            length = 0;
+        }
+        if (mock.allocated[cluster]) {
+            length = 0;
+            continue;
+        }
+        if (length == 0) {
+            first = cluster;
+        }
+        if (++length == needed) {
+            break;
+        }
+    }
+
+    if (length < needed) {
+        return FR_DENIED;
+    }
+
+    for (uint32_t i = 0; i < needed; i++) {
+        mock.allocated[first + i] = 1;
+        if (mock.fs.fs_type != FS_EXFAT) {
+            if (put_fat(first + i, (i == (needed - 1)) ? fat_end_of_chain(mock.image) : (first + i + 1))) {
+                return FR_DISK_ERR;
+            }
+        }
+    }
+
+    mock.fs.last_clst = first + needed - 1;
+
+    fp->obj.sclust = first;
+    fp->obj.objsize = fsz;
+    fp->obj.stat = (mock.fs.fs_type == FS_EXFAT) ? 2 : 0;
+    fp->clust = first;
+    fp->flag |= FA_MODIFIED;
+    sync_entry(fp);
+
+    return FR_OK;
+}
+
+FRESULT f_stat (const TCHAR *path, FILINFO *fno) {
+    entry_t *entry;
+
+    if (is_root(path)) {
+        return FR_INVALID_NAME;
+    }
+    if ((entry = find_entry(path)) == NULL) {
+        return FR_NO_FILE;
+    }
+
+    fno->fsize = entry->directory ? 0 : entry->size;
+    fno->fdate = (entry->timestamp >> 16);
+    fno->ftime = entry->timestamp;
+    fno->fattrib = entry->directory ? AM_DIR : AM_ARC;
+
+    return FR_OK;
+}
+
+FRESULT f_unlink (const TCHAR *path) {
+    entry_t *entry = find_entry(path);
+
+    if (entry == NULL) {
+        return FR_NO_FILE;
+    }
+
+    if (entry->directory) {
+        size_t length = strlen(path);
+        for (int i = 0; i < MAX_ENTRIES; i++) {
+            if (mock.entries[i].used && (strncmp(mock.entries[i].path, path, length) == 0) && (mock.entries[i].path[length] == '/')) {
+                return FR_DENIED;
+            }
+        }
+    } else if (entry->sclust != 0) {
+        free_chain(entry->sclust, entry->size, entry->stat);
+    }
+
+    entry->used = false;
+
+    return FR_OK;
+}
+
+FRESULT f_rename (const TCHAR *path_old, const TCHAR *path_new) {
+    entry_t *entry = find_entry(path_old);
+
+    if (entry == NULL) {
+        return FR_NO_FILE;
+    }
+    if (find_entry(path_new) != NULL) {
+        return FR_EXIST;
+    }
+    if (strlen(path_new) >= MAX_PATH_LENGTH) {
+        return FR_INVALID_NAME;
+    }
+
+    strcpy(entry->path, path_new);
+
+    return FR_OK;
+}
+
+FRESULT f_utime (const TCHAR *path, const FILINFO *fno) {
+    entry_t *entry = find_entry(path);
+
+    if (entry == NULL) {
+        return FR_NO_FILE;
+    }
+
+    entry->timestamp = (((uint32_t) (fno->fdate)) << 16) | fno->ftime;
+
+    return FR_OK;
+}
+
+// NOTE: Directories are names only, they take no clusters from the volume
+FRESULT f_mkdir (const TCHAR *path) {
+    if (find_entry(path) != NULL) {
+        return FR_EXIST;
+    }
+    if (add_entry(path, true) == NULL) {
+        return FR_DENIED;
+    }
+
+    return FR_OK;
+}
@@ -0,0 +1,39 @@
+#ifndef HOST_FATFSMOCK_H__
+#define HOST_FATFSMOCK_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fatimage.h"
+
+
+#define FATFS_MOCK_FILE_PATH    "/file.bin"
+
+/**
+ * @brief Receives whole sectors FatFs reads straight into cart space.
+ *
+ * The menu points f_read at the PI mapped ROM area to let the SD driver DMA sectors there,
+ * any part of a read that FatFs would memcpy instead is reported as a violation.
+ */
+typedef void fatfs_mock_cart_write_t (uint32_t address, const void *data, size_t length);
+
+
+/** @brief Called before every SD command, the SD card shares the PI bus with cart writes. */
+typedef void fatfs_mock_device_hook_t (void);
+
+
+void fatfs_mock_mount (fat_image_t *image);
+void fatfs_mock_unmount (void);
+void fatfs_mock_sync (void);
+void fatfs_mock_invalidate (void);
+void fatfs_mock_set_cart (fatfs_mock_cart_write_t *write);
+void fatfs_mock_set_device_hook (fatfs_mock_device_hook_t *hook);
+bool fatfs_mock_window_dirty (void);
+uint32_t fatfs_mock_violations (void);
+bool fatfs_mock_file_runs (const char *path, fat_run_t *runs, uint32_t max_runs, uint32_t *run_count);
+bool fatfs_mock_read_file (const char *path, void *buffer, size_t size);
+
+
+#endif
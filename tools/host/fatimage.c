@@ -0,0 +1,302 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "fatimage.h"
+
+
+#define RESERVED_SECTORS    (32)
+#define ROOT_CLUSTER        (2)
+#define MAX_GAP_CLUSTERS    (8)
+
+
+static uint32_t next_random (uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void put_le32 (uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = (v >> 8);
+    p[2] = (v >> 16);
+    p[3] = (v >> 24);
+}
+
+static uint32_t get_le32 (const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) (p[3]) << 24);
+}
+
+static uint32_t fat_entry_limit (fat_type_t type) {
+    switch (type) {
+        case FAT_TYPE_FAT12: return 0xFF5;
+        case FAT_TYPE_FAT16: return 0xFFF5;
+        default: return 0x0FFFFFF5;
+    }
+}
+
+static uint32_t fat_size_bytes (fat_type_t type, uint32_t entries) {
+    switch (type) {
+        case FAT_TYPE_FAT12: return (entries * 3 + 1) / 2;
+        case FAT_TYPE_FAT16: return entries * 2;
+        default: return entries * 4;
+    }
+}
+
+
+void fat_image_create (fat_image_t *image, uint32_t cluster_kib, uint32_t file_size, uint32_t fragments, uint32_t seed) {
+    fat_image_config_t config = {
+        .type = FAT_TYPE_FAT32,
+        .cluster_kib = cluster_kib,
+        .file_size = file_size,
+        .fragments = fragments,
+        .seed = seed,
+    };
+
+    fat_image_create_volume(image, &config);
+}
+
+void fat_image_create_volume (fat_image_t *image, fat_image_config_t *config) {
+    memset(image, 0, sizeof(fat_image_t));
+
+    uint32_t cluster_size = KiB(config->cluster_kib);
+    uint32_t file_clusters = MAX((config->file_size + cluster_size - 1) / cluster_size, 1);
+    uint32_t state = (config->seed != 0) ? config->seed : 1;
+    uint32_t fragments = MIN(MAX(config->fragments, 1), file_clusters);
+
+    uint32_t *order = xmalloc(fragments * sizeof(uint32_t));
+    uint32_t *gaps = xmalloc(fragments * sizeof(uint32_t));
+    uint32_t *starts = xmalloc(fragments * sizeof(uint32_t));
+    uint32_t gap_clusters = 0;
+
+    // NOTE: Fragments are laid out in shuffled order with clusters of other files between them,
+    //       so the chain jumps both forward and backward like on a well used card.
+    for (uint32_t i = 0; i < fragments; i++) {
+        order[i] = i;
+        gaps[i] = (fragments > 1) ? (1 + (next_random(&state) % MAX_GAP_CLUSTERS)) : 0;
+        gap_clusters += gaps[i];
+    }
+    for (uint32_t i = fragments - 1; i > 0; i--) {
+        uint32_t j = next_random(&state) % (i + 1);
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    image->type = config->type;
+    image->cluster_sectors = cluster_size / SECTOR_SIZE;
+    image->cluster_count = 1 + gap_clusters + file_clusters + config->free_clusters;
+    if ((image->cluster_count + ROOT_CLUSTER) > fat_entry_limit(image->type)) {
+        die("%u clusters don't fit the FAT type", image->cluster_count);
+    }
+    image->fat_sector = RESERVED_SECTORS;
+    image->fat_sectors = ALIGN(fat_size_bytes(image->type, image->cluster_count + ROOT_CLUSTER), SECTOR_SIZE) / SECTOR_SIZE;
+    image->data_sector = image->fat_sector + image->fat_sectors;
+    image->sector_count = image->data_sector + (image->cluster_count * image->cluster_sectors);
+    image->data = xcalloc(image->sector_count, SECTOR_SIZE);
+
+    fat_set_entry(image, 0, fat_end_of_chain(image) & ~7);
+    fat_set_entry(image, 1, fat_end_of_chain(image));
+    fat_set_entry(image, ROOT_CLUSTER, fat_end_of_chain(image));
+
+    uint32_t cluster = ROOT_CLUSTER + 1;
+    for (uint32_t i = 0; i < fragments; i++) {
+        uint32_t fragment = order[i];
+        for (uint32_t gap = 0; gap < gaps[i]; gap++) {
+            fat_set_entry(image, cluster++, config->free_gaps ? 0 : fat_end_of_chain(image));
+        }
+        starts[fragment] = cluster;
+        cluster += (file_clusters / fragments) + ((fragment < (file_clusters % fragments)) ? 1 : 0);
+    }
+
+    image->file_size = config->file_size;
+    image->file_data = xmalloc(file_clusters * cluster_size);
+    for (uint32_t i = 0; i < (file_clusters * cluster_size) / sizeof(uint32_t); i++) {
+        ((uint32_t *) (image->file_data))[i] = next_random(&state);
+    }
+
+    uint32_t file_cluster = 0;
+    uint32_t previous = 0;
+    for (uint32_t fragment = 0; fragment < fragments; fragment++) {
+        uint32_t length = (file_clusters / fragments) + ((fragment < (file_clusters % fragments)) ? 1 : 0);
+        for (uint32_t i = 0; i < length; i++) {
+            uint32_t current = starts[fragment] + i;
+            if (previous == 0) {
+                image->file_cluster = current;
+            } else {
+                fat_set_entry(image, previous, current);
+            }
+            memcpy(image->data + (fat_cluster_sector(image, current) * SECTOR_SIZE), image->file_data + (file_cluster * cluster_size), cluster_size);
+            previous = current;
+            file_cluster += 1;
+        }
+    }
+    fat_set_entry(image, previous, fat_end_of_chain(image));
+
+    free(order);
+    free(gaps);
+    free(starts);
+}
+
+void fat_image_free (fat_image_t *image) {
+    free(image->data);
+    free(image->file_data);
+    memset(image, 0, sizeof(fat_image_t));
+}
+
+void fat_image_reset_stats (fat_image_t *image) {
+    image->commands = 0;
+    image->sectors_read = 0;
+    image->write_commands = 0;
+    image->sectors_written = 0;
+}
+
+bool fat_device_read (fat_image_t *image, void *buffer, uint32_t sector, uint32_t count) {
+    if ((sector >= image->sector_count) || (count > (image->sector_count - sector))) {
+        return true;
+    }
+
+    memcpy(buffer, image->data + ((size_t) (sector) * SECTOR_SIZE), (size_t) (count) * SECTOR_SIZE);
+
+    image->commands += 1;
+    image->sectors_read += count;
+
+    return false;
+}
+
+bool fat_device_write (fat_image_t *image, const void *buffer, uint32_t sector, uint32_t count) {
+    if ((sector >= image->sector_count) || (count > (image->sector_count - sector))) {
+        return true;
+    }
+
+    memcpy(image->data + ((size_t) (sector) * SECTOR_SIZE), buffer, (size_t) (count) * SECTOR_SIZE);
+
+    image->write_commands += 1;
+    image->sectors_written += count;
+
+    return false;
+}
+
+// FAT12 entries are packed in three bytes per pair and may straddle sectors, the FAT is one flat buffer here
+uint32_t fat_get_entry (fat_image_t *image, uint32_t cluster) {
+    uint8_t *fat = image->data + (image->fat_sector * SECTOR_SIZE);
+
+    switch (image->type) {
+        case FAT_TYPE_FAT12: {
+            uint8_t *p = fat + cluster + (cluster / 2);
+            uint32_t value = p[0] | (p[1] << 8);
+            return (cluster & 1) ? (value >> 4) : (value & 0xFFF);
+        }
+        case FAT_TYPE_FAT16:
+            return fat[cluster * 2] | (fat[(cluster * 2) + 1] << 8);
+        case FAT_TYPE_FAT32:
+            return get_le32(fat + (cluster * 4)) & 0x0FFFFFFF;
+        default:
+            return get_le32(fat + (cluster * 4));
+    }
+}
+
+void fat_set_entry (fat_image_t *image, uint32_t cluster, uint32_t value) {
+    uint8_t *fat = image->data + (image->fat_sector * SECTOR_SIZE);
+
+    switch (image->type) {
+        case FAT_TYPE_FAT12: {
+            uint8_t *p = fat + cluster + (cluster / 2);
+            if (cluster & 1) {
+                p[0] = (p[0] & 0x0F) | (value << 4);
+                p[1] = (value >> 4);
+            } else {
+                p[0] = value;
+                p[1] = (p[1] & 0xF0) | ((value >> 8) & 0x0F);
+            }
+            break;
+        }
+        case FAT_TYPE_FAT16:
+            fat[cluster * 2] = value;
+            fat[(cluster * 2) + 1] = (value >> 8);
+            break;
+        case FAT_TYPE_FAT32:
+            put_le32(fat + (cluster * 4), (get_le32(fat + (cluster * 4)) & 0xF0000000) | (value & 0x0FFFFFFF));
+            break;
+        default:
+            put_le32(fat + (cluster * 4), value);
+            break;
+    }
+}
+
+uint32_t fat_end_of_chain (fat_image_t *image) {
+    switch (image->type) {
+        case FAT_TYPE_FAT12: return 0xFFF;
+        case FAT_TYPE_FAT16: return 0xFFFF;
+        case FAT_TYPE_FAT32: return FAT_END_OF_CHAIN;
+        default: return 0xFFFFFFFF;
+    }
+}
+
+
+void fat_window_init (fat_window_t *window, fat_image_t *image) {
+    fat_window_init_span(window, image, 1);
+}
+
+void fat_window_init_span (fat_window_t *window, fat_image_t *image, uint32_t span) {
+    window->image = image;
+    window->sector = 0;
+    window->count = 0;
+    window->span = MIN(MAX(span, 1), FAT_WINDOW_MAX_SECTORS);
+    window->reads = 0;
+}
+
+uint32_t fat_window_next (fat_window_t *window, uint32_t cluster) {
+    uint32_t sector = window->image->fat_sector + ((cluster * sizeof(uint32_t)) / SECTOR_SIZE);
+
+    if ((window->count == 0) || (sector < window->sector) || (sector >= (window->sector + window->count))) {
+        bool sequential = (window->count > 0) && (sector == (window->sector + window->count));
+        uint32_t count = sequential ? MIN(window->span, window->image->data_sector - sector) : 1;
+        if (fat_device_read(window->image, window->buffer, sector, count)) {
+            return FAT_END_OF_CHAIN;
+        }
+        window->sector = sector;
+        window->count = count;
+        window->reads += 1;
+    }
+
+    return get_le32(window->buffer + ((sector - window->sector) * SECTOR_SIZE) + ((cluster * sizeof(uint32_t)) % SECTOR_SIZE)) & 0x0FFFFFFF;
+}
+
+uint32_t fat_cluster_sector (fat_image_t *image, uint32_t cluster) {
+    return image->data_sector + ((cluster - ROOT_CLUSTER) * image->cluster_sectors);
+}
+
+bool fat_file_runs (fat_window_t *window, size_t size, fat_run_t *runs, uint32_t max_runs, uint32_t *run_count) {
+    fat_image_t *image = window->image;
+    uint32_t sector_count = size / SECTOR_SIZE;
+    uint32_t cluster = image->file_cluster;
+
+    *run_count = 0;
+
+    for (uint32_t file_sector = 0; file_sector < sector_count; file_sector += image->cluster_sectors) {
+        if (file_sector > 0) {
+            cluster = fat_window_next(window, cluster);
+        }
+        if ((cluster < ROOT_CLUSTER) || (cluster >= (image->cluster_count + ROOT_CLUSTER))) {
+            return true;
+        }
+        uint32_t sector = fat_cluster_sector(image, cluster);
+        uint32_t count = MIN(image->cluster_sectors, sector_count - file_sector);
+        if ((*run_count > 0) && ((runs[*run_count - 1].sector + runs[*run_count - 1].count) == sector)) {
+            runs[*run_count - 1].count += count;
+            continue;
+        }
+        if (*run_count == max_runs) {
+            return true;
+        }
+        runs[*run_count].sector = sector;
+        runs[*run_count].count = count;
+        *run_count += 1;
+    }
+
+    return false;
+}
@@ -0,0 +1,103 @@
+#ifndef HOST_FATIMAGE_H__
+#define HOST_FATIMAGE_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define FAT_END_OF_CHAIN    (0x0FFFFFFF)
+
+
+typedef enum {
+    FAT_TYPE_FAT12,
+    FAT_TYPE_FAT16,
+    FAT_TYPE_FAT32,
+    FAT_TYPE_EXFAT,
+} fat_type_t;
+
+typedef struct {
+    fat_type_t type;
+    uint32_t cluster_kib;
+    uint32_t file_size;
+    uint32_t fragments;
+    uint32_t seed;
+    uint32_t free_clusters;
+    bool free_gaps;
+} fat_image_config_t;
+
+/**
+ * @brief In-memory FAT volume served by a mock block device.
+ *
+ * The volume holds a single file of interest, split into fragments that are scattered between
+ * clusters of other files. Every device read is counted so load strategies can be compared by
+ * the number of SD commands they would issue.
+ *
+ * Free clusters can be left after the file, or in the gaps between its fragments, for the
+ * FatFs mock to allocate new files from. The window and run helpers only walk FAT32 volumes.
+ */
+typedef struct {
+    uint8_t *data;
+    fat_type_t type;
+    uint32_t sector_count;
+    uint32_t cluster_sectors;
+    uint32_t fat_sector;
+    uint32_t fat_sectors;
+    uint32_t data_sector;
+    uint32_t cluster_count;
+
+    uint32_t file_cluster;
+    uint32_t file_size;
+    uint8_t *file_data;
+
+    uint64_t commands;
+    uint64_t sectors_read;
+    uint64_t write_commands;
+    uint64_t sectors_written;
+} fat_image_t;
+
+typedef struct {
+    uint32_t sector;
+    uint32_t count;
+} fat_run_t;
+
+#define FAT_WINDOW_MAX_SECTORS  (8)
+
+// NOTE: Mirrors the menu chain walk, see src/utils/fs.c
+#define FAT_WALK_SECTORS        (8)
+
+/**
+ * @brief Window over the FAT, a single sector as kept by FatFs unless a wider span is asked for.
+ *
+ * Looking up the next cluster costs a device read only when the entry lives outside the sectors held.
+ * A miss on the sector right after the window reads `span` sectors, any other miss reads one.
+ */
+typedef struct {
+    fat_image_t *image;
+    uint32_t sector;
+    uint32_t count;
+    uint32_t span;
+    uint8_t buffer[FAT_WINDOW_MAX_SECTORS * 512];
+    uint64_t reads;
+} fat_window_t;
+
+
+void fat_image_create (fat_image_t *image, uint32_t cluster_kib, uint32_t file_size, uint32_t fragments, uint32_t seed);
+void fat_image_create_volume (fat_image_t *image, fat_image_config_t *config);
+void fat_image_free (fat_image_t *image);
+void fat_image_reset_stats (fat_image_t *image);
+bool fat_device_read (fat_image_t *image, void *buffer, uint32_t sector, uint32_t count);
+bool fat_device_write (fat_image_t *image, const void *buffer, uint32_t sector, uint32_t count);
+uint32_t fat_get_entry (fat_image_t *image, uint32_t cluster);
+void fat_set_entry (fat_image_t *image, uint32_t cluster, uint32_t value);
+uint32_t fat_end_of_chain (fat_image_t *image);
+
+void fat_window_init (fat_window_t *window, fat_image_t *image);
+void fat_window_init_span (fat_window_t *window, fat_image_t *image, uint32_t span);
+uint32_t fat_window_next (fat_window_t *window, uint32_t cluster);
+uint32_t fat_cluster_sector (fat_image_t *image, uint32_t cluster);
+bool fat_file_runs (fat_window_t *window, size_t size, fat_run_t *runs, uint32_t max_runs, uint32_t *run_count);
+
+
+#endif
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/utils/fs.h"
+#include "mock/fatfs/ff.h"
+
+#include "commands.h"
+#include "common.h"
+#include "fatfsmock.h"
+#include "fatimage.h"
+
+
+typedef struct {
+    file_run_t *runs;
+    uint32_t run_count;
+    uint64_t fat_reads;
+    uint64_t sectors;
+    double elapsed;
+} walk_stats_t;
+
+
+// Previous menu walk: a seek into every cluster, FatFs resumes from the current cluster through its single-sector window
+static bool walk_seek (char *path, uint32_t max_runs, walk_stats_t *stats) {
+    FIL fil;
+    bool error = false;
+
+    if (f_open(&fil, path, FA_READ) != FR_OK) {
+        return true;
+    }
+
+    FATFS *fs = fil.obj.fs;
+    uint32_t sector_count = ALIGN(f_size(&fil), SECTOR_SIZE) / SECTOR_SIZE;
+
+    for (uint32_t file_sector = 0; file_sector < sector_count; file_sector += fs->csize) {
+        if (f_lseek(&fil, (file_sector * SECTOR_SIZE) + (SECTOR_SIZE / 2)) != FR_OK) {
+            error = true;
+            break;
+        }
+        uint32_t sector = fs->database + (fs->csize * (fil.clust - 2));
+        uint32_t count = MIN(fs->csize, sector_count - file_sector);
+        if ((stats->run_count > 0) && ((stats->runs[stats->run_count - 1].sector + stats->runs[stats->run_count - 1].count) == sector)) {
+            stats->runs[stats->run_count - 1].count += count;
+            continue;
+        }
+        if (stats->run_count == max_runs) {
+            error = true;
+            break;
+        }
+        stats->runs[stats->run_count].sector = sector;
+        stats->runs[stats->run_count].count = count;
+        stats->run_count += 1;
+    }
+
+    f_close(&fil);
+
+    return error;
+}
+
+static void run_walk (fat_image_t *image, bool use_runs, uint32_t max_runs, walk_stats_t *stats) {
+    char path[] = "sd:" FATFS_MOCK_FILE_PATH;
+    bool error;
+
+    stats->run_count = 0;
+    fatfs_mock_invalidate();
+    fat_image_reset_stats(image);
+
+    double start = time_now();
+    if (use_runs) {
+        error = file_get_runs(path, stats->runs, max_runs, &stats->run_count);
+    } else {
+        error = walk_seek(strip_sd_prefix(path), max_runs, stats);
+    }
+    stats->elapsed = time_now() - start;
+
+    if (error) {
+        die("%s walk failed", use_runs ? "run" : "seek");
+    }
+
+    stats->fat_reads = image->commands;
+    stats->sectors = image->sectors_read;
+}
+
+static void print_stats (const char *name, walk_stats_t *stats, double overhead_us, double rate) {
+    double model = (stats->fat_reads * overhead_us * 1e-6) + ((stats->sectors * SECTOR_SIZE) / (rate * 1e6));
+
+    printf("  %-8s %6llu FAT reads  %6llu sectors  model %8.2f ms  host %7.3f ms\n",
+        name, (unsigned long long) (stats->fat_reads), (unsigned long long) (stats->sectors),
+        model * 1e3, stats->elapsed * 1e3
+    );
+}
+
+
+int cmd_bench_fat_walk (int argc, char **argv) {
+    static const uint32_t default_fragments[] = { 1, 8, 64, 512, 2048 };
+    uint32_t cluster_kib = 32;
+    uint32_t size_mib = 64;
+    double overhead_us = 200.0;
+    double rate = 20.0;
+    bool costlier = false;
+
+    while ((argc >= 2) && (argv[0][0] == '-')) {
+        if (strcmp(argv[0], "-c") == 0) {
+            cluster_kib = atoi(argv[1]);
+        } else if (strcmp(argv[0], "-s") == 0) {
+            size_mib = atoi(argv[1]);
+        } else if (strcmp(argv[0], "-o") == 0) {
+            overhead_us = atof(argv[1]);
+        } else if (strcmp(argv[0], "-r") == 0) {
+            rate = atof(argv[1]);
+        } else {
+            break;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if ((cluster_kib == 0) || (cluster_kib > 64) || ((cluster_kib & (cluster_kib - 1)) != 0) || (size_mib == 0) || (size_mib > 64) || (rate <= 0.0)) {
+        fprintf(stderr, "usage: n64menu-tool bench-fat-walk [-c cluster-kib] [-s size-mib] [-o command-us] [-r MB/s] [fragments...]\n");
+        return EXIT_FAILURE;
+    }
+
+    uint32_t fragment_count = (argc > 0) ? argc : (sizeof(default_fragments) / sizeof(default_fragments[0]));
+    uint32_t max_runs = MiB(size_mib) / KiB(cluster_kib);
+    fat_run_t *expected = xmalloc(max_runs * sizeof(fat_run_t));
+    walk_stats_t seek = { .runs = xmalloc(max_runs * sizeof(file_run_t)) };
+    walk_stats_t walk = { .runs = xmalloc(max_runs * sizeof(file_run_t)) };
+
+    printf("%u MiB file, %u kiB clusters, model %.0f us per command at %.1f MB/s\n", size_mib, cluster_kib, overhead_us, rate);
+
+    for (uint32_t i = 0; i < fragment_count; i++) {
+        uint32_t fragments = (argc > 0) ? (uint32_t) (atoi(argv[i])) : default_fragments[i];
+        uint32_t expected_count;
+        fat_image_t image;
+
+        fat_image_create(&image, cluster_kib, MiB(size_mib), fragments, i + 1);
+        fatfs_mock_mount(&image);
+
+        if (fatfs_mock_file_runs(FATFS_MOCK_FILE_PATH, expected, max_runs, &expected_count)) {
+            die("mock volume holds a broken chain");
+        }
+
+        run_walk(&image, false, max_runs, &seek);
+        run_walk(&image, true, max_runs, &walk);
+
+        if ((seek.run_count != expected_count) || (walk.run_count != expected_count)) {
+            die("walks disagree on the run count of %u fragments", fragments);
+        }
+        for (uint32_t run = 0; run < expected_count; run++) {
+            if ((seek.runs[run].sector != expected[run].sector) || (seek.runs[run].count != expected[run].count)
+                || (walk.runs[run].sector != expected[run].sector) || (walk.runs[run].count != expected[run].count)) {
+                die("walks disagree on the runs of %u fragments", fragments);
+            }
+        }
+        if (fatfs_mock_violations() > 0) {
+            die("walks of %u fragments broke the mock's rules", fragments);
+        }
+
+        printf("%u fragments, %u runs:\n", fragments, walk.run_count);
+        print_stats("seek", &seek, overhead_us, rate);
+        print_stats("walk", &walk, overhead_us, rate);
+
+        // NOTE: The walk must never issue more commands than the seek walk it replaced. A read ahead is
+        //       at most as long as the run already read, so even a wasted one can't double the sectors.
+        if ((walk.fat_reads > seek.fat_reads) || (walk.sectors > (seek.sectors * 2))) {
+            printf("  walk costs more than seek\n");
+            costlier = true;
+        }
+
+        fatfs_mock_unmount();
+        fat_image_free(&image);
+    }
+
+    free(walk.runs);
+    free(seek.runs);
+    free(expected);
+
+    return costlier ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,569 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/menu/save_ring.h"
+#include "../../src/utils/fs.h"
+#include "mock/fatfs/ff.h"
+
+#include "catalog.h"
+#include "commands.h"
+#include "common.h"
+#include "fatfsmock.h"
+#include "fatimage.h"
+
+
+#define MAX_RUNS            (4096)
+
+#define NEW_FILE_PATH       "sd:/new.bin"
+#define SAVE_PATH           "sd:/game.sav"
+#define SAVE_SIZE           KiB(128)
+
+
+static const char *type_names[] = {
+    [FAT_TYPE_FAT12] = "FAT12",
+    [FAT_TYPE_FAT16] = "FAT16",
+    [FAT_TYPE_FAT32] = "FAT32",
+    [FAT_TYPE_EXFAT] = "exFAT",
+};
+
+static struct {
+    bool verbose;
+    uint32_t checks;
+    uint32_t failures;
+} state;
+
+
+static void report (bool ok, const char *fmt, ...) {
+    va_list args;
+
+    state.checks += 1;
+    if (!ok) {
+        state.failures += 1;
+    }
+
+    if (!ok || state.verbose) {
+        printf("%s  ", ok ? "ok  " : "FAIL");
+        va_start(args, fmt);
+        vprintf(fmt, args);
+        va_end(args);
+        printf("\n");
+    }
+}
+
+static bool runs_match (char *path, uint32_t *run_count) {
+    fat_run_t expected[MAX_RUNS];
+    file_run_t runs[MAX_RUNS];
+    uint32_t expected_count;
+
+    if (fatfs_mock_file_runs(strip_sd_prefix(path), expected, MAX_RUNS, &expected_count)) {
+        return false;
+    }
+
+    if (file_get_runs(path, runs, MAX_RUNS, run_count)) {
+        return false;
+    }
+    if (*run_count != expected_count) {
+        return false;
+    }
+    for (uint32_t i = 0; i < expected_count; i++) {
+        if ((runs[i].sector != expected[i].sector) || (runs[i].count != expected[i].count)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Every FAT type through the real walk, the runs must match the chain as read straight from the image
+static void check_walks (void) {
+    static const struct {
+        fat_type_t type;
+        uint32_t cluster_kib;
+        uint32_t file_size;
+    } volumes[] = {
+        { FAT_TYPE_FAT12, 4, MiB(1) - 100 },
+        { FAT_TYPE_FAT12, 2, KiB(640) },
+        { FAT_TYPE_FAT16, 4, MiB(8) },
+        { FAT_TYPE_FAT16, 16, MiB(24) + 1 },
+        { FAT_TYPE_FAT32, 32, MiB(16) },
+        { FAT_TYPE_FAT32, 4, MiB(8) - 511 },
+        { FAT_TYPE_EXFAT, 32, MiB(16) },
+        { FAT_TYPE_EXFAT, 128, MiB(32) - 3 },
+    };
+    static const uint32_t fragments[] = { 1, 2, 9, 100 };
+
+    for (size_t i = 0; i < sizeof(volumes) / sizeof(volumes[0]); i++) {
+        for (size_t j = 0; j < sizeof(fragments) / sizeof(fragments[0]); j++) {
+            fat_image_config_t config = {
+                .type = volumes[i].type,
+                .cluster_kib = volumes[i].cluster_kib,
+                .file_size = volumes[i].file_size,
+                .fragments = fragments[j],
+                .seed = (i * 16) + j + 1,
+            };
+            fat_image_t image;
+            char path[] = "sd:" FATFS_MOCK_FILE_PATH;
+            uint32_t run_count = 0;
+
+            fat_image_create_volume(&image, &config);
+            fatfs_mock_mount(&image);
+
+            bool ok = runs_match(path, &run_count) && (fatfs_mock_violations() == 0);
+            report(ok, "%s %u KiB clusters, %u bytes in %u fragments: %u runs, %llu reads",
+                type_names[config.type], config.cluster_kib, config.file_size, config.fragments,
+                run_count, (unsigned long long) (image.commands)
+            );
+
+            fatfs_mock_unmount();
+            fat_image_free(&image);
+        }
+    }
+}
+
+// A list too short for the runs must fail, one exactly long enough must not
+static void check_run_limit (void) {
+    fat_image_config_t config = { .type = FAT_TYPE_FAT32, .cluster_kib = 32, .file_size = MiB(4), .fragments = 20, .seed = 7 };
+    fat_run_t expected[MAX_RUNS];
+    file_run_t runs[MAX_RUNS];
+    uint32_t expected_count;
+    uint32_t run_count;
+    fat_image_t image;
+    char path[] = "sd:" FATFS_MOCK_FILE_PATH;
+
+    fat_image_create_volume(&image, &config);
+    fatfs_mock_mount(&image);
+
+    fatfs_mock_file_runs(FATFS_MOCK_FILE_PATH, expected, MAX_RUNS, &expected_count);
+    report(file_get_runs(path, runs, expected_count - 1, &run_count), "%u runs overflow a list of %u", expected_count, expected_count - 1);
+    report(!file_get_runs(path, runs, expected_count, &run_count) && (run_count == expected_count), "%u runs fit a list of %u", expected_count, expected_count);
+
+    fatfs_mock_unmount();
+    fat_image_free(&image);
+}
+
+// A chain that ends early or points outside the volume must fail the walk on every FAT type
+static void check_broken_chains (void) {
+    static const fat_type_t types[] = { FAT_TYPE_FAT12, FAT_TYPE_FAT16, FAT_TYPE_FAT32, FAT_TYPE_EXFAT };
+
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        for (int breakage = 0; breakage < 3; breakage++) {
+            fat_image_config_t config = { .type = types[i], .cluster_kib = 4, .file_size = KiB(512), .fragments = 6, .seed = 3 + i };
+            file_run_t runs[MAX_RUNS];
+            uint32_t run_count;
+            fat_image_t image;
+            char path[] = "sd:" FATFS_MOCK_FILE_PATH;
+
+            fat_image_create_volume(&image, &config);
+
+            uint32_t cluster = image.file_cluster;
+            for (int step = 0; step < 40; step++) {
+                cluster = fat_get_entry(&image, cluster);
+            }
+            uint32_t values[] = { fat_end_of_chain(&image), image.cluster_count + 2, 1 };
+            fat_set_entry(&image, cluster, values[breakage]);
+
+            fatfs_mock_mount(&image);
+            report(file_get_runs(path, runs, MAX_RUNS, &run_count) && (fatfs_mock_violations() == 0),
+                "%s chain %s is refused", type_names[types[i]],
+                (breakage == 0) ? "ending early" : ((breakage == 1) ? "past the last cluster" : "into a reserved cluster")
+            );
+            fatfs_mock_unmount();
+            fat_image_free(&image);
+        }
+    }
+}
+
+// NOTE: A file just allocated by FatFs may have its last FAT entries only in the FatFs window,
+//       not yet on the card, the walk must read those from the window.
+static void check_dirty_window (void) {
+    static const fat_type_t types[] = { FAT_TYPE_FAT16, FAT_TYPE_FAT32, FAT_TYPE_EXFAT };
+
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        fat_image_config_t config = {
+            .type = types[i],
+            .cluster_kib = 4,
+            .file_size = KiB(256),
+            .fragments = 30,
+            .seed = 11,
+            .free_clusters = 64,
+            .free_gaps = true,
+        };
+        fat_image_t image;
+        char path[] = NEW_FILE_PATH;
+        uint32_t run_count = 0;
+        FIL fil;
+
+        fat_image_create_volume(&image, &config);
+        fatfs_mock_mount(&image);
+
+        bool ok = (f_open(&fil, strip_sd_prefix(path), FA_WRITE | FA_CREATE_NEW) == FR_OK)
+            && (f_lseek(&fil, KiB(160)) == FR_OK)
+            && (f_tell(&fil) == KiB(160))
+            && (f_close(&fil) == FR_OK);
+        ok = ok && fatfs_mock_window_dirty();
+        ok = ok && runs_match(path, &run_count) && (run_count > 1) && (fatfs_mock_violations() == 0);
+
+        report(ok, "%s walk of a file extended through gaps sees the unwritten window: %u runs", type_names[types[i]], run_count);
+
+        fatfs_mock_unmount();
+        fat_image_free(&image);
+    }
+}
+
+// exFAT files allocated in one piece have no chain, the walk must not read the FAT for them
+static void check_exfat_contiguous (void) {
+    fat_image_config_t config = { .type = FAT_TYPE_EXFAT, .cluster_kib = 32, .file_size = MiB(1), .fragments = 8, .seed = 5, .free_clusters = 256 };
+    fat_image_t image;
+    char path[] = NEW_FILE_PATH;
+    uint32_t run_count = 0;
+    FIL fil;
+
+    fat_image_create_volume(&image, &config);
+    fatfs_mock_mount(&image);
+
+    bool ok = (f_open(&fil, strip_sd_prefix(path), FA_WRITE | FA_CREATE_NEW) == FR_OK)
+        && (f_expand(&fil, MiB(4) + 100, 1) == FR_OK)
+        && (f_close(&fil) == FR_OK);
+
+    fatfs_mock_invalidate();
+    fat_image_reset_stats(&image);
+
+    ok = ok && runs_match(path, &run_count) && (run_count == 1) && (image.commands == 0);
+
+    report(ok, "exFAT contiguous file walks as %u run with %llu reads", run_count, (unsigned long long) (image.commands));
+
+    fatfs_mock_unmount();
+    fat_image_free(&image);
+}
+
+// Both branches of file_allocate(), the file must come out at full size and file_fill() must cover all of it
+static void check_allocate (void) {
+    static const struct {
+        const char *name;
+        fat_type_t type;
+        uint32_t cluster_kib;
+        uint32_t free_clusters;
+        uint32_t size;
+        bool expected_error;
+        bool expected_contiguous;
+    } cases[] = {
+        { "expanded in one piece", FAT_TYPE_FAT32, 32, 8, KiB(128), false, true },
+        { "expanded in one piece", FAT_TYPE_FAT16, 4, 40, KiB(128), false, true },
+        { "expanded in one piece", FAT_TYPE_FAT12, 2, 80, KiB(128), false, true },
+        { "expanded in one piece", FAT_TYPE_EXFAT, 32, 8, KiB(128), false, true },
+        { "expanded in one piece", FAT_TYPE_FAT32, 32, 1, 512, false, true },
+        { "extended through gaps", FAT_TYPE_FAT32, 4, 0, KiB(128), false, false },
+        { "extended through gaps", FAT_TYPE_FAT12, 2, 0, KiB(96), false, false },
+        { "extended through gaps", FAT_TYPE_EXFAT, 4, 0, KiB(128), false, false },
+        { "refused on a full card", FAT_TYPE_FAT32, 4, 0, MiB(2), true, false },
+        { "refused on a full card", FAT_TYPE_EXFAT, 4, 0, MiB(2), true, false },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        fat_image_config_t config = {
+            .type = cases[i].type,
+            .cluster_kib = cases[i].cluster_kib,
+            .file_size = KiB(256),
+            .fragments = 40,
+            .seed = 21 + i,
+            .free_clusters = cases[i].free_clusters,
+            .free_gaps = true,
+        };
+        uint32_t write_sectors = MIN(64, (cases[i].cluster_kib * 2));
+        uint32_t size_sectors = ALIGN(cases[i].size, SECTOR_SIZE) / SECTOR_SIZE;
+        uint8_t *data = xmalloc(cases[i].size);
+        fat_image_t image;
+        char path[] = NEW_FILE_PATH;
+        uint32_t run_count = 0;
+        bool ok;
+
+        fat_image_create_volume(&image, &config);
+        fatfs_mock_mount(&image);
+
+        bool error = file_allocate(path, cases[i].size);
+
+        if (cases[i].expected_error) {
+            ok = error && !file_exists(path);
+        } else {
+            ok = !error && (file_get_size(path) == cases[i].size);
+            ok = ok && runs_match(path, &run_count) && ((run_count == 1) == cases[i].expected_contiguous);
+
+            fat_image_reset_stats(&image);
+            ok = ok && !file_fill(path, 0xFF);
+            ok = ok && (image.write_commands <= (size_sectors + write_sectors - 1) / write_sectors + run_count);
+            ok = ok && !fatfs_mock_read_file(strip_sd_prefix(path), data, cases[i].size);
+            for (uint32_t j = 0; ok && (j < cases[i].size); j++) {
+                ok = (data[j] == 0xFF);
+            }
+        }
+
+        ok = ok && (fatfs_mock_violations() == 0);
+
+        report(ok, "%s %u bytes %s: %u runs, %llu fill writes", type_names[cases[i].type], cases[i].size, cases[i].name,
+            run_count, (unsigned long long) (image.write_commands)
+        );
+
+        free(data);
+        fatfs_mock_unmount();
+        fat_image_free(&image);
+    }
+}
+
+// A save restored from a backup keeps its size and date but lands on other clusters, only the first cluster tells them apart
+static void check_restored_cluster (void) {
+    fat_image_config_t config = { .type = FAT_TYPE_FAT32, .cluster_kib = 4, .file_size = KiB(64), .fragments = 4, .seed = 41, .free_clusters = 256 };
+    fat_image_t image;
+    char save_path[] = SAVE_PATH;
+    char copy_path[] = SAVE_PATH ".bak";
+    size_t size;
+    size_t restored_size;
+    uint32_t timestamp;
+    uint32_t restored_timestamp;
+    uint32_t cluster = 0;
+    uint32_t restored_cluster = 0;
+
+    fat_image_create_volume(&image, &config);
+    fatfs_mock_mount(&image);
+
+    bool ok = !file_allocate(copy_path, SAVE_SIZE) && !file_allocate(save_path, SAVE_SIZE);
+    ok = ok && !file_get_info(save_path, &size, &timestamp) && !file_get_cluster(save_path, &cluster);
+    FILINFO fno = { .fdate = (timestamp >> 16), .ftime = timestamp };
+    ok = ok && !file_delete(save_path) && (f_rename(strip_sd_prefix(copy_path), strip_sd_prefix(save_path)) == FR_OK);
+    ok = ok && (f_utime(strip_sd_prefix(save_path), &fno) == FR_OK);
+    ok = ok && !file_get_info(save_path, &restored_size, &restored_timestamp) && !file_get_cluster(save_path, &restored_cluster);
+    ok = ok && (restored_size == size) && (restored_timestamp == timestamp) && (restored_cluster != cluster);
+
+    report(ok, "restored save keeps its size and date, first cluster moves from %u to %u", cluster, restored_cluster);
+
+    fatfs_mock_unmount();
+    fat_image_free(&image);
+}
+
+static void save_pattern (uint32_t seed, uint8_t *data) {
+    uint32_t state = seed;
+
+    for (size_t i = 0; i < SAVE_SIZE; i++) {
+        state = (state * 1103515245) + 12345;
+        data[i] = (uint8_t) (state >> 16);
+    }
+}
+
+// Save writeback goes to the sectors of the save without FatFs, the directory entry isn't touched
+static void write_back (fat_image_t *image, uint32_t seed) {
+    fat_run_t runs[MAX_RUNS];
+    uint32_t run_count;
+    uint8_t *data = xmalloc(SAVE_SIZE);
+    size_t offset = 0;
+
+    save_pattern(seed, data);
+
+    if (fatfs_mock_file_runs(strip_sd_prefix(SAVE_PATH), runs, MAX_RUNS, &run_count)) {
+        die("mock save holds a broken chain");
+    }
+    for (uint32_t i = 0; i < run_count; i++) {
+        fat_device_write(image, data + offset, runs[i].sector, runs[i].count);
+        offset += (size_t) (runs[i].count) * SECTOR_SIZE;
+    }
+
+    free(data);
+}
+
+// Generation 0 is the save itself, a seed of 0 expects no file at all
+static bool ring_holds (const uint32_t seeds[SAVE_RING_GENERATIONS + 1]) {
+    uint8_t *expected = xmalloc(SAVE_SIZE);
+    uint8_t *data = xmalloc(SAVE_SIZE);
+    bool ok = true;
+
+    for (int generation = 0; generation <= SAVE_RING_GENERATIONS; generation++) {
+        char path[64];
+        if (generation == 0) {
+            snprintf(path, sizeof(path), "%s", SAVE_PATH);
+        } else {
+            snprintf(path, sizeof(path), "%s.%d", SAVE_PATH, generation);
+        }
+        if (seeds[generation] == 0) {
+            ok = ok && !file_exists(path);
+            continue;
+        }
+        save_pattern(seeds[generation], expected);
+        ok = ok && !fatfs_mock_read_file(strip_sd_prefix(path), data, SAVE_SIZE) && (memcmp(data, expected, SAVE_SIZE) == 0);
+    }
+
+    free(data);
+    free(expected);
+
+    return ok;
+}
+
+// A launch with an unchanged save must leave the ring alone reading the save once, or not at all once the ring was settled,
+// a changed one must push a generation
+static void check_save_ring (void) {
+    static const struct {
+        fat_type_t type;
+        uint32_t cluster_kib;
+    } volumes[] = {
+        { FAT_TYPE_FAT12, 2 },
+        { FAT_TYPE_FAT16, 4 },
+        { FAT_TYPE_FAT32, 32 },
+        { FAT_TYPE_EXFAT, 32 },
+    };
+
+    for (size_t i = 0; i < sizeof(volumes) / sizeof(volumes[0]); i++) {
+        fat_image_config_t config = {
+            .type = volumes[i].type,
+            .cluster_kib = volumes[i].cluster_kib,
+            .file_size = KiB(256),
+            .fragments = 20,
+            .seed = 31 + i,
+            .free_clusters = (8 * SAVE_SIZE) / KiB(volumes[i].cluster_kib),
+        };
+        uint32_t save_sectors = SAVE_SIZE / SECTOR_SIZE;
+        char save_path[] = SAVE_PATH;
+        char slot[] = SAVE_PATH ".tmp";
+        char sum[] = SAVE_PATH ".sum";
+        fat_image_t image;
+        bool ok;
+
+        fat_image_create_volume(&image, &config);
+        fatfs_mock_mount(&image);
+
+        if (file_allocate(save_path, SAVE_SIZE)) {
+            die("couldn't allocate the mock save");
+        }
+        write_back(&image, 1);
+
+        ok = !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 1, 1, 0, 0 }) && file_exists(sum);
+        report(ok, "%s first launch keeps the save as generation 1", type_names[volumes[i].type]);
+
+        fatfs_mock_invalidate();
+        fat_image_reset_stats(&image);
+        ok = !save_ring_rotate(save_path);
+        uint64_t unchanged_reads = image.sectors_read;
+        uint64_t unchanged_writes = image.write_commands;
+        ok = ok && (unchanged_writes == 0) && (unchanged_reads < (save_sectors + 16)) && ring_holds((uint32_t []) { 1, 1, 0, 0 });
+        report(ok, "%s unchanged save skips the rotation: %llu sectors read, %llu writes", type_names[volumes[i].type],
+            (unsigned long long) (unchanged_reads), (unsigned long long) (unchanged_writes)
+        );
+
+        write_back(&image, 2);
+        ok = !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 2, 2, 1, 0 });
+        write_back(&image, 3);
+        ok = ok && !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 3, 3, 2, 1 });
+        report(ok, "%s changed saves push generations back", type_names[volumes[i].type]);
+
+        write_back(&image, 4);
+        ok = !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 4, 4, 3, 2 }) && !file_exists(slot);
+        report(ok, "%s full ring drops the oldest generation", type_names[volumes[i].type]);
+
+        file_delete(sum);
+        fat_image_reset_stats(&image);
+        ok = !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 4, 4, 3, 2 }) && file_exists(sum);
+        ok = ok && !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 4, 4, 3, 2 });
+        report(ok, "%s ring without a record is recognised as unchanged", type_names[volumes[i].type]);
+
+        // NOTE: The menu settles the ring of the last played title on boot, the launch only rewrites the record
+        ok = !save_ring_settle(save_path) && ring_holds((uint32_t []) { 4, 4, 3, 2 });
+        fatfs_mock_invalidate();
+        fat_image_reset_stats(&image);
+        ok = ok && !save_ring_rotate(save_path);
+        uint64_t settled_reads = image.sectors_read;
+        uint64_t settled_writes = image.write_commands;
+        ok = ok && (settled_reads < 16) && (settled_writes <= 2) && ring_holds((uint32_t []) { 4, 4, 3, 2 });
+        report(ok, "%s launch after a settle doesn't read the save: %llu sectors read, %llu writes", type_names[volumes[i].type],
+            (unsigned long long) (settled_reads), (unsigned long long) (settled_writes)
+        );
+
+        write_back(&image, 5);
+        ok = !save_ring_settle(save_path) && ring_holds((uint32_t []) { 5, 5, 4, 3 });
+        ok = ok && !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 5, 5, 4, 3 });
+        report(ok, "%s settle after a session pushes a generation", type_names[volumes[i].type]);
+
+        write_back(&image, 6);
+        ok = !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 6, 6, 5, 4 });
+        report(ok, "%s launch without a settle still pushes the last session", type_names[volumes[i].type]);
+
+        // NOTE: A copy cut short leaves the slot behind, the ring itself is untouched
+        if (file_allocate(slot, SAVE_SIZE / 2)) {
+            die("couldn't allocate the mock slot");
+        }
+        write_back(&image, 7);
+        ok = !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 7, 7, 6, 5 }) && !file_exists(slot);
+        report(ok, "%s slot left by an interrupted rotation is overwritten", type_names[volumes[i].type]);
+
+        // NOTE: A card too full for the slot fails the copy, the oldest generation must still be there
+        int fillers = 0;
+        char filler[32];
+        do {
+            snprintf(filler, sizeof(filler), "sd:/filler.%d", fillers);
+        } while (!file_allocate(filler, SAVE_SIZE) && (++fillers < 64));
+        write_back(&image, 8);
+        ok = save_ring_rotate(save_path) && ring_holds((uint32_t []) { 8, 7, 6, 5 });
+        for (int filler_index = 0; filler_index < fillers; filler_index++) {
+            snprintf(filler, sizeof(filler), "sd:/filler.%d", filler_index);
+            file_delete(filler);
+        }
+        ok = ok && !save_ring_rotate(save_path) && ring_holds((uint32_t []) { 8, 8, 7, 6 }) && !file_exists(slot);
+        report(ok, "%s failed copy keeps the oldest generation", type_names[volumes[i].type]);
+
+        report(fatfs_mock_violations() == 0, "%s save ring keeps the mock's rules", type_names[volumes[i].type]);
+
+        fatfs_mock_unmount();
+        fat_image_free(&image);
+    }
+}
+
+
+// The host writer and reader must agree on every field, and the reader must reject what the menu rejects
+static void check_catalog (void) {
+    catalog_list_t list;
+    catalog_list_t parsed;
+    uint8_t *data;
+
+    catalog_list_synthetic(&list, 1000);
+    size_t size = catalog_serialize(&list, &data);
+
+    bool ok = !catalog_deserialize(data, size, &parsed) && (parsed.count == list.count);
+    ok = ok && (memcmp(parsed.entries, list.entries, list.count * sizeof(catalog_entry_t)) == 0);
+    report(ok, "catalog round trip keeps %u records", list.count);
+    catalog_list_free(&parsed);
+
+    // NOTE: Records offset is big-endian, moving it by 2 bytes leaves every other check passing
+    data[15] += 2;
+    report(catalog_deserialize(data, size, &parsed), "catalog with a misaligned records offset is rejected");
+    catalog_list_free(&parsed);
+
+    free(data);
+    catalog_list_free(&list);
+}
+
+int cmd_mock_fs (int argc, char **argv) {
+    memset(&state, 0, sizeof(state));
+
+    if ((argc > 0) && (strcmp(argv[0], "-v") == 0)) {
+        state.verbose = true;
+        argc -= 1;
+        argv += 1;
+    }
+
+    if (argc > 0) {
+        fprintf(stderr, "usage: n64menu-tool mock-fs [-v]\n");
+        return EXIT_FAILURE;
+    }
+
+    check_walks();
+    check_run_limit();
+    check_broken_chains();
+    check_dirty_window();
+    check_exfat_contiguous();
+    check_allocate();
+    check_restored_cluster();
+    check_save_ring();
+    check_catalog();
+
+    printf("%u checks, %u failed\n", state.checks, state.failures);
+
+    return (state.failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
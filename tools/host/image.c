@@ -0,0 +1,310 @@
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <jpeglib.h>
+#include <png.h>
+
+#include "common.h"
+#include "image.h"
+
+
+#define GLYPH_WIDTH     (5)
+#define GLYPH_HEIGHT    (7)
+#define GLYPH_SCALE     (2)
+#define GLYPH_ADVANCE   ((GLYPH_WIDTH + 1) * GLYPH_SCALE)
+#define LINE_ADVANCE    ((GLYPH_HEIGHT + 2) * GLYPH_SCALE)
+#define CARD_MARGIN     (20)
+
+
+typedef struct {
+    struct jpeg_error_mgr manager;
+    jmp_buf jump;
+} jpeg_error_t;
+
+// 5x7 glyphs, one byte per row with the leftmost pixel in bit 4, lowercase letters are drawn in uppercase
+static const struct {
+    char c;
+    uint8_t rows[GLYPH_HEIGHT];
+} glyphs[] = {
+    { 'A', { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+    { 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+    { 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+    { 'D', { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C } },
+    { 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+    { 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+    { 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+    { 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+    { 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+    { 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+    { 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+    { 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+    { 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+    { 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+    { 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+    { 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+    { 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+    { 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+    { 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+    { 'Y', { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 } },
+    { 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+    { '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+    { '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+    { '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+    { '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+    { '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+    { '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+    { '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+    { '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+    { '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+    { '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+    { '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+    { ',', { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 } },
+    { '\'', { 0x0C, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 } },
+    { ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+    { '!', { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 } },
+    { '?', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 } },
+    { '&', { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D } },
+    { '(', { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 } },
+    { ')', { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 } },
+    { '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+    { '+', { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 } },
+};
+
+
+static uint16_t rgba16 (uint32_t r, uint32_t g, uint32_t b) {
+    return ((r >> 3) << 11) | ((g >> 3) << 6) | ((b >> 3) << 1) | 1;
+}
+
+static void jpeg_error_exit (j_common_ptr cinfo) {
+    longjmp(((jpeg_error_t *) (cinfo->err))->jump, 1);
+}
+
+static bool load_png (const char *path, rgba_image_t *image) {
+    png_image png;
+
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_file(&png, path)) {
+        return true;
+    }
+
+    png.format = PNG_FORMAT_RGBA;
+    image->width = png.width;
+    image->height = png.height;
+    image->pixels = xmalloc(PNG_IMAGE_SIZE(png));
+
+    if (!png_image_finish_read(&png, NULL, image->pixels, 0, NULL)) {
+        png_image_free(&png);
+        rgba_image_free(image);
+        return true;
+    }
+
+    return false;
+}
+
+static bool load_jpeg (FILE *f, rgba_image_t *image) {
+    struct jpeg_decompress_struct cinfo;
+    jpeg_error_t error;
+    uint8_t *row = NULL;
+
+    cinfo.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = jpeg_error_exit;
+
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        free(row);
+        rgba_image_free(image);
+        return true;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, f);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    image->width = cinfo.output_width;
+    image->height = cinfo.output_height;
+    image->pixels = xmalloc((size_t) (image->width) * image->height * 4);
+    row = xmalloc((size_t) (image->width) * 3);
+
+    while (cinfo.output_scanline < cinfo.output_height) {
+        uint8_t *out = &image->pixels[(size_t) (cinfo.output_scanline) * image->width * 4];
+        jpeg_read_scanlines(&cinfo, &row, 1);
+        for (int x = 0; x < image->width; x++) {
+            out[(x * 4) + 0] = row[(x * 3) + 0];
+            out[(x * 4) + 1] = row[(x * 3) + 1];
+            out[(x * 4) + 2] = row[(x * 3) + 2];
+            out[(x * 4) + 3] = 0xFF;
+        }
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    free(row);
+
+    return false;
+}
+
+static const uint8_t *find_glyph (char c) {
+    if ((c >= 'a') && (c <= 'z')) {
+        c -= ('a' - 'A');
+    }
+    for (size_t i = 0; i < sizeof(glyphs) / sizeof(glyphs[0]); i++) {
+        if (glyphs[i].c == c) {
+            return glyphs[i].rows;
+        }
+    }
+    return NULL;
+}
+
+static void draw_glyph (art_image_t *image, int x, int y, const uint8_t *rows, uint16_t color) {
+    for (int row = 0; row < (GLYPH_HEIGHT * GLYPH_SCALE); row++) {
+        for (int column = 0; column < (GLYPH_WIDTH * GLYPH_SCALE); column++) {
+            int px = x + column;
+            int py = y + row;
+            if ((px >= image->width) || (py >= image->height)) {
+                continue;
+            }
+            if (rows[row / GLYPH_SCALE] & (0x10 >> (column / GLYPH_SCALE))) {
+                image->pixels[(py * image->width) + px] = color;
+            }
+        }
+    }
+}
+
+static void fill_background (art_image_t *image, int width, int height, uint32_t background) {
+    image->width = width;
+    image->height = height;
+    image->pixels = xmalloc((size_t) (width) * height * sizeof(uint16_t));
+
+    uint16_t color = rgba16((background >> 16) & 0xFF, (background >> 8) & 0xFF, background & 0xFF);
+    for (int i = 0; i < (width * height); i++) {
+        image->pixels[i] = color;
+    }
+}
+
+
+bool rgba_image_load (const char *path, rgba_image_t *image) {
+    uint8_t magic[4] = { 0 };
+    bool error = true;
+
+    image->pixels = NULL;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return true;
+    }
+    if (fread(magic, sizeof(magic), 1, f) != 1) {
+        fclose(f);
+        return true;
+    }
+    rewind(f);
+
+    // Formats are told apart by content, extensions are often wrong on downloaded artwork
+    if (memcmp(magic, "\x89PNG", 4) == 0) {
+        error = load_png(path, image);
+    } else if ((magic[0] == 0xFF) && (magic[1] == 0xD8)) {
+        error = load_jpeg(f, image);
+    }
+
+    fclose(f);
+
+    return error;
+}
+
+void rgba_image_free (rgba_image_t *image) {
+    free(image->pixels);
+    image->pixels = NULL;
+}
+
+void art_image_fit (const rgba_image_t *source, int width, int height, uint32_t background, art_image_t *image) {
+    uint32_t bg[3] = { (background >> 16) & 0xFF, (background >> 8) & 0xFF, background & 0xFF };
+
+    fill_background(image, width, height, background);
+
+    // Keep the aspect ratio and center the artwork, like the PowerShell importer does
+    double scale = MIN((double) (width) / source->width, (double) (height) / source->height);
+    int draw_width = MAX((int) ((source->width * scale) + 0.5), 1);
+    int draw_height = MAX((int) ((source->height * scale) + 0.5), 1);
+    int origin_x = (width - draw_width) / 2;
+    int origin_y = (height - draw_height) / 2;
+
+    for (int y = 0; y < draw_height; y++) {
+        int sy0 = MIN((int) (y / scale), source->height - 1);
+        int sy1 = MIN(MAX((int) ((y + 1) / scale), sy0 + 1), source->height);
+        for (int x = 0; x < draw_width; x++) {
+            int sx0 = MIN((int) (x / scale), source->width - 1);
+            int sx1 = MIN(MAX((int) ((x + 1) / scale), sx0 + 1), source->width);
+
+            // Box filter over the covered source pixels, weighted by alpha so transparent edges don't darken.
+            // Artwork smaller than the tile is upscaled with nearest neighbour.
+            uint64_t sum[3] = { 0, 0, 0 };
+            uint64_t alpha = 0;
+            int count = 0;
+            for (int sy = sy0; sy < sy1; sy++) {
+                const uint8_t *p = &source->pixels[(((size_t) (sy) * source->width) + sx0) * 4];
+                for (int sx = sx0; sx < sx1; sx++, p += 4) {
+                    sum[0] += p[0] * p[3];
+                    sum[1] += p[1] * p[3];
+                    sum[2] += p[2] * p[3];
+                    alpha += p[3];
+                    count += 1;
+                }
+            }
+
+            uint32_t color[3];
+            for (int channel = 0; channel < 3; channel++) {
+                uint64_t covered = alpha ? (sum[channel] / alpha) : 0;
+                uint64_t a = alpha / count;
+                color[channel] = ((covered * a) + (bg[channel] * (255 - a))) / 255;
+            }
+
+            image->pixels[((origin_y + y) * width) + origin_x + x] = rgba16(color[0], color[1], color[2]);
+        }
+    }
+}
+
+void art_image_title_card (const char *title, int width, int height, uint32_t background, art_image_t *image) {
+    fill_background(image, width, height, background);
+
+    uint16_t white = rgba16(0xFF, 0xFF, 0xFF);
+    int columns = MAX((width - (CARD_MARGIN * 2)) / GLYPH_ADVANCE, 1);
+    int y = CARD_MARGIN;
+    const char *p = title;
+
+    // Greedy word wrap, words longer than a line are split
+    while ((*p != '\0') && ((y + (GLYPH_HEIGHT * GLYPH_SCALE)) <= (height - CARD_MARGIN))) {
+        while (*p == ' ') {
+            p++;
+        }
+        int length = strlen(p);
+        int line = MIN(length, columns);
+        if (line < length) {
+            int space = line;
+            while ((space > 0) && (p[space] != ' ')) {
+                space--;
+            }
+            if (space > 0) {
+                line = space;
+            }
+        }
+        for (int i = 0; i < line; i++) {
+            const uint8_t *rows = find_glyph(p[i]);
+            if (rows != NULL) {
+                draw_glyph(image, CARD_MARGIN + (i * GLYPH_ADVANCE), y, rows, white);
+            }
+        }
+        p += line;
+        y += LINE_ADVANCE;
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef HOST_IMAGE_H__
+#define HOST_IMAGE_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "artcodec.h"
+
+
+/** @brief Decoded source artwork, 8-bit RGBA with straight alpha. */
+typedef struct {
+    int width;
+    int height;
+    uint8_t *pixels;
+} rgba_image_t;
+
+
+bool rgba_image_load (const char *path, rgba_image_t *image);
+void rgba_image_free (rgba_image_t *image);
+void art_image_fit (const rgba_image_t *source, int width, int height, uint32_t background, art_image_t *image);
+void art_image_title_card (const char *title, int width, int height, uint32_t background, art_image_t *image);
+
+
+#endif
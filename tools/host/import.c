@@ -0,0 +1,690 @@
+#define _DEFAULT_SOURCE
+
+#include <ctype.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../src/utils/rom_order.h"
+
+#include "artcodec.h"
+#include "catalog.h"
+#include "chunks.h"
+#include "commands.h"
+#include "common.h"
+#include "image.h"
+#include "sha256.h"
+
+
+#define ROM_CHUNK_SIZE      MiB(1)
+#define ROM_MAX_SIZE        MiB(78)
+#define ROM_ID_LENGTH       (5)
+
+#define ART_WIDTH           (256)
+#define ART_HEIGHT          (179)
+#define ART_BACKGROUND      (0x303030)
+#define CARD_BACKGROUND     (0x231E30)
+
+#define MAX_WORKERS         (64)
+
+
+typedef enum {
+    STAGE_ROM_READ,
+    STAGE_BYTESWAP,
+    STAGE_HASH,
+    STAGE_ROM_WRITE,
+    STAGE_ART_DECODE,
+    STAGE_ART_CONVERT,
+    STAGE_ART_WRITE,
+    STAGE_COUNT,
+} stage_t;
+
+typedef struct {
+    double seconds;
+    uint64_t bytes;
+    uint32_t items;
+} stage_stats_t;
+
+typedef struct {
+    char *path;
+    char *directory;
+    char *stem;
+    char *key;
+} file_entry_t;
+
+typedef struct {
+    file_entry_t *entries;
+    size_t count;
+} file_list_t;
+
+typedef struct {
+    file_entry_t *rom;
+    char id[CATALOG_ID_LENGTH];
+    uint32_t rom_size;
+    bool done;
+    bool error;
+} import_job_t;
+
+typedef struct {
+    const char *root;
+    import_job_t *jobs;
+    size_t count;
+    size_t next;
+    pthread_mutex_t lock;
+    stage_stats_t stats[STAGE_COUNT];
+    file_list_t siblings;
+    file_list_t images;
+    file_list_t retroarch;
+} importer_t;
+
+
+static const char *stage_names[STAGE_COUNT] = {
+    [STAGE_ROM_READ] = "rom read",
+    [STAGE_BYTESWAP] = "byteswap",
+    [STAGE_HASH] = "hash",
+    [STAGE_ROM_WRITE] = "rom write",
+    [STAGE_ART_DECODE] = "art decode",
+    [STAGE_ART_CONVERT] = "art convert",
+    [STAGE_ART_WRITE] = "art write",
+};
+
+static const char *rom_extensions[] = { ".n64", ".v64", ".z64", NULL };
+
+// NOTE: Only formats the host decoders understand are indexed, so a match is never a dead end
+static const char *image_extensions[] = { ".jpeg", ".jpg", ".png", NULL };
+
+
+static bool has_extension (const char *name, const char **extensions) {
+    const char *dot = strrchr(name, '.');
+    if (dot == NULL) {
+        return false;
+    }
+    for (int i = 0; extensions[i] != NULL; i++) {
+        if (strcasecmp(dot, extensions[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static char *file_stem (const char *path) {
+    const char *slash = strrchr(path, '/');
+    const char *name = slash ? (slash + 1) : path;
+    const char *dot = strrchr(name, '.');
+    return strndup(name, dot ? (size_t) (dot - name) : strlen(name));
+}
+
+static char *parent_name (const char *path) {
+    char *directory = strdup(path);
+    char *slash = strrchr(directory, '/');
+    if (slash != NULL) {
+        *slash = '\0';
+    }
+    slash = strrchr(directory, '/');
+    char *name = strdup(slash ? (slash + 1) : directory);
+    free(directory);
+    return name;
+}
+
+// Lowercase letters and digits only, so "Mario Kart 64 (USA)" matches "mario_kart_64_usa"
+static char *name_key (const char *name) {
+    char *key = xmalloc(strlen(name) + 1);
+    char *p = key;
+    for (; *name != '\0'; name++) {
+        unsigned char c = *name;
+        if (isalnum(c) || (c >= 0x80)) {
+            *p++ = tolower(c);
+        }
+    }
+    *p = '\0';
+    return key;
+}
+
+// Drops "(Rev A)", "(Beta 2)" and "(Proto)" tags, along with the whitespace before them
+static char *strip_revision (const char *name) {
+    char *result = strdup(name);
+    char *open;
+    char *search = result;
+
+    while ((open = strchr(search, '(')) != NULL) {
+        char *close = strchr(open, ')');
+        if ((close != NULL) && ((strncasecmp(open + 1, "rev", 3) == 0) || (strncasecmp(open + 1, "beta", 4) == 0) || (strncasecmp(open + 1, "proto", 5) == 0))) {
+            char *start = open;
+            while ((start > result) && isspace((unsigned char) (start[-1]))) {
+                start--;
+            }
+            memmove(start, close + 1, strlen(close + 1) + 1);
+            search = start;
+        } else {
+            search = open + 1;
+        }
+    }
+
+    return result;
+}
+
+static void file_list_add (file_list_t *list, const char *path) {
+    list->entries = realloc(list->entries, (list->count + 1) * sizeof(file_entry_t));
+    if (list->entries == NULL) {
+        die("out of memory");
+    }
+    file_entry_t *entry = &list->entries[list->count++];
+    entry->path = strdup(path);
+    entry->directory = strdup(path);
+    char *slash = strrchr(entry->directory, '/');
+    if (slash != NULL) {
+        *slash = '\0';
+    }
+    entry->stem = file_stem(path);
+    entry->key = name_key(entry->stem);
+}
+
+static void file_list_free (file_list_t *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->entries[i].path);
+        free(list->entries[i].directory);
+        free(list->entries[i].stem);
+        free(list->entries[i].key);
+    }
+    free(list->entries);
+    list->entries = NULL;
+    list->count = 0;
+}
+
+static int compare_paths (const void *a, const void *b) {
+    return strcmp(((const file_entry_t *) (a))->path, ((const file_entry_t *) (b))->path);
+}
+
+static void scan_directory (const char *root, bool recursive, const char **extensions, file_list_t *list) {
+    DIR *dir = opendir(root);
+    if (dir == NULL) {
+        return;
+    }
+
+    struct dirent *dirent;
+    while ((dirent = readdir(dir)) != NULL) {
+        if (dirent->d_name[0] == '.') {
+            continue;
+        }
+        char *path = path_join(root, dirent->d_name);
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            if (S_ISDIR(st.st_mode) && recursive) {
+                scan_directory(path, recursive, extensions, list);
+            } else if (S_ISREG(st.st_mode) && has_extension(dirent->d_name, extensions)) {
+                file_list_add(list, path);
+            }
+        }
+        free(path);
+    }
+
+    closedir(dir);
+}
+
+static void scan_files (const char *root, bool recursive, const char **extensions, file_list_t *list) {
+    list->entries = NULL;
+    list->count = 0;
+    scan_directory(root, recursive, extensions, list);
+    qsort(list->entries, list->count, sizeof(file_entry_t), compare_paths);
+}
+
+static const char *find_unique (file_list_t *list, const char *name, bool by_key) {
+    const char *match = NULL;
+    for (size_t i = 0; i < list->count; i++) {
+        if (strcmp(by_key ? list->entries[i].key : list->entries[i].stem, name) == 0) {
+            if (match != NULL) {
+                return NULL;
+            }
+            match = list->entries[i].path;
+        }
+    }
+    return match;
+}
+
+static const char *find_indexed (file_list_t *list, char **names, int count) {
+    for (int i = 0; i < count; i++) {
+        const char *match = find_unique(list, names[i], false);
+        if (match != NULL) {
+            return match;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        char *key = name_key(names[i]);
+        const char *match = find_unique(list, key, true);
+        free(key);
+        if (match != NULL) {
+            return match;
+        }
+    }
+    return NULL;
+}
+
+static void add_name (char **names, int *count, char *name) {
+    bool duplicate = (name[0] == '\0');
+    for (int i = 0; i < *count; i++) {
+        duplicate |= (strcmp(names[i], name) == 0);
+    }
+    if (duplicate) {
+        free(name);
+    } else {
+        names[(*count)++] = name;
+    }
+}
+
+// Same search order as the PowerShell importer: image beside the ROM, image directory, then RetroArch thumbnails
+static const char *find_artwork (importer_t *importer, file_entry_t *rom) {
+    const char *single = NULL;
+    int siblings = 0;
+
+    for (size_t i = 0; i < importer->siblings.count; i++) {
+        file_entry_t *image = &importer->siblings.entries[i];
+        if (strcmp(image->directory, rom->directory) != 0) {
+            continue;
+        }
+        if (strcasecmp(image->stem, rom->stem) == 0) {
+            return image->path;
+        }
+        single = image->path;
+        siblings += 1;
+    }
+    if (siblings == 1) {
+        return single;
+    }
+
+    char *names[4];
+    int count = 0;
+    char *parent = parent_name(rom->path);
+    const char *bases[2] = { rom->stem, parent };
+    for (int i = 0; i < 2; i++) {
+        add_name(names, &count, strdup(bases[i]));
+        add_name(names, &count, strip_revision(bases[i]));
+    }
+    free(parent);
+
+    const char *match = find_indexed(&importer->images, names, count);
+    if (match == NULL) {
+        match = find_indexed(&importer->retroarch, names, count);
+    }
+
+    for (int i = 0; i < count; i++) {
+        free(names[i]);
+    }
+
+    return match;
+}
+
+static void stage_add (stage_stats_t *stats, stage_t stage, double start, uint64_t bytes) {
+    stats[stage].seconds += time_now() - start;
+    stats[stage].bytes += bytes;
+}
+
+static void stage_count (stage_stats_t *stats, stage_t first, stage_t last) {
+    for (stage_t stage = first; stage <= last; stage++) {
+        stats[stage].items += 1;
+    }
+}
+
+// Streams the ROM once: each chunk is byteswapped, hashed and written to a temporary file renamed after the ID is known
+static bool import_rom (importer_t *importer, import_job_t *job, uint8_t *buffer, stage_stats_t *stats) {
+    const char *path = job->rom->path;
+    char *temporary = path_printf("%s/menu/title/.import-%zu.tmp", importer->root, (size_t) (job - importer->jobs));
+    bool error = false;
+    uint64_t size = 0;
+    rom_order_t order = ROM_ORDER_Z64;
+    sha256_t sha;
+    chunk_builder_t *chunks = xmalloc(sizeof(chunk_builder_t));
+
+    sha256_init(&sha);
+    chunk_builder_init(chunks, ROM_CHUNKS_DEFAULT_SHIFT);
+
+    FILE *in = fopen(path, "rb");
+    FILE *out = fopen(temporary, "wb");
+    if ((in == NULL) || (out == NULL)) {
+        fprintf(stderr, "error: couldn't open %s\n", (in == NULL) ? path : temporary);
+        error = true;
+    }
+
+    while (!error) {
+        double start = time_now();
+        size_t count = fread(buffer, 1, ROM_CHUNK_SIZE, in);
+        stage_add(stats, STAGE_ROM_READ, start, count);
+        if (count == 0) {
+            break;
+        }
+
+        if ((size == 0) && ((count < 4) || ((order = rom_order_detect(buffer)) == ROM_ORDER_UNKNOWN))) {
+            fprintf(stderr, "error: unrecognized N64 ROM byte order: %s\n", path);
+            error = true;
+            break;
+        }
+        if (((order == ROM_ORDER_V64) && (count % 2)) || ((order == ROM_ORDER_N64) && (count % 4))) {
+            fprintf(stderr, "error: ROM size doesn't match its byte order: %s\n", path);
+            error = true;
+            break;
+        }
+        size += count;
+        if (size > ROM_MAX_SIZE) {
+            fprintf(stderr, "error: ROM exceeds the 78 MiB limit: %s\n", path);
+            error = true;
+            break;
+        }
+
+        start = time_now();
+        rom_order_convert(buffer, count, order);
+        stage_add(stats, STAGE_BYTESWAP, start, (order == ROM_ORDER_Z64) ? 0 : count);
+
+        start = time_now();
+        sha256_update(&sha, buffer, count);
+        chunk_builder_update(chunks, buffer, count);
+        stage_add(stats, STAGE_HASH, start, count);
+
+        start = time_now();
+        if (fwrite(buffer, 1, count, out) != count) {
+            fprintf(stderr, "error: couldn't write %s\n", temporary);
+            error = true;
+        }
+        stage_add(stats, STAGE_ROM_WRITE, start, count);
+    }
+
+    if ((in != NULL) && ferror(in)) {
+        fprintf(stderr, "error: couldn't read %s\n", path);
+        error = true;
+    }
+    if (!error && (size == 0)) {
+        fprintf(stderr, "error: ROM is too small: %s\n", path);
+        error = true;
+    }
+    if (in != NULL) {
+        fclose(in);
+    }
+    if ((out != NULL) && (fclose(out) != 0)) {
+        error = true;
+    }
+
+    if (!error) {
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        sha256_final(&sha, digest);
+        for (int i = 0; i < 3; i++) {
+            snprintf(&job->id[i * 2], 3, "%02X", digest[i]);
+        }
+        job->id[ROM_ID_LENGTH] = '\0';
+        job->rom_size = size;
+
+        // Two ROMs with the same contents can only be told apart by their file names, like the PowerShell importer this is fatal
+        pthread_mutex_lock(&importer->lock);
+        for (size_t i = 0; i < importer->count; i++) {
+            import_job_t *other = &importer->jobs[i];
+            if ((other != job) && other->done && !other->error && (strcmp(other->id, job->id) == 0)) {
+                fprintf(stderr, "error: generated ID collision %s: %s and %s\n", job->id, other->rom->path, path);
+                error = true;
+            }
+        }
+        job->done = true;
+        job->error = error;
+        pthread_mutex_unlock(&importer->lock);
+    }
+
+    if (!error) {
+        char *directory = path_printf("%s/menu/title/%s", importer->root, job->id);
+        char *destination = path_printf("%s/%s_e.z64", directory, job->id);
+        if (make_directories(directory) || (rename(temporary, destination) != 0)) {
+            fprintf(stderr, "error: couldn't move the ROM to %s\n", destination);
+            error = true;
+        }
+        // ROMs past the cartridge SDRAM are never resident, they get no chunk hash list
+        char *chunks_path = path_printf("%s/%s_e.chk", directory, job->id);
+        if (!error && !chunk_builder_finish(chunks) && chunk_file_write(chunks_path, &chunks->chunks)) {
+            fprintf(stderr, "warning: couldn't write %s, delta loads will fall back to full loads\n", chunks_path);
+        }
+        free(chunks_path);
+        free(destination);
+        free(directory);
+    }
+
+    if (error) {
+        remove(temporary);
+    }
+    free(temporary);
+    free(chunks);
+
+    return error;
+}
+
+static bool import_art (importer_t *importer, import_job_t *job, stage_stats_t *stats) {
+    const char *artwork = find_artwork(importer, job->rom);
+    art_image_t image;
+    bool generated = true;
+
+    if (artwork != NULL) {
+        rgba_image_t source;
+        double start = time_now();
+        bool error = rgba_image_load(artwork, &source);
+        stage_add(stats, STAGE_ART_DECODE, start, error ? 0 : ((uint64_t) (source.width) * source.height * 4));
+        if (error) {
+            fprintf(stderr, "warning: couldn't decode %s, generating a title card\n", artwork);
+        } else {
+            start = time_now();
+            art_image_fit(&source, ART_WIDTH, ART_HEIGHT, ART_BACKGROUND, &image);
+            stage_add(stats, STAGE_ART_CONVERT, start, (uint64_t) (source.width) * source.height * 4);
+            rgba_image_free(&source);
+            stage_count(stats, STAGE_ART_DECODE, STAGE_ART_DECODE);
+            generated = false;
+        }
+    }
+
+    char *title = parent_name(job->rom->path);
+    if (generated) {
+        double start = time_now();
+        art_image_title_card(title, ART_WIDTH, ART_HEIGHT, CARD_BACKGROUND, &image);
+        stage_add(stats, STAGE_ART_CONVERT, start, ART_WIDTH * ART_HEIGHT * 4);
+    }
+
+    uint8_t *sprite;
+    size_t size = art_image_to_sprite(&image, &sprite);
+    art_image_free(&image);
+
+    char *sprite_path = path_printf("%s/menu/title/%s/%s_e.sprite", importer->root, job->id, job->id);
+    char *name_path = path_printf("%s/menu/title/%s/%s_e.name", importer->root, job->id, job->id);
+    double start = time_now();
+    bool error = file_write_all(sprite_path, sprite, size) || file_write_all(name_path, job->rom->stem, strlen(job->rom->stem));
+    stage_add(stats, STAGE_ART_WRITE, start, size);
+    stage_count(stats, STAGE_ART_CONVERT, STAGE_ART_WRITE);
+    if (error) {
+        fprintf(stderr, "error: couldn't write %s\n", sprite_path);
+    }
+
+    pthread_mutex_lock(&importer->lock);
+    printf("%s %s\n", generated ? "GENERATED" : "IMPORTED ", generated ? title : job->rom->stem);
+    pthread_mutex_unlock(&importer->lock);
+
+    free(name_path);
+    free(sprite_path);
+    free(sprite);
+    free(title);
+
+    return error;
+}
+
+static void *import_worker (void *arg) {
+    importer_t *importer = arg;
+    uint8_t *buffer = xmalloc(ROM_CHUNK_SIZE);
+    stage_stats_t stats[STAGE_COUNT] = { 0 };
+
+    while (true) {
+        pthread_mutex_lock(&importer->lock);
+        size_t index = importer->next++;
+        pthread_mutex_unlock(&importer->lock);
+
+        if (index >= importer->count) {
+            break;
+        }
+
+        import_job_t *job = &importer->jobs[index];
+
+        if (import_rom(importer, job, buffer, stats)) {
+            pthread_mutex_lock(&importer->lock);
+            job->done = true;
+            job->error = true;
+            pthread_mutex_unlock(&importer->lock);
+            continue;
+        }
+        stage_count(stats, STAGE_ROM_READ, STAGE_ROM_WRITE);
+
+        if (import_art(importer, job, stats)) {
+            job->error = true;
+        }
+    }
+
+    pthread_mutex_lock(&importer->lock);
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        importer->stats[i].seconds += stats[i].seconds;
+        importer->stats[i].bytes += stats[i].bytes;
+        importer->stats[i].items += stats[i].items;
+    }
+    pthread_mutex_unlock(&importer->lock);
+
+    free(buffer);
+
+    return NULL;
+}
+
+
+int cmd_import (int argc, char **argv) {
+    const char *images_root = NULL;
+    const char *retroarch_root = NULL;
+    bool recursive = false;
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+
+    while (argc > 2) {
+        if (strcmp(argv[0], "-r") == 0) {
+            recursive = true;
+            argc -= 1;
+            argv += 1;
+            continue;
+        }
+        if (strcmp(argv[0], "-j") == 0) {
+            workers = atol(argv[1]);
+        } else if (strcmp(argv[0], "--images") == 0) {
+            images_root = argv[1];
+        } else if (strcmp(argv[0], "--retroarch") == 0) {
+            retroarch_root = argv[1];
+        } else {
+            break;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: n64menu-tool import [-j workers] [-r] [--images dir] [--retroarch dir] <rom-dir> <sd-root>\n");
+        return EXIT_FAILURE;
+    }
+
+    workers = MIN(MAX(workers, 1), MAX_WORKERS);
+
+    importer_t importer = { .root = argv[1] };
+    pthread_mutex_init(&importer.lock, NULL);
+
+    file_list_t roms;
+    scan_files(argv[0], recursive, rom_extensions, &roms);
+    if (roms.count == 0) {
+        die("no N64 ROMs were found in %s", argv[0]);
+    }
+    if (roms.count > CATALOG_MAX_RECORDS) {
+        die("catalog is limited to %d titles, found %zu ROMs", CATALOG_MAX_RECORDS, roms.count);
+    }
+
+    scan_files(argv[0], recursive, image_extensions, &importer.siblings);
+    if (images_root != NULL) {
+        scan_files(images_root, recursive, image_extensions, &importer.images);
+    }
+    if (retroarch_root != NULL) {
+        char *named = path_join(retroarch_root, "Named_Boxarts");
+        struct stat st;
+        scan_files(((stat(named, &st) == 0) && S_ISDIR(st.st_mode)) ? named : retroarch_root, false, image_extensions, &importer.retroarch);
+        free(named);
+    }
+
+    char *title_root = path_join(argv[1], "menu/title");
+    if (make_directories(title_root)) {
+        die("couldn't create %s", title_root);
+    }
+
+    importer.jobs = xcalloc(roms.count, sizeof(import_job_t));
+    importer.count = roms.count;
+    for (size_t i = 0; i < roms.count; i++) {
+        importer.jobs[i].rom = &roms.entries[i];
+    }
+
+    double start = time_now();
+
+    pthread_t threads[MAX_WORKERS];
+    for (long i = 0; i < workers; i++) {
+        if (pthread_create(&threads[i], NULL, import_worker, &importer) != 0) {
+            die("couldn't start worker %ld", i);
+        }
+    }
+    for (long i = 0; i < workers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double elapsed = time_now() - start;
+
+    // Catalog follows the sorted ROM list so the result doesn't depend on worker scheduling
+    catalog_list_t list;
+    catalog_list_t previous;
+    bool error = false;
+    uint64_t rom_bytes = 0;
+
+    catalog_list_init(&list);
+    for (size_t i = 0; i < importer.count; i++) {
+        import_job_t *job = &importer.jobs[i];
+        if (job->error) {
+            error = true;
+            continue;
+        }
+        catalog_entry_t *entry = catalog_list_add(&list, job->id);
+        catalog_entry_set_name(entry, job->rom->stem, strlen(job->rom->stem));
+        entry->rom_size = job->rom_size;
+        rom_bytes += job->rom_size;
+    }
+    catalog_layout(&list);
+
+    char *catalog_path = path_join(argv[1], "menu/catalog.bin");
+    if (!catalog_read(catalog_path, &previous)) {
+        catalog_merge_plays(&list, &previous);
+        catalog_list_free(&previous);
+    }
+    if (catalog_write(catalog_path, &list)) {
+        die("couldn't write %s", catalog_path);
+    }
+
+    printf("Imported %u title(s) into %s with %ld worker(s) in %.2f s (%.1f MB/s of ROM data)\n",
+        list.count, argv[1], workers, elapsed, (rom_bytes / 1e6) / MAX(elapsed, 1e-9)
+    );
+    printf("%-12s %6s %10s %10s %12s\n", "stage", "items", "MB", "busy s", "MB/s/worker");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        stage_stats_t *stats = &importer.stats[i];
+        printf("%-12s %6u %10.1f %10.2f %12.1f\n",
+            stage_names[i], stats->items, stats->bytes / 1e6, stats->seconds,
+            (stats->seconds > 0.0) ? ((stats->bytes / 1e6) / stats->seconds) : 0.0
+        );
+    }
+
+    free(catalog_path);
+    catalog_list_free(&list);
+    free(title_root);
+    free(importer.jobs);
+    file_list_free(&importer.retroarch);
+    file_list_free(&importer.images);
+    file_list_free(&importer.siblings);
+    file_list_free(&roms);
+    pthread_mutex_destroy(&importer.lock);
+
+    return error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
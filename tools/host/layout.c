@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../src/menu/title_table.h"
+
+#include "commands.h"
+#include "common.h"
+
+
+#define BOX_REGION_X_MIN    64.0f
+#define BOX_REGION_X_MAX    624.0f
+#define BOX_REGION_Y_MIN    16.0f
+
+
+static void bench_layout (int count, int iterations) {
+    int row_count = (count + TITLE_COLUMNS - 1) / TITLE_COLUMNS;
+    size_t arena_size = 0;
+    float bottom = 0.0f;
+
+    double start = time_now();
+    for (int i = 0; i < iterations; i++) {
+        title_table_t table;
+        if (title_table_create(&table, count, row_count)) {
+            die("couldn't allocate title table for %d titles", count);
+        }
+        for (int title = 0; title < count; title++) {
+            title_table_place(&table, title, title / TITLE_COLUMNS, title % TITLE_COLUMNS);
+        }
+        bottom = title_table_layout(&table, BOX_REGION_X_MIN, BOX_REGION_X_MAX, BOX_REGION_Y_MIN);
+        arena_size = table.arena_size;
+        title_table_free(&table);
+    }
+    double elapsed = (time_now() - start) / iterations;
+
+    printf("%8d titles  %6d rows  arena %9zu bytes (%6.1f B/title)  build+layout %8.3f ms  grid height %.0f px\n",
+        count, row_count, arena_size, (double) (arena_size) / MAX(count, 1), elapsed * 1e3, bottom
+    );
+}
+
+
+int cmd_bench_layout (int argc, char **argv) {
+    static const int default_counts[] = { 1000, 10000, 50000 };
+
+    if (argc == 0) {
+        for (size_t i = 0; i < sizeof(default_counts) / sizeof(default_counts[0]); i++) {
+            bench_layout(default_counts[i], 20);
+        }
+    } else {
+        for (int i = 0; i < argc; i++) {
+            bench_layout(atoi(argv[i]), 20);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
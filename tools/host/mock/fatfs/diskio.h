@@ -0,0 +1,21 @@
+#ifndef HOST_MOCK_DISKIO_H__
+#define HOST_MOCK_DISKIO_H__
+
+
+#include "ff.h"
+
+
+typedef enum {
+    RES_OK = 0,
+    RES_ERROR,
+    RES_WRPRT,
+    RES_NOTRDY,
+    RES_PARERR,
+} DRESULT;
+
+
+DRESULT disk_read (BYTE pdrv, BYTE *buff, LBA_t sector, UINT count);
+DRESULT disk_write (BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count);
+
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef HOST_MOCK_FF_H__
+#define HOST_MOCK_FF_H__
+
+// The FatFs API used by the menu file helpers, served by tools/host/fatfsmock.c over an in-memory FAT image.
+// Fields keep their FatFs names so the menu code that peeks into the file system objects builds unchanged.
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define FF_USE_EXPAND   (1)
+
+#define FF_MAX_SS       (512)
+
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+typedef uint32_t LBA_t;
+typedef uint64_t FSIZE_t;
+typedef char TCHAR;
+
+typedef enum {
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+    FR_EXIST,
+    FR_INVALID_OBJECT,
+    FR_WRITE_PROTECTED,
+    FR_INVALID_DRIVE,
+    FR_NOT_ENABLED,
+    FR_NO_FILESYSTEM,
+    FR_MKFS_ABORTED,
+    FR_TIMEOUT,
+    FR_LOCKED,
+    FR_NOT_ENOUGH_CORE,
+    FR_TOO_MANY_OPEN_FILES,
+    FR_INVALID_PARAMETER,
+} FRESULT;
+
+#define FS_FAT12        (1)
+#define FS_FAT16        (2)
+#define FS_FAT32        (3)
+#define FS_EXFAT        (4)
+
+#define FA_READ         (0x01)
+#define FA_WRITE        (0x02)
+#define FA_OPEN_EXISTING    (0x00)
+#define FA_CREATE_NEW   (0x04)
+#define FA_CREATE_ALWAYS    (0x08)
+#define FA_OPEN_ALWAYS  (0x10)
+#define FA_OPEN_APPEND  (0x30)
+
+#define AM_RDO          (0x01)
+#define AM_HID          (0x02)
+#define AM_SYS          (0x04)
+#define AM_DIR          (0x10)
+#define AM_ARC          (0x20)
+
+typedef struct {
+    BYTE fs_type;
+    BYTE pdrv;
+    BYTE wflag;
+    WORD csize;
+    DWORD last_clst;
+    DWORD n_fatent;
+    DWORD fsize;
+    LBA_t fatbase;
+    LBA_t database;
+    LBA_t winsect;
+    BYTE win[FF_MAX_SS];
+} FATFS;
+
+typedef struct {
+    FATFS *fs;
+    BYTE stat;
+    DWORD sclust;
+    FSIZE_t objsize;
+} FFOBJID;
+
+typedef struct {
+    FFOBJID obj;
+    BYTE flag;
+    FSIZE_t fptr;
+    DWORD clust;
+    int entry;
+} FIL;
+
+typedef struct {
+    FSIZE_t fsize;
+    WORD fdate;
+    WORD ftime;
+    BYTE fattrib;
+} FILINFO;
+
+
+#define f_tell(fp)      ((fp)->fptr)
+#define f_size(fp)      ((fp)->obj.objsize)
+
+FRESULT f_open (FIL *fp, const TCHAR *path, BYTE mode);
+FRESULT f_close (FIL *fp);
+FRESULT f_read (FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write (FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek (FIL *fp, FSIZE_t ofs);
+FRESULT f_expand (FIL *fp, FSIZE_t fsz, BYTE opt);
+FRESULT f_stat (const TCHAR *path, FILINFO *fno);
+FRESULT f_unlink (const TCHAR *path);
+FRESULT f_rename (const TCHAR *path_old, const TCHAR *path_new);
+FRESULT f_utime (const TCHAR *path, const FILINFO *fno);
+FRESULT f_mkdir (const TCHAR *path);
+
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef HOST_MOCK_LIBDRAGON_H__
+#define HOST_MOCK_LIBDRAGON_H__
+
+// Just enough of libdragon to build the flashcart low level drivers and the container loader against the register and PI mocks of the host tool
+
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+uint32_t io_read (uint32_t address);
+void io_write (uint32_t address, uint32_t value);
+void dma_wait (void);
+
+
+#endif
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commands.h"
+
+
+static const struct {
+    const char *name;
+    int (*run) (int argc, char **argv);
+    const char *help;
+} commands[] = {
+    { "import", cmd_import, "[options] <rom-dir> <sd-root> import ROMs and box art with a worker pool" },
+    { "catalog", cmd_catalog, "<sd-root>                 build menu/catalog.bin from an SD card layout" },
+    { "catalog-dump", cmd_catalog_dump, "<catalog.bin> [order] print catalog records" },
+    { "bench-catalog", cmd_bench_catalog, "[count] [iterations] benchmark catalog parsing and order building" },
+    { "bench-layout", cmd_bench_layout, "[count...]            benchmark title table build and layout" },
+    { "pack-art", cmd_pack_art, "[--format f] <sd-root>   pack box art into menu/art.pak" },
+    { "bench-art", cmd_bench_art, "<sd-root> [iterations]  compare per-title sprite reads with the art pack" },
+    { "bench-art-codec", cmd_bench_art_codec, "[sd-root|-] [iter] compare box art formats by size and decode speed" },
+    { "bench-rom-load", cmd_bench_rom_load, "[options] [fragments...] compare chunked and cluster run ROM loads on a mock SD" },
+    { "mock-sc64-load", cmd_mock_sc64_load, "[options]       check the SC64 SD load command sequence against a register mock" },
+    { "bench-fat-walk", cmd_bench_fat_walk, "[options] [fragments...] compare per-cluster seeks with the run walk of a FAT chain" },
+    { "mock-fs", cmd_mock_fs, "[-v]                     check the menu file helpers against a FatFs mock on every FAT type" },
+    { "chunk-hashes", cmd_chunk_hashes, "<sd-root> [id...]   write ROM chunk hash lists for delta loads" },
+    { "chunk-diff", cmd_chunk_diff, "<sd-root> <from> <to> report the chunks a delta load would transfer" },
+    { "bench-byteswap", cmd_bench_byteswap, "[size-mib] [iter]   compare the v64/n64 byte order kernels with byte loops" },
+    { "rom-pack", cmd_rom_pack, "<rom> [out.zlz]          compress a ROM into a block container the menu decodes on load" },
+    { "mock-rom-pack-load", cmd_mock_rom_pack_load, "[-s size-kib]  check the container loader's reads and SDRAM writes on the FatFs mock" },
+    { "bench-rom-pack", cmd_bench_rom_pack, "[options] <rom...> compare container decode speed with the SD read time it saves" },
+};
+
+
+static void usage (void) {
+    fprintf(stderr, "usage: n64menu-tool <command> [arguments]\n\ncommands:\n");
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        fprintf(stderr, "  %s %s\n", commands[i].name, commands[i].help);
+    }
+}
+
+
+int main (int argc, char **argv) {
+    if (argc < 2) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (strcmp(argv[1], commands[i].name) == 0) {
+            return commands[i].run(argc - 2, argv + 2);
+        }
+    }
+
+    usage();
+
+    return EXIT_FAILURE;
+}
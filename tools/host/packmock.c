@@ -0,0 +1,224 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/flashcart/flashcart_pack.h"
+#include "mock/fatfs/ff.h"
+
+#include "commands.h"
+#include "common.h"
+#include "fatfsmock.h"
+#include "fatimage.h"
+#include "pimock.h"
+#include "rompack.h"
+
+
+#define ROM_ADDRESS         (0x10000000UL)
+#define SDRAM_SIZE          MiB(64)
+
+#define PACK_PATH           "/rom.zlz"
+
+
+static struct {
+    uint8_t *sdram;
+    size_t cancel_at;
+    size_t last_done;
+    bool ended;
+    bool mapping_reset;
+    uint32_t violations;
+} mock;
+
+
+static void violation (const char *fmt, ...) {
+    va_list args;
+
+    fprintf(stderr, "load violation: ");
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+
+    mock.violations += 1;
+}
+
+static void sdram_write (const void *src, uint32_t address, size_t length) {
+    if ((address < ROM_ADDRESS) || (((address - ROM_ADDRESS) + (uint64_t) (length)) > SDRAM_SIZE)) {
+        violation("write of %zu bytes to %08X is outside SDRAM", length, address);
+        return;
+    }
+    memcpy(mock.sdram + (address - ROM_ADDRESS), src, length);
+}
+
+// NOTE: The container loader reads into RAM only, FatFs must never be pointed at cart space
+static void cart_read (uint32_t address, const void *data, size_t length) {
+    violation("FatFs read of %zu bytes into cart space at %08X", length, address);
+    sdram_write(data, address, length);
+}
+
+static void sd_command (void) {
+    if (pi_mock_busy()) {
+        violation("SD command issued while a PI write is in flight");
+    }
+}
+
+
+// NOTE: A large ROM loaded before may have left flash mapped over the end of SDRAM, it must be reset before any write
+flashcart_err_t flashcart_reset_rom_mapping (void) {
+    if (pi_mock_writes() > 0) {
+        violation("ROM mapping reset after %u SDRAM writes", pi_mock_writes());
+    }
+    mock.mapping_reset = true;
+    return FLASHCART_OK;
+}
+
+
+void load_progress_begin (flashcart_progress_callback_t *callback, flashcart_load_phase_t phase, size_t total) {
+    (void) (callback);
+    (void) (phase);
+    (void) (total);
+    mock.last_done = 0;
+    mock.ended = false;
+}
+
+bool load_progress_update (size_t done) {
+    if (done < mock.last_done) {
+        violation("progress went back from %zu to %zu", mock.last_done, done);
+    }
+    mock.last_done = done;
+    return (mock.cancel_at > 0) && (done >= mock.cancel_at);
+}
+
+void load_progress_end (void) {
+    mock.ended = true;
+}
+
+
+// Blocks alternate between ones that compress and random ones that are stored, so stored blocks start at odd offsets
+static uint8_t *make_rom (size_t size) {
+    uint8_t *rom = xmalloc(size);
+    uint32_t state = 0x12345678;
+
+    for (size_t offset = 0; offset < size; offset += ROM_PACK_BLOCK_SIZE) {
+        size_t length = MIN(ROM_PACK_BLOCK_SIZE, size - offset);
+        bool random = ((offset / ROM_PACK_BLOCK_SIZE) % 3) != 1;
+        for (size_t i = 0; i < length; i++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            rom[offset + i] = random ? (uint8_t) (state) : (uint8_t) ((i / 64) + (state & 1));
+        }
+    }
+
+    return rom;
+}
+
+static flashcart_err_t run_load (rom_pack_file_t *file, size_t write_size, size_t cancel_at, uint32_t *commands) {
+    fat_image_config_t config = {
+        .type = FAT_TYPE_FAT32,
+        .cluster_kib = 32,
+        .file_size = KiB(64),
+        .fragments = 2,
+        .seed = 3,
+        .free_clusters = (file->size / KiB(32)) + 2,
+        .free_gaps = true,
+    };
+    char path[] = "sd:" PACK_PATH;
+    fat_image_t image;
+    FIL fil;
+    UINT bw;
+
+    fat_image_create_volume(&image, &config);
+    fatfs_mock_mount(&image);
+
+    if ((f_open(&fil, PACK_PATH, FA_WRITE | FA_CREATE_NEW) != FR_OK)
+        || (f_write(&fil, file->data, write_size, &bw) != FR_OK) || (bw != write_size)
+        || (f_close(&fil) != FR_OK)) {
+        die("couldn't write the container to the mock volume");
+    }
+
+    memset(mock.sdram, 0, SDRAM_SIZE);
+    mock.cancel_at = cancel_at;
+    mock.mapping_reset = false;
+    pi_mock_reset(sdram_write);
+    fatfs_mock_set_cart(cart_read);
+    fatfs_mock_set_device_hook(sd_command);
+    fatfs_mock_invalidate();
+    fat_image_reset_stats(&image);
+
+    flashcart_err_t err = flashcart_pack_load(path, NULL);
+
+    if (pi_mock_busy()) {
+        violation("PI write left in flight after the load");
+    }
+    if (!mock.mapping_reset) {
+        violation("ROM mapping never reset");
+    }
+
+    *commands = image.commands;
+    mock.violations += fatfs_mock_violations() + pi_mock_violations();
+
+    fatfs_mock_unmount();
+    fat_image_free(&image);
+
+    return err;
+}
+
+
+int cmd_mock_rom_pack_load (int argc, char **argv) {
+    uint32_t size_kib = KiB(3) + 6;
+
+    while ((argc >= 2) && (argv[0][0] == '-')) {
+        if (strcmp(argv[0], "-s") == 0) {
+            size_kib = atoi(argv[1]);
+        } else {
+            break;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if ((argc != 0) || (size_kib == 0) || (KiB((size_t) (size_kib)) > ROM_PACK_MAX_ROM_SIZE)) {
+        fprintf(stderr, "usage: n64menu-tool mock-rom-pack-load [-s size-kib]\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t rom_size = KiB((size_t) (size_kib));
+    uint8_t *rom = make_rom(rom_size);
+    rom_pack_file_t file;
+    uint32_t stored_blocks = 0;
+    uint32_t commands;
+    bool ok = true;
+
+    if (rom_pack_file_build(rom, rom_size, &file)) {
+        die("couldn't build the container");
+    }
+    for (uint32_t i = 0; i < file.pack.block_count; i++) {
+        stored_blocks += rom_pack_block_stored(&file.pack, i) ? 1 : 0;
+    }
+
+    mock.sdram = xmalloc(SDRAM_SIZE);
+
+    flashcart_err_t err = run_load(&file, file.size, 0, &commands);
+    bool data_ok = (memcmp(mock.sdram, rom, rom_size) == 0);
+    printf("%zu byte ROM, %u blocks (%u stored) in a %zu byte container: %u SD commands, %u PI writes, data %s\n",
+        rom_size, file.pack.block_count, stored_blocks, file.size, commands, pi_mock_writes(), data_ok ? "OK" : "MISMATCH"
+    );
+    ok = ok && (err == FLASHCART_OK) && data_ok && mock.ended;
+
+    err = run_load(&file, file.size, rom_size / 2, &commands);
+    printf("cancelled halfway: %s\n", (err == FLASHCART_ERR_CANCELLED) ? "OK" : "FAIL");
+    ok = ok && (err == FLASHCART_ERR_CANCELLED) && !mock.ended;
+
+    err = run_load(&file, file.size - 1000, 0, &commands);
+    printf("truncated container: %s\n", (err == FLASHCART_ERR_LOAD) ? "OK" : "FAIL");
+    ok = ok && (err == FLASHCART_ERR_LOAD) && !mock.ended;
+
+    printf("%u violations\n", mock.violations);
+
+    free(mock.sdram);
+    rom_pack_file_free(&file);
+    free(rom);
+
+    return (ok && (mock.violations == 0)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,91 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mock/libdragon.h"
+
+#include "pimock.h"
+
+
+static struct {
+    pi_mock_write_t *write;
+    bool busy;
+    const void *src;
+    uint32_t address;
+    size_t length;
+    uint32_t writes;
+    uint32_t violations;
+} pi;
+
+
+static void violation (const char *fmt, ...) {
+    va_list args;
+
+    fprintf(stderr, "PI violation: ");
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+
+    pi.violations += 1;
+}
+
+
+void pi_mock_reset (pi_mock_write_t *write) {
+    memset(&pi, 0, sizeof(pi));
+    pi.write = write;
+}
+
+bool pi_mock_busy (void) {
+    return pi.busy;
+}
+
+uint32_t pi_mock_writes (void) {
+    return pi.writes;
+}
+
+uint32_t pi_mock_violations (void) {
+    return pi.violations;
+}
+
+
+// NOTE: Same checks as the asserts in src/flashcart/flashcart_utils.c
+void pi_dma_write_data_start (void *src, void *dst, size_t length) {
+    uint32_t address = (uint32_t) ((uintptr_t) (dst));
+
+    if ((((uintptr_t) (src)) & 0x07) != 0) {
+        violation("write source %p isn't 8 byte aligned", src);
+    }
+    if (((address & 0x01) != 0) || ((length & 1) != 0)) {
+        violation("write of %zu bytes to %08X isn't 16-bit aligned", length, address);
+    }
+
+    // libdragon waits for the PI to go idle before it starts the next transfer
+    dma_wait();
+
+    pi.busy = true;
+    pi.src = src;
+    pi.address = address;
+    pi.length = length;
+}
+
+void pi_dma_write_data (void *src, void *dst, size_t length) {
+    pi_dma_write_data_start(src, dst, length);
+    dma_wait();
+}
+
+void dma_wait (void) {
+    if (!pi.busy) {
+        return;
+    }
+
+    pi.busy = false;
+    pi.writes += 1;
+
+    if (pi.write == NULL) {
+        violation("unexpected write of %zu bytes to %08X", pi.length, pi.address);
+        return;
+    }
+
+    pi.write(pi.src, pi.address, pi.length);
+}
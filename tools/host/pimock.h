@@ -0,0 +1,25 @@
+#ifndef HOST_PIMOCK_H__
+#define HOST_PIMOCK_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Receives a PI write from RAM to cart space once it completes.
+ *
+ * The flashcart code starts writes with pi_dma_write_data_start() and waits for them with dma_wait(),
+ * the data is taken from the source buffer only when the write completes so one overwritten in flight shows up.
+ */
+typedef void pi_mock_write_t (const void *src, uint32_t address, size_t length);
+
+
+void pi_mock_reset (pi_mock_write_t *write);
+bool pi_mock_busy (void);
+uint32_t pi_mock_writes (void);
+uint32_t pi_mock_violations (void);
+
+
+#endif
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commands.h"
+#include "common.h"
+#include "fatimage.h"
+
+
+// NOTE: Mirrors the menu loaders, see src/flashcart/flashcart_utils.c
+#define LOAD_CHUNK_SIZE             KiB(128)
+#define LOAD_MAX_TRANSFER_SECTORS   (MiB(1) / SECTOR_SIZE)
+
+
+typedef struct {
+    uint64_t commands;
+    uint64_t fat_reads;
+    uint64_t sectors;
+    uint32_t runs;
+    double elapsed;
+} load_stats_t;
+
+
+static bool valid_cluster (fat_image_t *image, uint32_t cluster) {
+    return (cluster >= 2) && (cluster < (image->cluster_count + 2));
+}
+
+static bool load_chunked (fat_image_t *image, fat_window_t *window, uint8_t *cart, size_t size) {
+    uint32_t cluster_size = image->cluster_sectors * SECTOR_SIZE;
+    uint32_t cluster = image->file_cluster;
+    size_t offset = 0;
+
+    // NOTE: Same requests as FatFs f_read makes for each 128 kiB chunk,
+    //       a multi-sector read never crosses a cluster boundary.
+    while (offset < size) {
+        size_t end = offset + MIN(size - offset, LOAD_CHUNK_SIZE);
+        while (offset < end) {
+            if ((offset > 0) && ((offset % cluster_size) == 0)) {
+                cluster = fat_window_next(window, cluster);
+            }
+            if (!valid_cluster(image, cluster)) {
+                return true;
+            }
+            uint32_t cluster_sector = (offset % cluster_size) / SECTOR_SIZE;
+            uint32_t count = MIN((end - offset) / SECTOR_SIZE, image->cluster_sectors - cluster_sector);
+            if (fat_device_read(image, cart + offset, fat_cluster_sector(image, cluster) + cluster_sector, count)) {
+                return true;
+            }
+            offset += (count * SECTOR_SIZE);
+        }
+    }
+
+    return false;
+}
+
+static bool load_run (fat_image_t *image, uint8_t *cart, fat_run_t *run, uint32_t *loaded) {
+    while (run->count > 0) {
+        uint32_t transfer = MIN(run->count, LOAD_MAX_TRANSFER_SECTORS);
+        if (fat_device_read(image, cart + ((size_t) (*loaded) * SECTOR_SIZE), run->sector, transfer)) {
+            return true;
+        }
+        run->sector += transfer;
+        run->count -= transfer;
+        *loaded += transfer;
+    }
+
+    return false;
+}
+
+// NOTE: Each run is loaded as soon as the walk reaches its end, the chain is walked once whatever the fragment count
+static bool load_runs (fat_image_t *image, fat_window_t *window, uint8_t *cart, size_t size, load_stats_t *stats) {
+    uint32_t sector_count = size / SECTOR_SIZE;
+    uint32_t cluster = image->file_cluster;
+    fat_run_t pending = { 0 };
+    uint32_t loaded = 0;
+
+    for (uint32_t file_sector = 0; file_sector < sector_count; file_sector += image->cluster_sectors) {
+        if (file_sector > 0) {
+            cluster = fat_window_next(window, cluster);
+        }
+        if (!valid_cluster(image, cluster)) {
+            return true;
+        }
+        uint32_t sector = fat_cluster_sector(image, cluster);
+        uint32_t count = MIN(image->cluster_sectors, sector_count - file_sector);
+        if ((pending.count > 0) && ((pending.sector + pending.count) == sector)) {
+            pending.count += count;
+            continue;
+        }
+        if ((pending.count > 0) && load_run(image, cart, &pending, &loaded)) {
+            return true;
+        }
+        pending.sector = sector;
+        pending.count = count;
+        stats->runs += 1;
+    }
+
+    if (load_run(image, cart, &pending, &loaded)) {
+        return true;
+    }
+
+    return (loaded != sector_count);
+}
+
+static void run_load (fat_image_t *image, uint8_t *cart, bool use_runs, load_stats_t *stats) {
+    fat_window_t window;
+    size_t size = ALIGN(image->file_size, SECTOR_SIZE);
+
+    memset(stats, 0, sizeof(load_stats_t));
+    memset(cart, 0, size);
+    fat_image_reset_stats(image);
+    fat_window_init_span(&window, image, use_runs ? FAT_WALK_SECTORS : 1);
+
+    double start = time_now();
+    bool error = use_runs ? load_runs(image, &window, cart, size, stats) : load_chunked(image, &window, cart, size);
+    stats->elapsed = time_now() - start;
+
+    if (error) {
+        die("%s load failed", use_runs ? "run" : "chunked");
+    }
+    if (memcmp(cart, image->file_data, image->file_size) != 0) {
+        die("%s load produced wrong data", use_runs ? "run" : "chunked");
+    }
+
+    stats->commands = image->commands;
+    stats->fat_reads = window.reads;
+    stats->sectors = image->sectors_read;
+}
+
+static void print_stats (const char *name, load_stats_t *stats, uint32_t file_size, double overhead_us, double rate) {
+    double model = (stats->commands * overhead_us * 1e-6) + ((stats->sectors * SECTOR_SIZE) / (rate * 1e6));
+    char runs[16];
+
+    snprintf(runs, sizeof(runs), "%u", stats->runs);
+
+    printf("  %-8s runs %-8s  %7llu commands  %6llu FAT reads  model %8.1f ms %6.2f MB/s  host %7.2f ms\n",
+        name, stats->runs ? runs : "-",
+        (unsigned long long) (stats->commands), (unsigned long long) (stats->fat_reads),
+        model * 1e3, (file_size / 1e6) / model, stats->elapsed * 1e3
+    );
+}
+
+
+int cmd_bench_rom_load (int argc, char **argv) {
+    static const uint32_t default_fragments[] = { 1, 8, 64, 1024 };
+    uint32_t cluster_kib = 32;
+    uint32_t size_mib = 32;
+    double overhead_us = 200.0;
+    double rate = 20.0;
+
+    while ((argc >= 2) && (argv[0][0] == '-')) {
+        if (strcmp(argv[0], "-c") == 0) {
+            cluster_kib = atoi(argv[1]);
+        } else if (strcmp(argv[0], "-s") == 0) {
+            size_mib = atoi(argv[1]);
+        } else if (strcmp(argv[0], "-o") == 0) {
+            overhead_us = atof(argv[1]);
+        } else if (strcmp(argv[0], "-r") == 0) {
+            rate = atof(argv[1]);
+        } else {
+            break;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if ((cluster_kib == 0) || (cluster_kib > 64) || ((cluster_kib & (cluster_kib - 1)) != 0) || (size_mib == 0) || (size_mib > 64) || (rate <= 0.0)) {
+        fprintf(stderr, "usage: n64menu-tool bench-rom-load [-c cluster-kib] [-s size-mib] [-o command-us] [-r MB/s] [fragments...]\n");
+        return EXIT_FAILURE;
+    }
+
+    uint32_t fragment_count = (argc > 0) ? argc : (sizeof(default_fragments) / sizeof(default_fragments[0]));
+    uint8_t *cart = xmalloc(MiB(size_mib));
+
+    printf("%u MiB ROM, %u kiB clusters, model %.0f us per command at %.1f MB/s\n", size_mib, cluster_kib, overhead_us, rate);
+
+    for (uint32_t i = 0; i < fragment_count; i++) {
+        uint32_t fragments = (argc > 0) ? (uint32_t) (atoi(argv[i])) : default_fragments[i];
+        fat_image_t image;
+        load_stats_t chunked;
+        load_stats_t runs;
+
+        fat_image_create(&image, cluster_kib, MiB(size_mib), fragments, i + 1);
+
+        run_load(&image, cart, false, &chunked);
+        run_load(&image, cart, true, &runs);
+
+        printf("%u fragments:\n", fragments);
+        print_stats("chunked", &chunked, image.file_size, overhead_us, rate);
+        print_stats("runs", &runs, image.file_size, overhead_us, rate);
+
+        fat_image_free(&image);
+    }
+
+    free(cart);
+
+    return EXIT_SUCCESS;
+}
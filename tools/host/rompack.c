@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/menu/lz.h"
+#include "../../src/utils/rom_order.h"
+
+#include "artcodec.h"
+#include "commands.h"
+#include "common.h"
+#include "rompack.h"
+
+
+bool rom_pack_file_build (const uint8_t *rom, size_t rom_size, rom_pack_file_t *file) {
+    memset(file, 0, sizeof(rom_pack_file_t));
+
+    if ((rom_size == 0) || (rom_size > ROM_PACK_MAX_ROM_SIZE)) {
+        return true;
+    }
+
+    rom_pack_t *pack = &file->pack;
+    pack->rom_size = rom_size;
+    pack->block_count = (rom_size + ROM_PACK_BLOCK_SIZE - 1) >> ROM_PACK_BLOCK_SHIFT;
+    pack->data_offset = ROM_PACK_HEADER_SIZE + (pack->block_count * sizeof(uint32_t));
+
+    file->data = xmalloc(pack->data_offset + (pack->block_count * LZ_BOUND(ROM_PACK_BLOCK_SIZE)));
+    file->size = pack->data_offset;
+
+    for (uint32_t i = 0; i < pack->block_count; i++) {
+        const uint8_t *block = rom + ((size_t) (i) << ROM_PACK_BLOCK_SHIFT);
+        uint32_t block_size = rom_pack_block_size(pack, i);
+        uint8_t *p = file->data + file->size;
+        size_t stored_size = lz_compress(block, block_size, p, LZ_BOUND(ROM_PACK_BLOCK_SIZE));
+
+        // NOTE: The menu tells stored blocks apart by their size alone, a block that doesn't shrink is kept as-is
+        if ((stored_size == 0) || (stored_size >= block_size)) {
+            memcpy(p, block, block_size);
+            stored_size = block_size;
+        }
+
+        pack->stored_sizes[i] = stored_size;
+        put_u32(file->data + ROM_PACK_HEADER_SIZE + (i * sizeof(uint32_t)), stored_size);
+        file->size += stored_size;
+    }
+
+    put_u32(file->data, ROM_PACK_MAGIC);
+    put_u8(file->data + 4, ROM_PACK_VERSION);
+    put_u8(file->data + 5, ROM_PACK_BLOCK_SHIFT);
+    put_u16(file->data + 6, 0);
+    put_u32(file->data + 8, pack->rom_size);
+    put_u32(file->data + 12, pack->block_count);
+
+    return false;
+}
+
+void rom_pack_file_free (rom_pack_file_t *file) {
+    free(file->data);
+    memset(file, 0, sizeof(rom_pack_file_t));
+}
+
+bool rom_pack_file_decode (const uint8_t *data, size_t size, rom_pack_t *pack, uint8_t *rom) {
+    if (rom_pack_parse(data, size, pack)) {
+        return true;
+    }
+
+    size_t offset = pack->data_offset;
+
+    for (uint32_t i = 0; i < pack->block_count; i++) {
+        uint8_t *block = rom + ((size_t) (i) << ROM_PACK_BLOCK_SHIFT);
+        uint32_t block_size = rom_pack_block_size(pack, i);
+        uint32_t stored_size = pack->stored_sizes[i];
+
+        if (stored_size > (size - offset)) {
+            return true;
+        }
+        if (rom_pack_block_stored(pack, i)) {
+            memcpy(block, data + offset, block_size);
+        } else if (lz_decompress(data + offset, stored_size, block, block_size)) {
+            return true;
+        }
+        offset += stored_size;
+    }
+
+    return (offset != size);
+}
+
+bool rom_pack_file_head (const char *path, uint32_t *rom_size, uint8_t *head, size_t head_size) {
+    rom_pack_t pack;
+    uint8_t *index = xmalloc(ROM_PACK_MAX_INDEX_SIZE);
+    uint8_t *block = xmalloc(LZ_BOUND(ROM_PACK_BLOCK_SIZE) + ROM_PACK_BLOCK_SIZE);
+    uint8_t *decoded = block + LZ_BOUND(ROM_PACK_BLOCK_SIZE);
+    bool error = true;
+
+    FILE *f = fopen(path, "rb");
+    if (f != NULL) {
+        size_t index_size = fread(index, 1, ROM_PACK_MAX_INDEX_SIZE, f);
+        if (!rom_pack_parse(index, index_size, &pack) && (fseek(f, pack.data_offset, SEEK_SET) == 0)) {
+            uint32_t stored_size = pack.stored_sizes[0];
+            uint32_t block_size = rom_pack_block_size(&pack, 0);
+            if (fread(block, 1, stored_size, f) == stored_size) {
+                if (rom_pack_block_stored(&pack, 0)) {
+                    memcpy(decoded, block, block_size);
+                    error = false;
+                } else {
+                    error = lz_decompress(block, stored_size, decoded, block_size);
+                }
+            }
+            if (!error) {
+                *rom_size = pack.rom_size;
+                memcpy(head, decoded, MIN(head_size, block_size));
+            }
+        }
+        fclose(f);
+    }
+
+    free(block);
+    free(index);
+
+    return error;
+}
+
+
+static char *pack_path (const char *rom_path) {
+    const char *extension = strrchr(rom_path, '.');
+    const char *slash = strrchr(rom_path, '/');
+    int length = ((extension != NULL) && ((slash == NULL) || (extension > slash))) ? (extension - rom_path) : (int) (strlen(rom_path));
+
+    return path_printf("%.*s%s", length, rom_path, ROM_PACK_EXTENSION);
+}
+
+static bool read_rom (const char *path, uint8_t **rom, size_t *size) {
+    if (file_read_all(path, rom, size)) {
+        fprintf(stderr, "error: couldn't read %s\n", path);
+        return true;
+    }
+
+    rom_order_t order = (*size >= 4) ? rom_order_detect(*rom) : ROM_ORDER_UNKNOWN;
+    if ((order == ROM_ORDER_UNKNOWN) || ((order == ROM_ORDER_V64) && (*size % 2)) || ((order == ROM_ORDER_N64) && (*size % 4))) {
+        fprintf(stderr, "error: unrecognized N64 ROM byte order: %s\n", path);
+        free(*rom);
+        return true;
+    }
+    rom_order_convert(*rom, *size, order);
+
+    if ((*size == 0) || (*size > ROM_PACK_MAX_ROM_SIZE)) {
+        fprintf(stderr, "error: ROM doesn't fit the cartridge SDRAM below the flash backed areas: %s\n", path);
+        free(*rom);
+        return true;
+    }
+
+    return false;
+}
+
+
+int cmd_rom_pack (int argc, char **argv) {
+    if ((argc < 1) || (argc > 2)) {
+        fprintf(stderr, "usage: n64menu-tool rom-pack <rom> [out" ROM_PACK_EXTENSION "]\n");
+        return EXIT_FAILURE;
+    }
+
+    uint8_t *rom;
+    size_t rom_size;
+
+    if (read_rom(argv[0], &rom, &rom_size)) {
+        return EXIT_FAILURE;
+    }
+
+    char *path = (argc > 1) ? strdup(argv[1]) : pack_path(argv[0]);
+    rom_pack_file_t file;
+    uint8_t *decoded = xmalloc(rom_size);
+    rom_pack_t parsed;
+
+    double start = time_now();
+    if (rom_pack_file_build(rom, rom_size, &file)) {
+        die("couldn't build the container");
+    }
+    double elapsed = time_now() - start;
+
+    // NOTE: Every container is decoded back before it's written, the menu has no way to check the data
+    if (rom_pack_file_decode(file.data, file.size, &parsed, decoded) || (memcmp(decoded, rom, rom_size) != 0)) {
+        die("container doesn't decode back to the ROM");
+    }
+    if (file_write_all(path, file.data, file.size)) {
+        die("couldn't write %s", path);
+    }
+
+    uint32_t stored_blocks = 0;
+    for (uint32_t i = 0; i < file.pack.block_count; i++) {
+        stored_blocks += rom_pack_block_stored(&file.pack, i) ? 1 : 0;
+    }
+
+    printf("%s: %zu -> %zu bytes (%.1f%%), %u of %u blocks stored uncompressed, %.1f s\n", path, rom_size, file.size,
+        (file.size * 100.0) / rom_size, stored_blocks, file.pack.block_count, elapsed
+    );
+
+    free(decoded);
+    rom_pack_file_free(&file);
+    free(path);
+    free(rom);
+
+    return EXIT_SUCCESS;
+}
+
+int cmd_bench_rom_pack (int argc, char **argv) {
+    double sd_rate = 20.0;
+    double fatfs_rate = 0.0;
+    double decode_rate = 0.0;
+    int iterations = 4;
+
+    while (argc > 0) {
+        if ((strcmp(argv[0], "-r") == 0) && (argc > 1)) {
+            sd_rate = atof(argv[1]);
+        } else if ((strcmp(argv[0], "-f") == 0) && (argc > 1)) {
+            fatfs_rate = atof(argv[1]);
+        } else if ((strcmp(argv[0], "-d") == 0) && (argc > 1)) {
+            decode_rate = atof(argv[1]);
+        } else if ((strcmp(argv[0], "-i") == 0) && (argc > 1)) {
+            iterations = atoi(argv[1]);
+        } else {
+            break;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if ((argc < 1) || (sd_rate <= 0.0) || (iterations <= 0)) {
+        fprintf(stderr, "usage: n64menu-tool bench-rom-pack [-r sd-mb/s] [-f fatfs-mb/s] [-d decode-mb/s] [-i iterations] <rom...>\n");
+        return EXIT_FAILURE;
+    }
+    if (fatfs_rate <= 0.0) {
+        fatfs_rate = sd_rate;
+    }
+
+    bool error = false;
+
+    for (int i = 0; i < argc; i++) {
+        uint8_t *rom;
+        size_t rom_size;
+        if (read_rom(argv[i], &rom, &rom_size)) {
+            error = true;
+            continue;
+        }
+
+        rom_pack_file_t file;
+        rom_pack_t parsed;
+        uint8_t *decoded = xmalloc(rom_size);
+        if (rom_pack_file_build(rom, rom_size, &file)) {
+            die("couldn't build the container");
+        }
+
+        double start = time_now();
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            if (rom_pack_file_decode(file.data, file.size, &parsed, decoded)) {
+                die("container doesn't decode");
+            }
+        }
+        double host_rate = (rom_size * iterations) / ((time_now() - start) * 1e6);
+        if (memcmp(decoded, rom, rom_size) != 0) {
+            die("container doesn't decode back to the ROM");
+        }
+
+        // Only compressed blocks cost decode time, every block is read into RAM through FatFs
+        size_t compressed_bytes = 0;
+        size_t compressed_rom_bytes = 0;
+        for (uint32_t block = 0; block < file.pack.block_count; block++) {
+            if (!rom_pack_block_stored(&file.pack, block)) {
+                compressed_bytes += file.pack.stored_sizes[block];
+                compressed_rom_bytes += rom_pack_block_size(&file.pack, block);
+            }
+        }
+
+        double rate = (decode_rate > 0.0) ? decode_rate : host_rate;
+        double raw_seconds = rom_size / (sd_rate * 1e6);
+        double read_seconds = file.size / (fatfs_rate * 1e6);
+        double decode_seconds = compressed_rom_bytes / (rate * 1e6);
+        double saved_seconds = raw_seconds - read_seconds;
+
+        printf("%s\n", argv[i]);
+        printf("  container:   %zu of %zu bytes (%.1f%%), %zu bytes in compressed blocks\n", file.size, rom_size, (file.size * 100.0) / rom_size, compressed_bytes);
+        printf("  decode:      %.1f MB/s on the host%s\n", host_rate, (decode_rate > 0.0) ? ", model uses -d" : "");
+        printf("  raw load:    %.0f ms at %.1f MB/s\n", raw_seconds * 1e3, sd_rate);
+        printf("  packed load: %.0f ms read + %.0f ms decode = %.0f ms\n", read_seconds * 1e3, decode_seconds * 1e3, (read_seconds + decode_seconds) * 1e3);
+        if (saved_seconds > 0.0) {
+            printf("  break-even:  decode must exceed %.1f MB/s\n", compressed_rom_bytes / (saved_seconds * 1e6));
+        } else {
+            printf("  break-even:  none, the container reads no fewer bytes at these rates\n");
+        }
+
+        free(decoded);
+        rom_pack_file_free(&file);
+        free(rom);
+    }
+
+    return error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+#ifndef HOST_ROMPACK_H__
+#define HOST_ROMPACK_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../src/menu/rom_pack.h"
+
+
+/**
+ * @brief Container built in memory from a ROM in z64 byte order.
+ *
+ * Blocks that don't shrink are stored as-is. `data` holds the whole file: header, index and blocks.
+ */
+typedef struct {
+    rom_pack_t pack;
+    uint8_t *data;
+    size_t size;
+} rom_pack_file_t;
+
+
+bool rom_pack_file_build (const uint8_t *rom, size_t rom_size, rom_pack_file_t *file);
+void rom_pack_file_free (rom_pack_file_t *file);
+bool rom_pack_file_decode (const uint8_t *data, size_t size, rom_pack_t *pack, uint8_t *rom);
+bool rom_pack_file_head (const char *path, uint32_t *rom_size, uint8_t *head, size_t head_size);
+
+
+#endif
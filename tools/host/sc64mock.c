@@ -0,0 +1,346 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/flashcart/sc64/sc64_ll.h"
+
+#include "commands.h"
+#include "common.h"
+#include "fatimage.h"
+#include "pimock.h"
+
+
+#define REG_SR_CMD          (0x1FFF0000UL)
+#define REG_DATA_0          (0x1FFF0004UL)
+#define REG_DATA_1          (0x1FFF0008UL)
+#define REG_KEY             (0x1FFF0010UL)
+
+#define SR_CMD_ERROR        (1 << 30)
+#define SR_CPU_BUSY         (1 << 31)
+
+#define ROM_ADDRESS         (0x10000000UL)
+#define SDRAM_SIZE          MiB(64)
+
+// NOTE: Mirrors the menu loader, see src/flashcart/flashcart_utils.c
+#define LOAD_MAX_TRANSFER_SECTORS   (MiB(1) / SECTOR_SIZE)
+
+// Model of how long the cart stays busy, in status register reads
+#define SECTORS_PER_POLL    (16)
+
+
+static struct {
+    fat_image_t *image;
+    uint8_t *sdram;
+    bool old_firmware;
+    bool verbose;
+
+    uint32_t data[2];
+    uint32_t sr;
+    uint32_t busy_polls;
+    uint32_t sector;
+    bool sector_set;
+    bool byte_swap;
+
+    uint32_t commands;
+    uint32_t reads;
+    uint64_t polls;
+    uint32_t violations;
+} mock;
+
+
+static void violation (const char *fmt, ...) {
+    va_list args;
+
+    fprintf(stderr, "protocol violation: ");
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+
+    mock.violations += 1;
+}
+
+static void command_error (sc64_error_t error) {
+    mock.sr = SR_CMD_ERROR;
+    mock.data[0] = (uint32_t) (error);
+}
+
+static void command_sd_read (void) {
+    uint32_t address = mock.data[0];
+    uint32_t count = mock.data[1];
+
+    if (!mock.sector_set) {
+        violation("SD read issued without setting the sector first");
+    }
+    if ((address < ROM_ADDRESS) || ((address - ROM_ADDRESS) + ((uint64_t) (count) * SECTOR_SIZE) > SDRAM_SIZE) || (count == 0)) {
+        command_error(SC64_ERROR_BAD_ADDRESS);
+        return;
+    }
+
+    uint8_t *dst = mock.sdram + (address - ROM_ADDRESS);
+    if (fat_device_read(mock.image, dst, mock.sector, count)) {
+        command_error(SC64_ERROR_SD_CARD);
+        return;
+    }
+    if (mock.byte_swap) {
+        for (uint32_t i = 0; i < (count * SECTOR_SIZE); i += 2) {
+            uint8_t t = dst[i];
+            dst[i] = dst[i + 1];
+            dst[i + 1] = t;
+        }
+    }
+
+    mock.sector += count;
+    mock.sector_set = false;
+    mock.busy_polls = MAX(count / SECTORS_PER_POLL, 1);
+    mock.reads += 1;
+}
+
+static void command_execute (uint8_t id) {
+    mock.sr = 0;
+
+    // NOTE: Firmware without SD access still answers the status request, only with the card not initialized
+    if (mock.old_firmware && (id == 'i') && (mock.data[1] == SD_CARD_OP_GET_STATUS)) {
+        mock.data[1] = 0;
+        return;
+    }
+    if (mock.old_firmware && ((id == 'i') || (id == 'I') || (id == 's'))) {
+        command_error(SC64_ERROR_UNKNOWN_CMD);
+        return;
+    }
+
+    switch (id) {
+        case 'V':
+            mock.data[0] = (2 << 16) | 20;
+            mock.data[1] = 0;
+            break;
+
+        case 'c':
+        case 'C':
+            break;
+
+        case 'i':
+            switch (mock.data[1]) {
+                case SD_CARD_OP_GET_STATUS:
+                    mock.data[1] = 1;
+                    break;
+                case SD_CARD_OP_BYTE_SWAP_ON:
+                    mock.byte_swap = true;
+                    break;
+                case SD_CARD_OP_BYTE_SWAP_OFF:
+                    mock.byte_swap = false;
+                    break;
+                default:
+                    command_error(SC64_ERROR_BAD_ARGUMENT);
+                    break;
+            }
+            break;
+
+        case 'I':
+            mock.sector = mock.data[0];
+            mock.sector_set = true;
+            break;
+
+        case 's':
+            command_sd_read();
+            break;
+
+        default:
+            command_error(SC64_ERROR_UNKNOWN_CMD);
+            break;
+    }
+}
+
+
+uint32_t io_read (uint32_t address) {
+    switch (address) {
+        case REG_SR_CMD:
+            mock.polls += 1;
+            if (mock.busy_polls > 0) {
+                mock.busy_polls -= 1;
+                return (mock.sr | SR_CPU_BUSY);
+            }
+            return mock.sr;
+
+        case REG_DATA_0:
+        case REG_DATA_1:
+            if (mock.busy_polls > 0) {
+                violation("data register read while the cart is busy");
+            }
+            return mock.data[(address == REG_DATA_0) ? 0 : 1];
+
+        default:
+            violation("read of unknown register %08X", address);
+            return 0;
+    }
+}
+
+void io_write (uint32_t address, uint32_t value) {
+    if (mock.busy_polls > 0) {
+        violation("write of %08X to %08X while the cart is busy", value, address);
+    }
+
+    switch (address) {
+        case REG_DATA_0:
+            mock.data[0] = value;
+            break;
+
+        case REG_DATA_1:
+            mock.data[1] = value;
+            break;
+
+        case REG_SR_CMD:
+            if (mock.verbose) {
+                printf("  '%c' %08X %08X\n", (char) (value), mock.data[0], mock.data[1]);
+            }
+            mock.commands += 1;
+            command_execute(value & 0xFF);
+            break;
+
+        case REG_KEY:
+            break;
+
+        default:
+            violation("write of unknown register %08X", address);
+            break;
+    }
+}
+
+
+
+static bool load_runs (fat_run_t *runs, uint32_t run_count, uint32_t size, uint64_t *busy_progress) {
+    uint32_t sector_count = size / SECTOR_SIZE;
+    uint32_t loaded = 0;
+
+    for (uint32_t i = 0; (i < run_count) && (loaded < sector_count); i++) {
+        uint32_t sector = runs[i].sector;
+        uint32_t count = MIN(runs[i].count, sector_count - loaded);
+        while (count > 0) {
+            uint32_t length = MIN(count, LOAD_MAX_TRANSFER_SECTORS);
+            bool busy;
+            if (sc64_ll_sd_set_sector(sector) != SC64_OK) {
+                return true;
+            }
+            sc64_ll_sd_read_start((void *) (uintptr_t) (ROM_ADDRESS + (loaded * SECTOR_SIZE)), length);
+            do {
+                if (sc64_ll_poll(&busy) != SC64_OK) {
+                    return true;
+                }
+                if (busy) {
+                    *busy_progress += 1;
+                }
+            } while (busy);
+            sector += length;
+            count -= length;
+            loaded += length;
+        }
+    }
+
+    return (loaded != sector_count);
+}
+
+
+int cmd_mock_sc64_load (int argc, char **argv) {
+    uint32_t size_mib = 16;
+    uint32_t fragments = 8;
+    bool byte_swap = false;
+
+    memset(&mock, 0, sizeof(mock));
+
+    while (argc > 0) {
+        if (strcmp(argv[0], "-v") == 0) {
+            mock.verbose = true;
+        } else if (strcmp(argv[0], "--old-firmware") == 0) {
+            mock.old_firmware = true;
+        } else if (strcmp(argv[0], "--byteswap") == 0) {
+            byte_swap = true;
+        } else if ((strcmp(argv[0], "-s") == 0) && (argc > 1)) {
+            size_mib = atoi(argv[1]);
+            argc -= 1;
+            argv += 1;
+        } else if ((strcmp(argv[0], "-f") == 0) && (argc > 1)) {
+            fragments = atoi(argv[1]);
+            argc -= 1;
+            argv += 1;
+        } else {
+            break;
+        }
+        argc -= 1;
+        argv += 1;
+    }
+
+    if ((argc != 0) || (size_mib == 0) || (size_mib > 64)) {
+        fprintf(stderr, "usage: n64menu-tool mock-sc64-load [-v] [-s size-mib] [-f fragments] [--byteswap] [--old-firmware]\n");
+        return EXIT_FAILURE;
+    }
+
+    fat_image_t image;
+    fat_window_t window;
+    uint32_t run_count;
+    uint32_t size = MiB(size_mib);
+
+    fat_image_create(&image, 32, size, fragments, 1);
+    fat_window_init(&window, &image);
+
+    // NOTE: The menu issues each run as its walk reaches it, the mock only needs them up front to drive the same commands
+    fat_run_t *runs = xmalloc(image.cluster_count * sizeof(fat_run_t));
+    if (fat_file_runs(&window, size, runs, image.cluster_count, &run_count)) {
+        die("ROM cluster chain is broken");
+    }
+
+    mock.image = &image;
+    mock.sdram = xcalloc(1, SDRAM_SIZE);
+
+    // The SD load never goes through a RAM buffer, any PI write is a violation
+    pi_mock_reset(NULL);
+
+    uint32_t status;
+    if (!sc64_ll_sd_available()) {
+        printf("SD commands unavailable, the menu keeps the blocking libcart transfers\n");
+        free(runs);
+        free(mock.sdram);
+        fat_image_free(&image);
+        return ((mock.violations + pi_mock_violations()) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    uint64_t busy_progress = 0;
+    uint32_t setup_commands = mock.commands;
+
+    if (sc64_ll_sd_card_op(byte_swap ? SD_CARD_OP_BYTE_SWAP_ON : SD_CARD_OP_BYTE_SWAP_OFF, &status) != SC64_OK) {
+        die("byte swap request failed");
+    }
+    if (load_runs(runs, run_count, size, &busy_progress)) {
+        die("SD load failed");
+    }
+    if (byte_swap && (sc64_ll_sd_card_op(SD_CARD_OP_BYTE_SWAP_OFF, &status) != SC64_OK)) {
+        die("byte swap request failed");
+    }
+    if (mock.byte_swap) {
+        violation("byte swapping left enabled after the load");
+    }
+
+    bool data_ok = true;
+    for (uint32_t i = 0; i < size; i += 2) {
+        uint8_t expected_0 = image.file_data[byte_swap ? (i + 1) : i];
+        uint8_t expected_1 = image.file_data[byte_swap ? i : (i + 1)];
+        if ((mock.sdram[i] != expected_0) || (mock.sdram[i + 1] != expected_1)) {
+            data_ok = false;
+            break;
+        }
+    }
+
+    printf("%u MiB ROM in %u runs: %u commands (%u SD reads), %llu status polls, %llu progress calls while busy\n",
+        size_mib, run_count, mock.commands - setup_commands, mock.reads,
+        (unsigned long long) (mock.polls), (unsigned long long) (busy_progress)
+    );
+    mock.violations += pi_mock_violations();
+
+    printf("data %s, %u protocol violations\n", data_ok ? "OK" : "MISMATCH", mock.violations);
+
+    free(runs);
+    free(mock.sdram);
+    fat_image_free(&image);
+
+    return (data_ok && (mock.violations == 0)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,24 @@
+#ifndef HOST_SHA256_H__
+#define HOST_SHA256_H__
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define SHA256_DIGEST_SIZE  (32)
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;
+    uint8_t block[64];
+    size_t used;
+} sha256_t;
+
+
+void sha256_init (sha256_t *ctx);
+void sha256_update (sha256_t *ctx, const uint8_t *data, size_t size);
+void sha256_final (sha256_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+
+#endif
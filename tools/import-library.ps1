@@ -17,7 +17,6 @@ $ErrorActionPreference = "Stop"
 
 $RomExtensions = @(".n64", ".v64", ".z64")
 $ImageExtensions = @(".bmp", ".gif", ".jpeg", ".jpg", ".png", ".tif", ".tiff")
-$MaximumTitles = 40
 
 function Get-Directory([string]$Path, [string]$Name) {
     if ([string]::IsNullOrWhiteSpace($Path) -or -not [System.IO.Directory]::Exists($Path)) {
@@ -202,6 +201,69 @@ function Write-U16([byte[]]$Buffer, [int]$Offset, [int]$Value) {
     $Buffer[$Offset + 1] = [byte]($Value -band 0xFF)
 }
 
+function Write-U32([byte[]]$Buffer, [int]$Offset, [long]$Value) {
+    Write-U16 $Buffer $Offset (($Value -shr 16) -band 0xFFFF)
+    Write-U16 $Buffer ($Offset + 2) ($Value -band 0xFFFF)
+}
+
+function Get-LetterBucket([string]$Name) {
+    if ($Name.Length -gt 0) {
+        $letter = [int][char]::ToUpperInvariant($Name[0])
+        if ($letter -ge [int][char]'A' -and $letter -le [int][char]'Z') { return $letter - [int][char]'A' + 1 }
+    }
+    return 0
+}
+
+function Write-Catalog([string]$Path, $Titles) {
+    $headerSize = 32; $recordSize = 32; $columns = 4; $orderCount = 3; $letterCount = 27
+    if ($Titles.Count -gt 65535) { throw "The catalog is limited to 65535 titles." }
+    $names = [System.Collections.Generic.List[byte[]]]::new()
+    foreach ($title in $Titles) {
+        $name = [System.Text.Encoding]::ASCII.GetBytes($title.Name)
+        if ($name.Length -gt 63) { $name = [byte[]]$name[0..62] }
+        $names.Add($name)
+    }
+    $ordersOffset = $headerSize + ($Titles.Count * $recordSize)
+    $namesOffset = $ordersOffset + ((($Titles.Count * $orderCount) + $letterCount + 1) * 2)
+    $namesSize = 0
+    foreach ($name in $names) { $namesSize += $name.Length + 1 }
+    $catalog = [byte[]]::new([int]([Math]::Ceiling(($namesOffset + $namesSize) / 512) * 512))
+    Write-U32 $catalog 0 0x4E363443
+    Write-U16 $catalog 4 2; Write-U16 $catalog 6 $recordSize
+    Write-U32 $catalog 8 $Titles.Count; Write-U32 $catalog 12 $headerSize
+    $catalog[16] = $columns
+    Write-U32 $catalog 20 ([Math]::Ceiling($Titles.Count / $columns))
+    Write-U32 $catalog 24 $ordersOffset; Write-U32 $catalog 28 $namesOffset
+    $nameOffset = 0
+    for ($i = 0; $i -lt $Titles.Count; $i++) {
+        $record = $headerSize + ($i * $recordSize)
+        $id = [System.Text.Encoding]::ASCII.GetBytes($Titles[$i].Id)
+        [System.Array]::Copy($id, 0, $catalog, $record, $id.Length)
+        Write-U32 $catalog ($record + 8) $Titles[$i].RomSize
+        Write-U16 $catalog ($record + 20) ([Math]::Floor($i / $columns))
+        $catalog[$record + 22] = $i % $columns
+        $catalog[$record + 23] = 0xFF
+        Write-U32 $catalog ($record + 28) $nameOffset
+        [System.Array]::Copy($names[$i], 0, $catalog, $namesOffset + $nameOffset, $names[$i].Length)
+        $nameOffset += $names[$i].Length + 1
+    }
+    # Nothing has been played yet, the recent and most played orders start out as the name order
+    $byName = @(0..($Titles.Count - 1) | Sort-Object @{ Expression = { Get-LetterBucket $Titles[$_].Name } }, @{ Expression = { $Titles[$_].Name } }, @{ Expression = { $Titles[$_].Id } })
+    for ($order = 0; $order -lt $orderCount; $order++) {
+        for ($position = 0; $position -lt $byName.Count; $position++) {
+            Write-U16 $catalog ($ordersOffset + ((($order * $Titles.Count) + $position) * 2)) $byName[$position]
+        }
+    }
+    $letterStart = $ordersOffset + ($orderCount * $Titles.Count * 2)
+    $position = 0
+    for ($letter = 0; $letter -lt $letterCount; $letter++) {
+        while ($position -lt $byName.Count -and (Get-LetterBucket $Titles[$byName[$position]].Name) -lt $letter) { $position++ }
+        Write-U16 $catalog ($letterStart + ($letter * 2)) $position
+    }
+    Write-U16 $catalog ($letterStart + ($letterCount * 2)) $Titles.Count
+    [System.IO.File]::WriteAllBytes($Path, $catalog)
+}
+
 function Convert-Image([string]$Source, [string]$Destination) {
     Add-Type -AssemblyName System.Drawing
     $width = 256; $height = 179
@@ -275,7 +337,6 @@ $romRoot = Get-Directory $RomPath "-RomPath"
 $option = if ($Recursive) { [System.IO.SearchOption]::AllDirectories } else { [System.IO.SearchOption]::TopDirectoryOnly }
 $roms = @(Get-Files $romRoot $RomExtensions $option)
 if ($roms.Count -eq 0) { throw "No N64 ROMs were found." }
-if ($roms.Count -gt $MaximumTitles) { throw "n64menu supports at most $MaximumTitles titles." }
 
 $images = $null
 if (-not [string]::IsNullOrWhiteSpace($ImagePath)) {
@@ -292,6 +353,7 @@ $titleRoot = Join-Path $output "menu\title"
 $cacheRoot = Join-Path ([System.IO.Path]::GetTempPath()) "n64menu-boxart-cache"
 [System.IO.Directory]::CreateDirectory($titleRoot) | Out-Null
 $ids = [System.Collections.Generic.List[string]]::new()
+$titles = [System.Collections.Generic.List[object]]::new()
 foreach ($rom in $roms) {
     if ([System.IO.FileInfo]::new($rom).Length -gt (78 * 1024 * 1024)) { throw "ROM exceeds n64menu's 78 MiB limit: $rom" }
     $id = Get-RomId $rom
@@ -300,6 +362,9 @@ foreach ($rom in $roms) {
     $destination = Join-Path $titleRoot $id
     [System.IO.Directory]::CreateDirectory($destination) | Out-Null
     Copy-Rom $rom (Join-Path $destination "${id}_e.z64")
+    $name = [System.IO.Path]::GetFileNameWithoutExtension($rom)
+    [System.IO.File]::WriteAllText((Join-Path $destination "${id}_e.name"), $name)
+    $titles.Add([pscustomobject]@{ Id = $id; RomSize = [System.IO.FileInfo]::new($rom).Length; Name = $name })
 
     $artwork = Find-Artwork $rom $images $retroArchImages $cacheRoot
     if ($null -eq $artwork) {
@@ -313,8 +378,5 @@ foreach ($rom in $roms) {
     }
 }
 
-[System.IO.File]::WriteAllBytes(
-    (Join-Path $output "menu\title.csv"),
-    [System.Text.Encoding]::ASCII.GetBytes(($ids -join ",") + ",`0")
-)
+Write-Catalog (Join-Path $output "menu\catalog.bin") $titles
 Write-Host "Imported $($ids.Count) title(s) into $output"